@@ -0,0 +1,360 @@
+/*
+Zlib License
+--------------------------------------------------
+Copyright (c) 2021 migf1@hotmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+--------------------------------------------------
+*/
+
+/* ==================================
+ * Self-benchmark of MSUTimer
+ * ==================================
+ */
+// Measures how expensive MSUTimer itself is on the running box: the cost of
+// reading each clock source, the distribution of msutimer_accuracy_usecs(),
+// the cost of the median extraction against nrepeats, and the cost of the
+// histogram & sampled recording primitives. It ends with a comparison table
+// of the clock sources, to pick the right one for the platform.
+//
+// Build & run (from the root of the repository):
+// gcc -std=c99 -D_POSIX_C_SOURCE=199309L -O2 -Wall -Wextra -I. bench/msutimer_selfbench.c msutimer.c -o selfbench -pthread -lm
+// ./selfbench
+//
+// On Windows (MinGW): the same, without -pthread.
+// Define MSUT_SELFBENCH_N (e.g. -DMSUT_SELFBENCH_N=100000) for a quicker run.
+
+#include "msutimer.h"
+#include "msutimer_inline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Calls per measured loop
+#ifndef MSUT_SELFBENCH_N
+	#define MSUT_SELFBENCH_N	1000000
+#endif
+
+// msutimer_accuracy_usecs() calls per clock source
+#define ACCURACY_SAMPLES_	201
+
+// Results of a clock source, for the comparison table
+typedef struct ClockResult_ {
+	MSUTimerClock source;
+	bool supported;
+	double gettime_ns;		// msutimer_gettime()
+	double ticks_ns;		// msutimer_now_ticks()
+	double overhead_ns;		// msutimer_overhead_usecs()
+	double acc_min, acc_median, acc_max;	// msutimer_accuracy_usecs()
+	size_t acc_bogus;		// accuracy samples that are not positive
+} ClockResult_;
+
+static volatile uint64_t sink_;	// keeps the measured calls from being optimized away
+
+// ----------------------------------------
+static int compare_doubles_( const void *a, const void *b )
+{
+	double da = *(const double *)a, db = *(const double *)b;
+	return (da > db) - (da < db);
+}
+
+// ----------------------------------------
+// The clock read compiled into msutimer_inline_now_ticks() (mirrors its
+// branches), so that the inline figures cannot be silently mislabeled
+//
+static const char *inline_backend_( void )
+{
+	if ( MSUT_CLOCK_TSC == MSUT_DEFAULT_CLOCK ) {
+#if MSUT_INLINE_TSC_X86
+		return "rdtscp";
+#elif MSUT_INLINE_TSC_ARM64
+		return "mrs cntvct_el0";
+#else
+		return "msutimer_default_ticks() (out-of-line call)";
+#endif
+	}
+	if ( MSUT_CLOCK_PROCESS_CPU == MSUT_DEFAULT_CLOCK || MSUT_CLOCK_THREAD_CPU == MSUT_DEFAULT_CLOCK ) {
+#if MSUT_INLINE_WINDOWS
+		return (MSUT_CLOCK_PROCESS_CPU == MSUT_DEFAULT_CLOCK) ? "GetProcessTimes()" : "GetThreadTimes()";
+#elif defined(CLOCK_PROCESS_CPUTIME_ID) && defined(CLOCK_THREAD_CPUTIME_ID)
+		return (MSUT_CLOCK_PROCESS_CPU == MSUT_DEFAULT_CLOCK)
+			? "clock_gettime(CLOCK_PROCESS_CPUTIME_ID)"
+			: "clock_gettime(CLOCK_THREAD_CPUTIME_ID)";
+#else
+		return "msutimer_default_ticks() (out-of-line call)";
+#endif
+	}
+#if MSUT_INLINE_WINDOWS
+	if ( MSUT_CLOCK_REALTIME == MSUT_DEFAULT_CLOCK ) {
+		return "GetSystemTimeAsFileTime()";
+	}
+	if ( MSUT_CLOCK_PORTABLE != MSUT_DEFAULT_CLOCK ) {
+		return "QueryPerformanceCounter()";
+	}
+#elif MSUT_INLINE_APPLE
+	if ( MSUT_CLOCK_REALTIME == MSUT_DEFAULT_CLOCK ) {
+		return "gettimeofday()";
+	}
+	if ( MSUT_CLOCK_PORTABLE != MSUT_DEFAULT_CLOCK ) {
+		return "mach_absolute_time()";
+	}
+#elif MSUT_INLINE_POSIX
+	if ( MSUT_CLOCK_REALTIME == MSUT_DEFAULT_CLOCK ) {
+		return "gettimeofday()";
+	}
+	if ( MSUT_CLOCK_PORTABLE != MSUT_DEFAULT_CLOCK ) {
+	#ifdef CLOCK_MONOTONIC_RAW
+		if ( MSUT_CLOCK_MONOTONIC_RAW == MSUT_DEFAULT_CLOCK ) {
+			return "clock_gettime(CLOCK_MONOTONIC_RAW)";
+		}
+	#endif
+		return "clock_gettime(CLOCK_MONOTONIC)";
+	}
+#endif
+	return "clock()";
+}
+
+// ----------------------------------------
+// Nanoseconds per iteration of a loop, timed by the reference timer
+//
+static double ns_per_call_( MSUTimer *ref, uint64_t t1, size_t n )
+{
+	return msutimer_ticks_to_ns( ref, msutimer_now_ticks(ref) - t1 ) / (double)n;
+}
+
+// ----------------------------------------
+static void bench_clock_( MSUTimer *ref, ClockResult_ *res )
+{
+	MSUTimer *timer = msutimer_new_ex( res->source );
+	res->supported = (NULL != timer);
+	if ( !timer ) {
+		return;
+	}
+	// the CPU-time sources are costlier: fewer calls, to keep the run short
+	size_t n = (MSUT_CLOCK_PROCESS_CPU == res->source || MSUT_CLOCK_THREAD_CPU == res->source)
+		? MSUT_SELFBENCH_N / 10
+		: MSUT_SELFBENCH_N;
+	n = n ? n : 1;
+
+	uint64_t t1 = msutimer_now_ticks( ref );
+	for (size_t i=0; i < n; i++) {
+		msutimer_gettime( timer );
+	}
+	res->gettime_ns = ns_per_call_( ref, t1, n );
+
+	uint64_t acc = 0;
+	t1 = msutimer_now_ticks( ref );
+	for (size_t i=0; i < n; i++) {
+		acc += msutimer_now_ticks( timer );
+	}
+	res->ticks_ns = ns_per_call_( ref, t1, n );
+	sink_ = acc;
+
+	res->overhead_ns = 1000.0 * msutimer_overhead_usecs( timer );
+
+	double samples[ ACCURACY_SAMPLES_ ];
+	res->acc_bogus = 0;
+	for (size_t i=0; i < ACCURACY_SAMPLES_; i++) {
+		samples[i] = msutimer_accuracy_usecs( timer );
+		res->acc_bogus += !(samples[i] > 0.0);
+	}
+	qsort( samples, ACCURACY_SAMPLES_, sizeof(double), compare_doubles_ );
+	res->acc_min = samples[0];
+	res->acc_median = samples[ ACCURACY_SAMPLES_ / 2 ];
+	res->acc_max = samples[ ACCURACY_SAMPLES_ - 1 ];
+
+	msutimer_free( timer );
+}
+
+// ----------------------------------------
+static bool empty_cb_( void *userdata )
+{
+	(void)userdata;
+	return true;
+}
+
+// ----------------------------------------
+// Cost of msutimer_bench_median() per repeat (sampling + median extraction),
+// against that of msutimer_bench_average() (sampling only)
+//
+static void bench_median_( MSUTimer *ref )
+{
+	MSUTimer *timer = msutimer_new();
+	if ( !timer ) {
+		return;
+	}
+
+	puts( "\nmsutimer_bench_median() cost, empty callback" );
+	puts( "   nrepeats |   median ns/rep |  average ns/rep |    median extra" );
+	puts( "------------+-----------------+-----------------+----------------" );
+	size_t maxn = (MSUT_SELFBENCH_N < 100) ? 100 : MSUT_SELFBENCH_N;
+	for (size_t n = 100; n <= maxn; n *= 10) {
+		uint64_t t1 = msutimer_now_ticks( ref );
+		msutimer_bench_median( timer, n, empty_cb_, NULL, NULL );
+		double med = ns_per_call_( ref, t1, n );
+
+		t1 = msutimer_now_ticks( ref );
+		msutimer_bench_average( timer, n, empty_cb_, NULL, NULL );
+		double avg = ns_per_call_( ref, t1, n );
+
+		printf( "%11zu | %15.2f | %15.2f | %15.2f\n", n, med, avg, med - avg );
+	}
+	msutimer_free( timer );
+}
+
+// ----------------------------------------
+// Cost of the histogram & sampled recording primitives
+//
+static void bench_recording_( MSUTimer *ref )
+{
+	const size_t n = MSUT_SELFBENCH_N ? MSUT_SELFBENCH_N : 1;
+	MSUTimerHist *hist = msutimer_hist_new( 1000000.0, 3 );
+	MSUTimerGroup *group = msutimer_group_new( MSUT_CLOCK_DEFAULT, 1, 1000000.0, 3 );
+	MSUTimerSlot *slot = group ? msutimer_group_join( group ) : NULL;
+	if ( !hist || !slot ) {
+		puts( "\n(histograms not available)" );
+		msutimer_hist_free( hist );
+		msutimer_group_free( group );
+		return;
+	}
+
+	puts( "\nRecording cost" );
+	puts( "primitive                          |  ns/call" );
+	puts( "-----------------------------------+---------" );
+
+	uint64_t t1 = msutimer_now_ticks( ref );
+	for (size_t i=0; i < n; i++) {
+		msutimer_hist_record_ns( hist, (uint64_t)(i & 0xFFFFu) * 37u );
+	}
+	printf( "%-34s | %8.2f\n", "msutimer_hist_record_ns()", ns_per_call_(ref, t1, n) );
+
+	t1 = msutimer_now_ticks( ref );
+	for (size_t i=0; i < n; i++) {
+		msutimer_hist_record( hist, (double)(i & 0xFFFFu) * 0.037 );
+	}
+	printf( "%-34s | %8.2f\n", "msutimer_hist_record()", ns_per_call_(ref, t1, n) );
+
+	t1 = msutimer_now_ticks( ref );
+	for (size_t i=0; i < n; i++) {
+		msutimer_slot_begin( slot );
+		msutimer_slot_end( slot );
+	}
+	printf( "%-34s | %8.2f\n", "msutimer_slot_begin() + _end()", ns_per_call_(ref, t1, n) );
+
+	t1 = msutimer_now_ticks( ref );
+	for (size_t i=0; i < n; i++) {
+		uint64_t start = msutimer_inline_start();
+		sink_ = msutimer_inline_stop( start );
+	}
+	printf( "%-34s | %8.2f  (%s)\n", "msutimer_inline_start() + _stop()", ns_per_call_(ref, t1, n), inline_backend_() );
+
+	static const uint64_t periods[] = { 1, 100 };
+	for (size_t p=0; p < sizeof(periods) / sizeof(periods[0]); p++) {
+		MSUTimerSampler sampler;
+		if ( !msutimer_sampler_init( &sampler, periods[p], 0.0, 0, hist ) ) {
+			continue;
+		}
+		t1 = msutimer_now_ticks( ref );
+		for (size_t i=0; i < n; i++) {
+			msutimer_sample_begin( &sampler );
+			msutimer_sample_end( &sampler );
+		}
+		char label[64];
+		snprintf( label, sizeof(label), "msutimer_sample_*(), 1 in %llu", (unsigned long long)periods[p] );
+		printf( "%-34s | %8.2f\n", label, ns_per_call_(ref, t1, n) );
+	}
+
+	msutimer_hist_free( hist );
+	msutimer_group_free( group );
+}
+
+// ----------------------------------------
+static void print_clocks_( const ClockResult_ *res, size_t nres )
+{
+	puts( "\nClock sources" );
+	puts( "source          | gettime ns | ticks ns | overhead ns |  accuracy usecs (min / median / max) | bogus" );
+	puts( "----------------+------------+----------+-------------+--------------------------------------+------" );
+	for (size_t i=0; i < nres; i++) {
+		const ClockResult_ *r = &res[i];
+		if ( !r->supported ) {
+			printf( "%-15s | (not supported)\n", msutimer_clock_name(r->source) );
+			continue;
+		}
+		printf( "%-15s | %10.2f | %8.2f | %11.2f | %11.4f / %10.4f / %11.4f | %5zu%s\n",
+			msutimer_clock_name(r->source), r->gettime_ns, r->ticks_ns, r->overhead_ns,
+			r->acc_min, r->acc_median, r->acc_max, r->acc_bogus,
+			(r->acc_max > 10.0 * r->acc_min && r->acc_min > 0.0) ? "  (unstable)" : "" );
+	}
+
+	// the cheapest elapsed-time source resolving at least 1 microsecond
+	const ClockResult_ *best = NULL;
+	for (size_t i=0; i < nres; i++) {
+		const ClockResult_ *r = &res[i];
+		if ( !r->supported || 0 != r->acc_bogus || r->acc_median > 1.0
+		|| MSUT_CLOCK_DEFAULT == r->source || MSUT_CLOCK_REALTIME == r->source
+		|| MSUT_CLOCK_PORTABLE == r->source
+		|| MSUT_CLOCK_PROCESS_CPU == r->source || MSUT_CLOCK_THREAD_CPU == r->source ) {
+			continue;
+		}
+		if ( !best || r->ticks_ns < best->ticks_ns ) {
+			best = r;
+		}
+	}
+	if ( best ) {
+		char name[32];
+		size_t i;
+		for (i=0; i < sizeof(name) - 1 && msutimer_clock_name(best->source)[i]; i++) {
+			name[i] = (char) toupper( (unsigned char)msutimer_clock_name(best->source)[i] );
+		}
+		name[i] = '\0';
+		printf( "\nCheapest clock source with sub-microsecond resolution: %s\n", msutimer_clock_name(best->source) );
+		printf( "(compile msutimer.c with -DMSUT_DEFAULT_CLOCK=MSUT_CLOCK_%s to make it the default)\n", name );
+	}
+	else {
+		puts( "\nNo elapsed-time clock source with sub-microsecond resolution on this box." );
+	}
+}
+
+// ----------------------------------------
+int main( void )
+{
+	MSUTimer *ref = msutimer_new();		// the reference for all the measurements
+	if ( !ref ) {
+		fputs( "*** cannot create the reference timer\n", stderr );
+		return EXIT_FAILURE;
+	}
+	printf( "MSUTimer self-benchmark: %d calls per loop, reference clock: %s, inline clock read: %s\n",
+		MSUT_SELFBENCH_N, msutimer_clock_name(msutimer_clock(ref)), inline_backend_() );
+
+	ClockResult_ res[ MSUT_NCLOCKS ];
+	size_t nres = 0;
+	for (int c = MSUT_CLOCK_DEFAULT; c < MSUT_NCLOCKS; c++) {
+		memset( &res[nres], 0, sizeof(res[nres]) );
+		res[nres].source = (MSUTimerClock) c;
+		bench_clock_( ref, &res[nres] );
+		nres++;
+	}
+
+	bench_median_( ref );
+	bench_recording_( ref );
+	print_clocks_( res, nres );
+
+	msutimer_free( ref );
+	return EXIT_SUCCESS;
+}
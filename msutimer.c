@@ -33,6 +33,10 @@ freely, subject to the following restrictions:
 //
 // Release build:
 // gcc -std=c99 -O2 --Wall -Wextra -c msutimer.c -o msutimer.o
+//
+// Linking (POSIX): add -pthread -lm, plus -D_POSIX_C_SOURCE=199309L if
+// main.c includes msutimer_inline.h, e.g.
+// gcc -std=c99 -D_POSIX_C_SOURCE=199309L -O2 main.c msutimer.o -o main -pthread -lm
 
 /*
  Refs:
@@ -42,6 +46,12 @@ freely, subject to the following restrictions:
  https://stackoverflow.com/questions/5248915/execution-time-of-c-program/5249028
  */
 
+// POSIX.1-2008 for clock_gettime(), plus GNU extensions for CPU affinity,
+// when compiled with -std=c99 (must precede all includes)
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE
+#endif
+
 #include "msutimer.h"
 
 #include <stdio.h>		// for debug messages
@@ -49,13 +59,16 @@ freely, subject to the following restrictions:
 
 #include <string.h>		// memset(), etc
 #include <stdbool.h>	// C99: bool, true, false
+#include <stdint.h>		// C99: uint64_t, etc
 #include <time.h>		// clock(), CLOCKS_PER_SEC, etc
 #include <float.h>		// DBL_MAX, etc
+#include <limits.h>		// INT_MAX, etc
 #include <math.h>		// fabs(), etc
 #include <errno.h>
+#include <stdarg.h>		// va_list, for the result serializers
 
 // Platform detection
-#if defined(__WIN32)
+#if defined(__WIN32) || defined(_WIN32)
 	#define MSUT_OS_WINDOWS 1
 #elif defined(__unix__) || defined (__linux__) || (defined(__APPLE__) && defined(__MACH__))
 	#define MSUT_OS_POSIX 1
@@ -67,28 +80,305 @@ freely, subject to the following restrictions:
 // #define MSUT_OS_WINDOWS 0
 // #define MSUT_OS_POSIX 0
 
-// cross-platform data-type for time
+// platform clock APIs
 #if MSUT_OS_WINDOWS
 	#define WIN32_LEAN_AND_MEAN
-	#include <windows.h>	// for LARGE_INTEGER, QueryPerformanceCounter(), QueryPerformanceFrequency()
-	typedef LARGE_INTEGER MSUTimerTime;		// https://docs.microsoft.com/en-us/windows/win32/api/winnt/ns-winnt-large_integer-r1
+	#include <windows.h>	// for QueryPerformanceCounter(), QueryPerformanceFrequency(), GetSystemTimeAsFileTime()
+	#include <psapi.h>		// for GetProcessMemoryInfo()
 
 #elif MSUT_OS_POSIX
 	#include <sys/time.h>	// for struct timeval, gettimeofday(), etc
-	typedef struct timeval MSUTimerTime;	// { long int tv_sec, long int tv_usec}
+	#include <pthread.h>	// for pthread_create(), pthread_join()
+	#include <sched.h>		// for sched_setaffinity(), sched_yield()
+	#include <sys/mman.h>	// for mmap(), munmap()
+	#include <sys/stat.h>	// for fstat()
+	#include <fcntl.h>		// for open()
+	#include <unistd.h>		// for ftruncate(), close()
+	#include <sys/resource.h>	// for getpriority(), setpriority(), getrusage()
+	#if defined(__linux__) && !defined(MSUT_NO_PERF)
+		#include <linux/perf_event.h>	// for struct perf_event_attr, perf_event_mmap_page
+		#include <sys/syscall.h>		// for syscall(), SYS_perf_event_open
+		#define MSUT_HAS_PERF 1
+	#endif
+	#if defined(__APPLE__) && defined(__MACH__)
+		#include <mach/mach_time.h>	// for mach_absolute_time(), mach_timebase_info()
+		#define MSUT_OS_APPLE 1
+	#endif
+#endif
+
+// CPU cycle-counter (MSUT_CLOCK_TSC) support
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+	#include <x86intrin.h>	// for __rdtscp(), _mm_lfence()
+	#include <cpuid.h>		// for __get_cpuid()
+	#define MSUT_HAS_TSC 1
+	#define MSUT_ARCH_X86 1
+#elif (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER)
+	#include <intrin.h>		// for __rdtscp(), _mm_lfence(), __cpuid()
+	#define MSUT_HAS_TSC 1
+	#define MSUT_ARCH_X86 1
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+	#define MSUT_HAS_TSC 1
+	#define MSUT_ARCH_ARM64 1
+#endif
+
+// msutimer_bench_auto(): a batch must last at least that many times the timer
+// accuracy, and it never grows beyond MSUT_AUTO_MAX_BATCH calls
+#ifndef MSUT_AUTO_ACCURACY_FACTOR
+	#define MSUT_AUTO_ACCURACY_FACTOR	100
+#endif
+#ifndef MSUT_AUTO_MAX_BATCH
+	#define MSUT_AUTO_MAX_BATCH			((size_t)1 << 30)
+#endif
+
+// msutimer_bench_for(): the clock is read once per batch of calls, and a batch
+// grows until it lasts about 1/MSUT_FOR_CHECK_FRACTION of the time budget
+#ifndef MSUT_FOR_CHECK_FRACTION
+	#define MSUT_FOR_CHECK_FRACTION		64
+#endif
+
+// Number of empty timed regions sampled for the timer overhead calibration
+#ifndef MSUT_OVERHEAD_SAMPLES
+	#define MSUT_OVERHEAD_SAMPLES	101
+#endif
+
+// Minimum duration of the MSUT_CLOCK_TSC frequency calibration
+#ifndef MSUT_TSC_CALIBRATION_USECS
+	#define MSUT_TSC_CALIBRATION_USECS	10000
+#endif
+
+// Cache-line size, for keeping per-thread data from sharing cache lines
+#ifndef MSUT_CACHELINE
+	#define MSUT_CACHELINE	64
+#endif
+
+// Atomic operations on int64_t, used only outside the hot paths (e.g. for
+// claiming per-thread slots). Without compiler support they are plain
+// operations, and the callers document that they are not thread-safe.
+#if defined(__GNUC__) || defined(__clang__)
+	#define MSUT_ATOMIC_FETCH_ADD_( p, v )	__atomic_fetch_add( (p), (v), __ATOMIC_ACQ_REL )
+#elif defined(_MSC_VER)
+	#define MSUT_ATOMIC_FETCH_ADD_( p, v )	InterlockedExchangeAdd64( (volatile LONG64 *)(p), (v) )
+#else
+	static inline int64_t msut_fetch_add_( int64_t *p, int64_t v ) { int64_t old = *p; *p += v; return old; }
+	#define MSUT_ATOMIC_FETCH_ADD_( p, v )	msut_fetch_add_( (p), (v) )
+#endif
+
+// Atomic load & store of int64_t (acquire/release), e.g. for spin barriers
+#if defined(__GNUC__) || defined(__clang__)
+	#define MSUT_ATOMIC_LOAD_( p )			__atomic_load_n( (p), __ATOMIC_ACQUIRE )
+	#define MSUT_ATOMIC_STORE_( p, v )		__atomic_store_n( (p), (v), __ATOMIC_RELEASE )
+#elif defined(_MSC_VER)
+	#define MSUT_ATOMIC_LOAD_( p )			InterlockedCompareExchange64( (volatile LONG64 *)(p), 0, 0 )
+	#define MSUT_ATOMIC_STORE_( p, v )		InterlockedExchange64( (volatile LONG64 *)(p), (v) )
+#else
+	#define MSUT_ATOMIC_LOAD_( p )			(*(volatile int64_t *)(p))
+	#define MSUT_ATOMIC_STORE_( p, v )		(*(volatile int64_t *)(p) = (v))
+#endif
+
+// Atomic compare-and-swap of int64_t (acq_rel), returning true on success, e.g. for spin locks
+#if defined(__GNUC__) || defined(__clang__)
+	#define MSUT_ATOMIC_CAS_( p, expected, desired )	msut_cas_( (p), (expected), (desired) )
+	static inline bool msut_cas_( int64_t *p, int64_t expected, int64_t desired ) {
+		return __atomic_compare_exchange_n( p, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+	}
+#elif defined(_MSC_VER)
+	#define MSUT_ATOMIC_CAS_( p, expected, desired )	\
+		((expected) == InterlockedCompareExchange64( (volatile LONG64 *)(p), (desired), (expected) ))
+#else
+	static inline bool msut_cas_( int64_t *p, int64_t expected, int64_t desired ) {
+		if ( *p != expected ) return false;
+		*p = desired;
+		return true;
+	}
+	#define MSUT_ATOMIC_CAS_( p, expected, desired )	msut_cas_( (p), (expected), (desired) )
+#endif
+
+// Thread-local storage (used by the event trace)
+#if defined(__GNUC__) || defined(__clang__)
+	#define MSUT_THREAD_LOCAL_	__thread
+#elif defined(_MSC_VER)
+	#define MSUT_THREAD_LOCAL_	__declspec(thread)
+#endif
+
+// Event trace: how often the background thread flushes the ring buffers
+#ifndef MSUT_TRACE_FLUSH_USECS
+	#define MSUT_TRACE_FLUSH_USECS	10000
+#endif
 
-#else	// fallback
-	// NOTE: clock() may wraparound as often as every 35 mins (implementation defined)
-	typedef clock_t MSUTimerTime;			// typically a long int
+// Named zones (see MSUT_ZONE_BEGIN() in msutimer_inline.h): the layout of the
+// histograms of MSUT_ZONES=2
+#ifndef MSUT_ZONE_HIST_MAX_USECS
+	#define MSUT_ZONE_HIST_MAX_USECS	10000000.0
+#endif
+#ifndef MSUT_ZONE_HIST_SIGDIGITS
+	#define MSUT_ZONE_HIST_SIGDIGITS	2
+#endif
+
+// Binary sample logs: the mapped file grows by at least that many bytes at a time
+#ifndef MSUT_LOG_CHUNK
+	#define MSUT_LOG_CHUNK	((size_t)1 << 20)
+#endif
+
+// msutimer_bench_compare(): number of bootstrap resamples for the confidence interval
+#ifndef MSUT_BOOTSTRAP_RESAMPLES
+	#define MSUT_BOOTSTRAP_RESAMPLES	2000
+#endif
+
+// msutimer_env_setup(): the nice value to raise the priority to (POSIX)
+#ifndef MSUT_ENV_NICE
+	#define MSUT_ENV_NICE	-10
+#endif
+
+// Sampled timing: timed calls per re-estimation of the period, and its maximum
+#ifndef MSUT_SAMPLE_ADAPT_WINDOW
+	#define MSUT_SAMPLE_ADAPT_WINDOW	64
+#endif
+#ifndef MSUT_SAMPLE_MAX_PERIOD
+	#define MSUT_SAMPLE_MAX_PERIOD		1048576
+#endif
+
+// Threads (used by the multi-threaded benchmark driver)
+#if MSUT_OS_WINDOWS
+	typedef HANDLE MSUTimerThread_;
+	#define MSUT_HAS_THREADS 1
+#elif MSUT_OS_POSIX
+	typedef pthread_t MSUTimerThread_;
+	#define MSUT_HAS_THREADS 1
 #endif
 
+// cross-platform data-type for time: raw ticks of the timer's clock source.
+// Their frequency is stored in MSUTimer->freq (e.g. 1000000000 for clock_gettime()
+// nanoseconds, 1000000 for gettimeofday() microseconds, CLOCKS_PER_SEC for clock()).
+// NOTE: clock() may wraparound as often as every 35 mins (implementation defined)
+typedef uint64_t MSUTimerTime;
+
 // Cross platform MSUTimer data-type
+// Hardware performance counters (see msutimer_perf_enable())
+typedef struct MSUTimerPerf_ MSUTimerPerf_;
+
+// Memory allocations of the timed windows (see msutimer_alloc_enable())
+typedef struct MSUTimerAlloc_ {
+	bool enabled;
+	uint64_t allocs, frees, bytes;	// accumulated over the timed windows
+	uint64_t ncalls;				// calls of the callback in the timed windows
+	int64_t rss0;					// peak RSS at the start of the run (-1: unknown)
+} MSUTimerAlloc_;
+
+// Thread state changed by msutimer_env_setup(), to be restored by msutimer_env_restore()
+typedef struct MSUTimerEnvSaved_ {
+	bool affinity;			// was the affinity changed?
+	bool priority;			// was the priority changed?
+#if MSUT_OS_WINDOWS
+	DWORD_PTR mask;
+	int winprio;
+#elif MSUT_OS_POSIX
+	#if defined(__linux__)
+	cpu_set_t set;
+	#endif
+	int nice;
+#endif
+} MSUTimerEnvSaved_;
+
 typedef struct MSUTimer_ {
-	MSUTimerTime freq;	// ticks per sec
-	MSUTimerTime t1;	// ticks of starting time
+	MSUTimerClock source;	// clock source (never MSUT_CLOCK_DEFAULT)
+	MSUTimerTime freq;		// ticks per sec
+	double usecs_per_tick;	// precomputed conversion factor (1000000.0 / freq, or exact where known)
+	double nsecs_per_tick;	// precomputed conversion factor (1000 * usecs_per_tick)
+	MSUTimerTime t1;		// ticks of starting time
 	double diffusecs;
+	double overhead_ticks;	// median cost of an empty timed region (calibrated once per source)
+	double resolution_usecs;	// smallest observable time step (measured once per source)
+	bool subtract_overhead;	// subtract overhead_ticks from bench samples?
+	double *samples;		// reserved, pre-faulted sample buffer (see msutimer_reserve_samples())
+	size_t nsamples;		// capacity of samples
+	size_t warmup_iters;	// warm-up: at least that many iterations...
+	double warmup_usecs;	// ...and at least that long
+	size_t steady_window;	// steady-state detection: sliding window (0: disabled)...
+	double steady_cv;		// ...coefficient of variation to reach...
+	double steady_usecs;	// ...within that time budget
+	size_t nwarmup;			// warm-up iterations of the latest bench run
+	bool steady;			// did the latest bench run reach steady-state?
+	MSUTimerLog *log;		// attached binary sample log, or NULL
+	MSUTimerPerf_ *perf;	// hardware performance counters, or NULL
+	MSUTimerAlloc_ alloc;	// memory allocation tracking
+	MSUTimerEnv env;		// bench environment (see msutimer_env_setup())
+	MSUTimerEnvSaved_ envsaved;
+	bool paused;			// inside msutimer_pause() / msutimer_resume()?
+	MSUTimerTime pause_t1;	// ticks of the latest msutimer_pause()
+	MSUTimerTime paused_ticks;	// paused ticks of the current bench sample
+	int origin;				// MSUT_ORIGIN_HEAP_, MSUT_ORIGIN_USER_ or MSUT_ORIGIN_POOL_
+	MSUTimerPool *pool;		// owning pool (MSUT_ORIGIN_POOL_ only)
+	MSUTimer *next_free;	// next timer in the free-list of the pool
 } MSUTimer;
 
+// Where the storage of a timer comes from, to be released by msutimer_free()
+enum {
+	MSUT_ORIGIN_HEAP_ = 0,	// msutimer_new_ex()
+	MSUT_ORIGIN_USER_,		// msutimer_init()
+	MSUT_ORIGIN_POOL_		// msutimer_pool_acquire()
+};
+
+// MSUT_TIMER_SIZE (public) must be able to hold an MSUTimer
+typedef char msut_timer_size_check_[ sizeof(MSUTimer) <= MSUT_TIMER_SIZE ? 1 : -1 ];
+
+// Log-linear (HDR-style) histogram of nanosecond values, from 1 up to highest.
+// Values are grouped in buckets of powers of 2, each one split linearly into
+// sub-buckets, so that every value is tracked with sigdigits decimal digits of
+// precision. Bucket 0 holds sub_count sub-buckets, all the others only their
+// upper half (their lower half overlaps the previous bucket).
+typedef struct MSUTimerHist_ {
+	int sigdigits;
+	uint64_t highest;		// highest trackable value
+	int sub_half_mag;		// log2 of sub_half
+	uint64_t sub_count;		// sub-buckets per bucket
+	uint64_t sub_half;		// sub_count / 2
+	uint64_t sub_mask;		// sub_count - 1
+	size_t ncounts;			// length of counts[]
+	uint64_t total;			// number of recorded values
+	uint64_t min;			// exact smallest recorded value
+	uint64_t max;			// exact largest recorded value
+	double sum;				// exact sum of recorded values
+	uint64_t counts[];		// C99 flexible array member
+} MSUTimerHist;
+
+// Per-thread slot of an MSUTimerGroup, padded to whole cache-lines so that
+// slots of different threads never share one.
+typedef struct MSUTimerSlotData_ {
+	MSUTimerClock source;	// copied from the group's timer, to stay in one cache-line
+	double nsecs_per_tick;
+	MSUTimerTime t1;		// ticks of the latest msutimer_slot_begin()
+	MSUTimerHist *hist;		// values recorded by the owning thread
+} MSUTimerSlotData_;
+
+typedef union MSUTimerSlot_ {
+	MSUTimerSlotData_ d;
+	unsigned char pad[ ((sizeof(MSUTimerSlotData_) + MSUT_CACHELINE - 1) / MSUT_CACHELINE) * MSUT_CACHELINE ];
+} MSUTimerSlot;
+
+// Group of per-thread slots, sharing a clock source and a histogram layout
+typedef struct MSUTimerGroup_ {
+	MSUTimer *timer;		// the clock source and its conversion factors
+	double max_usecs;		// histogram range (for msutimer_group_hist_new())
+	int sigdigits;			// histogram precision
+	size_t nslots;
+	int64_t njoined;		// atomically incremented by msutimer_group_join()
+	void *mem;				// unaligned allocation holding the slots
+	MSUTimerSlot *slots;	// cache-line aligned
+} MSUTimerGroup;
+
+// Pool of preallocated timers, each one in its own whole cache-lines
+struct MSUTimerPool_ {
+	MSUTimerClock source;	// of the acquired timers
+	size_t ntimers;
+	size_t nfree;
+	int64_t lock;			// spin lock, guarding free & nfree
+	MSUTimer *free;			// free-list (linked through next_free)
+	void *mem;				// unaligned allocation holding the timers
+	unsigned char *timers;	// cache-line aligned, MSUT_POOL_STRIDE_ bytes apart
+};
+
+#define MSUT_POOL_STRIDE_	(((sizeof(MSUTimer) + MSUT_CACHELINE - 1) / MSUT_CACHELINE) * MSUT_CACHELINE)
+
 // debugging compiler flag (MSDEBUG added for consistency with MyStr
 #if MSUTDEBUG == 1 || MSDEBUG == 1
 	#define MSUT_DBGMSG( msgtype, format, ... )\
@@ -111,60 +401,331 @@ typedef struct MSUTimer_ {
  */
 
 // ----------------------------------------
-// Get current time as cross-platform MSUTimerTime.
+// Map MSUT_CLOCK_DEFAULT (and sources the platform merely aliases) to the
+// clock source that actually gets read. Return MSUT_NCLOCKS if unsupported.
+//
+static MSUTimerClock resolve_clock_( MSUTimerClock source )
+{
+	if ( MSUT_CLOCK_DEFAULT == source ) {
+#if MSUT_OS_WINDOWS || MSUT_OS_POSIX
+		source = MSUT_DEFAULT_CLOCK;
+#else
+		source = MSUT_CLOCK_PORTABLE;
+#endif
+	}
+
+	switch ( source ) {
+#if MSUT_OS_WINDOWS || MSUT_OS_POSIX
+		case MSUT_CLOCK_MONOTONIC:
+		case MSUT_CLOCK_REALTIME:
+			return source;
+		case MSUT_CLOCK_MONOTONIC_RAW:
+	#if MSUT_OS_POSIX && defined(CLOCK_MONOTONIC_RAW) && !MSUT_OS_APPLE
+			return source;
+	#else
+			return MSUT_CLOCK_MONOTONIC;
+	#endif
+#endif
+		case MSUT_CLOCK_PORTABLE:
+			return source;
+#if MSUT_HAS_TSC
+		case MSUT_CLOCK_TSC:
+			return source;	// the CPU gets checked by get_tscfreq_()
+#endif
+#if MSUT_OS_WINDOWS || (MSUT_OS_POSIX && defined(CLOCK_PROCESS_CPUTIME_ID))
+		case MSUT_CLOCK_PROCESS_CPU:
+			return source;
+#endif
+#if MSUT_OS_WINDOWS || (MSUT_OS_POSIX && defined(CLOCK_THREAD_CPUTIME_ID))
+		case MSUT_CLOCK_THREAD_CPU:
+			return source;
+#endif
+		default:
+			return MSUT_NCLOCKS;
+	}
+}
+
+// ----------------------------------------
+// Read the CPU cycle-counter. The fences keep the read from being reordered
+// with the instructions around it: rdtscp waits for all previous instructions
+// to execute, and lfence keeps the following ones from starting before it.
+//
+#if MSUT_HAS_TSC
+static inline MSUTimerTime read_tsc_( void )
+{
+#if MSUT_ARCH_X86
+	unsigned int aux;
+	MSUTimerTime t = __rdtscp( &aux );
+	_mm_lfence();
+	return t;
+
+#else	// MSUT_ARCH_ARM64
+	MSUTimerTime t;
+	__asm__ __volatile__( "isb\n\tmrs %0, cntvct_el0" : "=r"(t) :: "memory" );
+	return t;
+#endif
+}
+#endif
+
+// ----------------------------------------
+// Get current time as cross-platform MSUTimerTime, from a resolved clock source.
 // Return false on error, true otherwise
 //
-static inline bool get_msuttime_( MSUTimerTime *t )
+static inline bool get_msuttime_( MSUTimerClock source, MSUTimerTime *t )
 {
+	switch ( source ) {
 #if MSUT_OS_WINDOWS
-	return 0 != QueryPerformanceCounter( t );
+		case MSUT_CLOCK_MONOTONIC: {
+			LARGE_INTEGER li;
+			if ( 0 == QueryPerformanceCounter( &li ) ) {
+				return false;
+			}
+			*t = (MSUTimerTime) li.QuadPart;
+			return true;
+		}
+		case MSUT_CLOCK_REALTIME: {
+			FILETIME ft;
+			GetSystemTimeAsFileTime( &ft );
+			*t = ((MSUTimerTime)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+			return true;
+		}
+		case MSUT_CLOCK_PROCESS_CPU:
+		case MSUT_CLOCK_THREAD_CPU: {
+			// kernel + user time, in 100-nanosecond intervals
+			FILETIME created, ended, kernel, user;
+			BOOL ok = (MSUT_CLOCK_PROCESS_CPU == source)
+				? GetProcessTimes( GetCurrentProcess(), &created, &ended, &kernel, &user )
+				: GetThreadTimes( GetCurrentThread(), &created, &ended, &kernel, &user );
+			if ( !ok ) {
+				return false;
+			}
+			*t = (((MSUTimerTime)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime)
+				+ (((MSUTimerTime)user.dwHighDateTime << 32) | user.dwLowDateTime);
+			return true;
+		}
 
 #elif MSUT_OS_POSIX
-	return -1 != gettimeofday( t, NULL );
-
-#else	// fallback
-	*t = clock();
-	return (clock_t)(-1) != *t;
+		case MSUT_CLOCK_MONOTONIC:
+	#if MSUT_OS_APPLE
+			*t = mach_absolute_time();
+			return true;
+	#else
+		{
+			struct timespec ts;
+			if ( -1 == clock_gettime( CLOCK_MONOTONIC, &ts ) ) {
+				return false;
+			}
+			*t = (MSUTimerTime)ts.tv_sec * 1000000000u + (MSUTimerTime)ts.tv_nsec;
+			return true;
+		}
+	#endif
+	#if MSUT_OS_POSIX && defined(CLOCK_MONOTONIC_RAW) && !MSUT_OS_APPLE
+		case MSUT_CLOCK_MONOTONIC_RAW: {
+			struct timespec ts;
+			if ( -1 == clock_gettime( CLOCK_MONOTONIC_RAW, &ts ) ) {
+				return false;
+			}
+			*t = (MSUTimerTime)ts.tv_sec * 1000000000u + (MSUTimerTime)ts.tv_nsec;
+			return true;
+		}
+	#endif
+		case MSUT_CLOCK_REALTIME: {
+			struct timeval tv;
+			if ( -1 == gettimeofday( &tv, NULL ) ) {
+				return false;
+			}
+			*t = (MSUTimerTime)tv.tv_sec * 1000000u + (MSUTimerTime)tv.tv_usec;
+			return true;
+		}
+	#if defined(CLOCK_PROCESS_CPUTIME_ID)
+		case MSUT_CLOCK_PROCESS_CPU: {
+			struct timespec ts;
+			if ( -1 == clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &ts ) ) {
+				return false;
+			}
+			*t = (MSUTimerTime)ts.tv_sec * 1000000000u + (MSUTimerTime)ts.tv_nsec;
+			return true;
+		}
+	#endif
+	#if defined(CLOCK_THREAD_CPUTIME_ID)
+		case MSUT_CLOCK_THREAD_CPU: {
+			struct timespec ts;
+			if ( -1 == clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) ) {
+				return false;
+			}
+			*t = (MSUTimerTime)ts.tv_sec * 1000000000u + (MSUTimerTime)ts.tv_nsec;
+			return true;
+		}
+	#endif
+#endif
+		case MSUT_CLOCK_PORTABLE: {
+			clock_t c = clock();
+			*t = (MSUTimerTime) c;
+			return (clock_t)(-1) != c;
+		}
+#if MSUT_HAS_TSC
+		case MSUT_CLOCK_TSC:
+			*t = read_tsc_();
+			return true;
 #endif
+		default:
+			return false;
+	}
 }
 
+static bool get_tscfreq_( MSUTimerTime *freq );	// defined below
+
 // ----------------------------------------
-// Convert an MSUTimerTime to microseconds and return them as double.
+// Get the frequency (ticks per sec) of a resolved clock source, along with the
+// exact microseconds per tick. Return false on error, true otherwise.
 //
-static inline double msuttime_to_usecs_( const MSUTimerTime *t, const MSUTimerTime *freq )
+static bool get_msutfreq_( MSUTimerClock source, MSUTimerTime *freq, double *usecs_per_tick )
 {
+	switch ( source ) {
 #if MSUT_OS_WINDOWS
-	return (double) ((t->QuadPart) * 1000000.0) / freq->QuadPart;
+		case MSUT_CLOCK_MONOTONIC: {
+			LARGE_INTEGER f;
+			if ( 0 == QueryPerformanceFrequency( &f ) || f.QuadPart <= 0 ) {
+				// hardware does not support a high-resolution performance counter
+				return false;
+			}
+			*freq = (MSUTimerTime) f.QuadPart;
+			break;
+		}
+		case MSUT_CLOCK_REALTIME:
+		case MSUT_CLOCK_PROCESS_CPU:
+		case MSUT_CLOCK_THREAD_CPU:
+			*freq = 10000000;		// FILETIME: 100-nanosecond intervals
+			break;
 
 #elif MSUT_OS_POSIX
-	(void)freq;
-	return (double) (t->tv_sec * 1000000.0) + t->tv_usec;
+		case MSUT_CLOCK_MONOTONIC:
+	#if MSUT_OS_APPLE
+		{
+			mach_timebase_info_data_t tb;
+			if ( KERN_SUCCESS != mach_timebase_info( &tb ) || 0 == tb.denom ) {
+				return false;
+			}
+			*freq = (MSUTimerTime) ((1000000000.0 * tb.denom) / tb.numer + 0.5);
+			*usecs_per_tick = ((double)tb.numer / tb.denom) / 1000.0;
+			return true;
+		}
+	#endif
+		case MSUT_CLOCK_MONOTONIC_RAW:
+		case MSUT_CLOCK_PROCESS_CPU:
+		case MSUT_CLOCK_THREAD_CPU:
+			*freq = 1000000000;		// nanoseconds
+			break;
+		case MSUT_CLOCK_REALTIME:
+			*freq = 1000000;		// microseconds
+			break;
+#endif
+		case MSUT_CLOCK_PORTABLE:
+			*freq = CLOCKS_PER_SEC;
+			break;
+		case MSUT_CLOCK_TSC:
+			if ( !get_tscfreq_( freq ) ) {
+				return false;
+			}
+			break;
+		default:
+			return false;
+	}
+
+	*usecs_per_tick = 1000000.0 / (double)(*freq);
+	return true;
+}
+
+// ----------------------------------------
+// Check that the CPU cycle-counter is usable as a clock source, and get its
+// frequency (ticks per sec). On x86 this requires an invariant TSC (constant
+// rate, not stopped in deep C-states) and rdtscp; the frequency is calibrated
+// against MSUT_CLOCK_MONOTONIC. Return false on error, true otherwise.
+//
+static bool get_tscfreq_( MSUTimerTime *freq )
+{
+#if MSUT_ARCH_X86
+	unsigned int regs[4] = {0};		// eax, ebx, ecx, edx
+	#if defined(_MSC_VER)
+	__cpuid( (int *)regs, 0x80000000 );
+	#else
+	__get_cpuid( 0x80000000, &regs[0], &regs[1], &regs[2], &regs[3] );
+	#endif
+	if ( regs[0] < 0x80000007 ) {
+		return false;
+	}
+	#if defined(_MSC_VER)
+	__cpuid( (int *)regs, 0x80000001 );
+	#else
+	__get_cpuid( 0x80000001, &regs[0], &regs[1], &regs[2], &regs[3] );
+	#endif
+	if ( !(regs[3] & (1u << 27)) ) {	// rdtscp
+		return false;
+	}
+	#if defined(_MSC_VER)
+	__cpuid( (int *)regs, 0x80000007 );
+	#else
+	__get_cpuid( 0x80000007, &regs[0], &regs[1], &regs[2], &regs[3] );
+	#endif
+	if ( !(regs[3] & (1u << 8)) ) {		// invariant TSC
+		return false;
+	}
+
+	// calibrate against the monotonic clock, bracketing each TSC read
+	MSUTimerTime mfreq;
+	double mupt;
+	if ( !get_msutfreq_( MSUT_CLOCK_MONOTONIC, &mfreq, &mupt ) ) {
+		return false;
+	}
+	MSUTimerTime m0 = 0, m1 = 0, m2 = 0, m3 = 0, c0, c1;
+	if ( !get_msuttime_(MSUT_CLOCK_MONOTONIC, &m0) ) {
+		return false;
+	}
+	c0 = read_tsc_();
+	get_msuttime_( MSUT_CLOCK_MONOTONIC, &m1 );
+	do {
+		get_msuttime_( MSUT_CLOCK_MONOTONIC, &m2 );
+		c1 = read_tsc_();
+		get_msuttime_( MSUT_CLOCK_MONOTONIC, &m3 );
+	} while ( (double)(m2 - m1) * mupt < MSUT_TSC_CALIBRATION_USECS );
+
+	double usecs = ((double)(m2 + m3) - (double)(m0 + m1)) * 0.5 * mupt;
+	if ( usecs <= 0.0 || c1 <= c0 ) {
+		return false;
+	}
+	*freq = (MSUTimerTime) ((double)(c1 - c0) * 1000000.0 / usecs + 0.5);
+	return *freq > 0;
+
+#elif MSUT_ARCH_ARM64
+	// the generic timer runs at a fixed, architecturally reported frequency
+	MSUTimerTime f;
+	__asm__ __volatile__( "mrs %0, cntfrq_el0" : "=r"(f) );
+	*freq = f;
+	return f > 0;
 
 #else
 	(void)freq;
-	return ((double)(*t) * 1000000.0) / CLOCKS_PER_SEC;
-
+	return false;
 #endif
 }
 
+// ----------------------------------------
+// Convert an MSUTimerTime to microseconds and return them as double.
+//
+static inline double msuttime_to_usecs_( const MSUTimer *timer, MSUTimerTime t )
+{
+	return (double)t * timer->usecs_per_tick;
+}
+
 // ----------------------------------------
 // Given an MSUTimer and an MSUTimerTime, update the former with their time
 // difference in microseconds (MSUTimer->t1 is considered the starting time).
 //
-static inline void update_diffusecs_( MSUTimer *timer, const MSUTimerTime *t2 )
+static inline void update_diffusecs_( MSUTimer *timer, MSUTimerTime t2 )
 {
-#if MSUT_OS_WINDOWS
 	// https://docs.microsoft.com/en-us/windows/win32/sysinfo/acquiring-high-resolution-time-stamps
-	timer->diffusecs = ((t2->QuadPart - timer->t1.QuadPart) * 1000000.0) / timer->freq.QuadPart;
-
-#elif MSUT_OS_POSIX
-	timer->diffusecs = ((t2->tv_sec * 1000000.0) + t2->tv_usec)
-		- ((timer->t1.tv_sec * 1000000.0) + timer->t1.tv_usec);
-
-#else	// fallback
-	timer->diffusecs = ((double)(*t2 - timer->t1) * 1000000.0) / CLOCKS_PER_SEC;
-
-#endif
+	// (ticks are subtracted as integers before the conversion, to retain precision)
+	timer->diffusecs = (double)(t2 - timer->t1) * timer->usecs_per_tick;
 }
 
 // ----------------------------------------
@@ -177,565 +738,7415 @@ static int compare_doubles_for_qsort_( const void *a, const void *b )
 	return (*da > *db) - (*da < *db);
 }
 
-/* ----------------------------------
- * Public Interface Functions
- * ----------------------------------
- */
-
 // ----------------------------------------
-// MSUTimer *msutimer_new( void );
-/**
- * Constructs, initializes and starts a new timer. De-allocation should be done
- * by the caller, with msutimer_free().
- *
- * @return
- *		The newly allocated timer, or `NULL` on error.
- *
- * @par Failures:
- * 		- memory allocation failure (`errno` is set by the C runtime)
- * 		- no OS/hardware support for hires timer (`errno` is set to `ERANGE`)
- *
- * @par Sample Usage
- * @code
- 		MSUTimer *timer = msutimer_new();
- 		if ( !timer ) { handle error here }
- 		...
- * @endcode
- */
-MSUTimer *msutimer_new( void )
+// Reorder an array of doubles so that arr[k] holds its k'th smallest element, all
+// elements before it are <= arr[k] and all elements after it are >= arr[k].
+// Quickselect with median-of-3 pivots runs in linear time on average; if it keeps
+// picking bad pivots, the remaining range gets sorted instead (introselect), so
+// the worst case is bounded to O(n log n).
+//
+static void select_kth_doubles_( double *arr, size_t n, size_t k )
 {
-	errno = 0;
+	size_t lo = 0, hi = n - 1;	// inclusive range that contains the k'th element
+	size_t maxdepth = 0;
+	for (size_t m = n; m > 1; m >>= 1) {
+		maxdepth += 2;
+	}
 
-	MSUTimer *timer = calloc( 1, sizeof(*timer) );
-	if ( !timer ) {
-		MSUT_DBGMSG( "ERROR", "calloc(%zu) failed. Return: NULL\n", sizeof(*timer) );
-		return NULL;
+	while ( hi > lo ) {
+		if ( 0 == maxdepth-- ) {
+			qsort( arr + lo, hi - lo + 1, sizeof(double), compare_doubles_for_qsort_ );
+			return;
+		}
+
+		// median-of-3 pivot (also places sentinels at both ends)
+		size_t mid = lo + (hi - lo) / 2;
+		double tmp;
+		if ( arr[mid] < arr[lo] ) { tmp = arr[mid]; arr[mid] = arr[lo]; arr[lo] = tmp; }
+		if ( arr[hi] < arr[lo] )  { tmp = arr[hi];  arr[hi] = arr[lo];  arr[lo] = tmp; }
+		if ( arr[hi] < arr[mid] ) { tmp = arr[hi];  arr[hi] = arr[mid]; arr[mid] = tmp; }
+		double pivot = arr[mid];
+
+		// Hoare partition: arr[lo..j] <= pivot, arr[i..hi] >= pivot, anything
+		// in between equals pivot
+		size_t i = lo, j = hi;
+		while ( i <= j ) {
+			while ( arr[i] < pivot ) {
+				i++;
+			}
+			while ( arr[j] > pivot ) {
+				j--;
+			}
+			if ( i <= j ) {
+				tmp = arr[i]; arr[i] = arr[j]; arr[j] = tmp;
+				i++;
+				if ( 0 == j ) {
+					break;
+				}
+				j--;
+			}
+		}
+
+		if ( k <= j ) {
+			hi = j;
+		}
+		else if ( k >= i ) {
+			lo = i;
+		}
+		else {
+			return;		// k lies in the range of elements equal to pivot
+		}
+	}
+}
+
+// ----------------------------------------
+// Get the median of an array of doubles (the array gets reordered), in linear
+// time. Return 0.0 for an empty array.
+//
+static double median_of_doubles_( double *arr, size_t n )
+{
+	if ( 0 == n ) {
+		return 0.0;
 	}
 
-	// reset the created timer
+	// middle elem, as if the array were sorted
+	size_t k = n / 2;
+	select_kth_doubles_( arr, n, k );
+	double ret = arr[k];
 
-#if MSUT_OS_WINDOWS
-	// get ticks per second (frequency)
-	if ( 0 == QueryPerformanceFrequency( &timer->freq ) ) {
-		// hardware does not support a high-resolution performance counter
-		MSUT_DBGMSG( "ERROR", "%s\n", "(ERANGE) QueryPerformanceFrequency() failed. Return: NULL" );
-		goto fail;
+	// if even # of elems, get average of the middle two: the lower one is the
+	// largest of the elems before the middle
+	if ( n % 2 == 0 ) {
+		double lower = arr[0];
+		for (size_t i=1; i < k; i++) {
+			if ( arr[i] > lower ) {
+				lower = arr[i];
+			}
+		}
+		ret = (lower + ret) / 2;
 	}
-#endif
+	return ret;
+}
 
-	// store current time in timer->t1 as microsecs
-	if ( !get_msuttime_( &timer->t1 ) ) {
-		// OS does not support getting time zone information, and tzp is not a null pointer.
-		MSUT_DBGMSG( "ERROR", "%s\n", "(ERANGE) get_msuttime() failed. Return: NULL" );
-		goto fail;
+// ----------------------------------------
+// Get the k'th smallest element of an array whose first lo elements already are
+// its lo smallest ones (e.g. after a previous selection), then update lo so that
+// it can be called again for a larger k.
+//
+static double select_from_( double *arr, size_t n, size_t *lo, size_t k )
+{
+	if ( k >= *lo ) {
+		select_kth_doubles_( arr + *lo, n - *lo, k - *lo );
+		*lo = k + 1;
 	}
+	return arr[k];
+}
 
-	timer->diffusecs = 0.0;
-	return timer;
+// ----------------------------------------
+// Get the 0-based index of the nearest-rank percentile p (0.0 to 100.0) of n elements.
+// The rank is computed on integers, with p in thousandths of a percent, since
+// ceil() of the product in doubles overshoots by 1 when it should be exact
+// (e.g. 0.999 * 1000).
+//
+static inline size_t percentile_rank_( size_t n, double p )
+{
+	uint64_t pm = (p <= 0.0) ? 0 : (p >= 100.0 ? 100000 : (uint64_t)(p * 1000.0 + 0.5));
+	uint64_t r = (pm * (uint64_t)n + 99999) / 100000;
+	return (r < 1) ? 0 : (r > n ? n - 1 : (size_t)r - 1);
+}
 
-fail:
-	free( timer );
-	errno = ERANGE;
-	return NULL;
+// ----------------------------------------
+// Online (Welford) accumulation of the moments of a sample set.
+//
+typedef struct Welford_ {
+	size_t n;
+	double mean;
+	double m2;		// sum of squared differences from the mean
+	double sum;
+	double min;
+	double max;
+} Welford_;
+
+static inline void welford_reset_( Welford_ *w )
+{
+	w->n = 0;
+	w->mean = w->m2 = w->sum = 0.0;
+	w->min = DBL_MAX;
+	w->max = -DBL_MAX;
+}
+
+static inline void welford_add_( Welford_ *w, double x )
+{
+	w->n++;
+	double delta = x - w->mean;
+	w->mean += delta / (double)w->n;
+	w->m2 += delta * (x - w->mean);
+	w->sum += x;
+	w->min = (x < w->min) ? x : w->min;
+	w->max = (x > w->max) ? x : w->max;
 }
 
 // ----------------------------------------
-// MSUTimer *msutimer_free( MSUTimer *timer );
-/**
- * De-allocates the memory reserved for its timer argument.
- *
- * @param timer
- *		The timer to be freed.
- * @return
- *		Always`NULL`, so the caller can opt to assign it back to the freed pointer,
- *		to avoid leaving it in a dangling state.
- *
- * @par Sample Usage
- * @code
- 		MSUTimer *timer1 = msutimer_new();	// if ( !timer1 ) { handle error here }
- 		MSUTimer *timer2 = msutimer_new();	// if ( !timer2 ) { handle error here }
- 		...
- 		msutimer_free( timer2 );			// free timer2 and leave it dangling
- 		timer1 = msutimer_free( timer1 );	// free timer1 and reset it to NULL
- * @endcode
- */
-MSUTimer *msutimer_free( MSUTimer *timer )
+// Fill stats with the moments accumulated in w, and with the order statistics
+// of the w->n samples recorded in arr (the array gets overwritten).
+//
+static void finish_stats_( MSUTimerStats *stats, const Welford_ *w, double *arr )
 {
-	if ( timer ) {
-		free( timer );
+	size_t n = w->n;
+
+	stats->nsamples = n;
+	if ( 0 == n ) {
+		stats->total = stats->min = stats->max = stats->mean = stats->stddev = 0.0;
+		stats->median = stats->p90 = stats->p99 = stats->p999 = stats->mad = 0.0;
+		return;
 	}
-	return NULL;
+
+	stats->total  = w->sum;
+	stats->min    = w->min;
+	stats->max    = w->max;
+	stats->mean   = w->mean;
+	stats->stddev = (n > 1) ? sqrt( w->m2 / (double)(n - 1) ) : 0.0;
+
+	// median first (it partitions the array around n/2), then the higher
+	// percentiles, each one selected among the elements above the previous one
+	stats->median = median_of_doubles_( arr, n );
+	size_t lo = n/2 + 1;
+	stats->p90  = select_from_( arr, n, &lo, percentile_rank_(n, 90.0) );
+	stats->p99  = select_from_( arr, n, &lo, percentile_rank_(n, 99.0) );
+	stats->p999 = select_from_( arr, n, &lo, percentile_rank_(n, 99.9) );
+
+	for (size_t i=0; i < n; i++) {
+		arr[i] = fabs( arr[i] - stats->median );
+	}
+	stats->mad = median_of_doubles_( arr, n );
 }
+
 // ----------------------------------------
-// double msutimer_gettime( MSUTimer *timer );
-/**
- * Gets the current time and Updates its timer argument with the elapsed time
- * since the previous call of the function, or the construction of the timer
+// Read the wall-clock and the thread CPU time at the start of a sampling pass,
+// and at its end fill the wall_usecs, cpu_usecs, cpu_ratio and cpu_valid of
+// stats (all of them 0 if either clock is unavailable).
+//
+static void cpu_wall_begin_( MSUTimerTime t[2] )
+{
+	if ( !get_msuttime_( MSUT_CLOCK_MONOTONIC, &t[0] )
+	|| MSUT_NCLOCKS == resolve_clock_( MSUT_CLOCK_THREAD_CPU )
+	|| !get_msuttime_( MSUT_CLOCK_THREAD_CPU, &t[1] ) ) {
+		t[0] = t[1] = 0;
+	}
+}
+
+static void cpu_wall_end_( const MSUTimerTime t[2], MSUTimerStats *stats )
+{
+	MSUTimerTime wall, cpu, freq;
+	double wupt, cupt;
+
+	stats->wall_usecs = stats->cpu_usecs = stats->cpu_ratio = 0.0;
+	stats->cpu_valid = false;
+	if ( (0 == t[0] && 0 == t[1])
+	|| !get_msuttime_( MSUT_CLOCK_THREAD_CPU, &cpu )
+	|| !get_msuttime_( MSUT_CLOCK_MONOTONIC, &wall )
+	|| !get_msutfreq_( MSUT_CLOCK_MONOTONIC, &freq, &wupt )
+	|| !get_msutfreq_( MSUT_CLOCK_THREAD_CPU, &freq, &cupt ) ) {
+		return;
+	}
+	stats->wall_usecs = (double)(wall - t[0]) * wupt;
+	stats->cpu_usecs = (double)(cpu - t[1]) * cupt;
+	if ( stats->wall_usecs > 0.0 ) {
+		stats->cpu_ratio = stats->cpu_usecs / stats->wall_usecs;
+	}
+	stats->cpu_valid = true;
+}
+
+// ----------------------------------------
+// Measure the median cost (in ticks) of an empty timed region, i.e. of the 2
+// back-to-back clock reads that surround every bench sample.
+//
+static double calibrate_overhead_( MSUTimerClock source )
+{
+	double samples[ MSUT_OVERHEAD_SAMPLES ];
+	MSUTimerTime t1 = 0, t2 = 0;
+
+	for (size_t i=0; i < MSUT_OVERHEAD_SAMPLES; i++) {
+		get_msuttime_( source, &t1 );
+		get_msuttime_( source, &t2 );
+		samples[i] = (double)(t2 - t1);
+	}
+	return median_of_doubles_( samples, MSUT_OVERHEAD_SAMPLES );
+}
+
+// ----------------------------------------
+// Hardware performance counters: a perf_event_open() group of cycles,
+// instructions, cache misses & branch misses of the calling thread (user-space
+// only), read around the timed window of each bench sample. The counters are
+// read with rdpmc (x86) through their mmap'ed pages when the kernel allows it,
+// and with a read() of the group otherwise.
+//
+#define MSUT_NPERF_	4
+
+struct MSUTimerPerf_ {
+	int fd[ MSUT_NPERF_ ];	// leader (cycles) first
+#if MSUT_HAS_PERF
+	struct perf_event_mmap_page *pc[ MSUT_NPERF_ ];
+#endif
+	size_t pagesize;
+	uint64_t start[ MSUT_NPERF_ ];
+	uint64_t total[ MSUT_NPERF_ ];	// accumulated over the timed windows
+	uint64_t ncalls;				// calls of the callback in the timed windows
+};
+
+#if MSUT_HAS_PERF
+// Read a counter through its mmap'ed page. Return false if rdpmc is not usable.
+static inline bool perf_rdpmc_( const struct perf_event_mmap_page *pc, uint64_t *value )
+{
+#if MSUT_ARCH_X86
+	uint32_t seq, idx;
+	uint64_t count;
+	do {
+		seq = pc->lock;
+		__asm__ __volatile__( "" ::: "memory" );
+		idx = pc->index;
+		if ( !pc->cap_user_rdpmc || 0 == idx ) {
+			return false;
+		}
+		count = (uint64_t)pc->offset;
+		uint32_t lo, hi;
+		__asm__ __volatile__( "rdpmc" : "=a"(lo), "=d"(hi) : "c"(idx - 1) );
+		uint64_t pmc = ((uint64_t)hi << 32) | lo;
+		unsigned width = pc->pmc_width;
+		pmc <<= 64 - width;					// sign-extend the counter
+		count += (uint64_t)((int64_t)pmc >> (64 - width));
+		__asm__ __volatile__( "" ::: "memory" );
+	} while ( pc->lock != seq );
+	*value = count;
+	return true;
+#else
+	(void)pc; (void)value;
+	return false;
+#endif
+}
+#endif
+
+static inline void perf_read_( const MSUTimerPerf_ *perf, uint64_t v[MSUT_NPERF_] )
+{
+#if MSUT_HAS_PERF
+	size_t i;
+	for (i=0; i < MSUT_NPERF_ && perf->pc[i] && perf_rdpmc_(perf->pc[i], &v[i]); i++)
+		;
+	if ( MSUT_NPERF_ == i ) {
+		return;
+	}
+	uint64_t buf[ 1 + MSUT_NPERF_ ];	// PERF_FORMAT_GROUP: nr, then the values
+	if ( (ssize_t)sizeof(buf) == read(perf->fd[0], buf, sizeof(buf)) ) {
+		memcpy( v, &buf[1], MSUT_NPERF_ * sizeof(uint64_t) );
+		return;
+	}
+#endif
+	memset( v, 0, MSUT_NPERF_ * sizeof(uint64_t) );
+}
+
+static inline void perf_begin_( MSUTimerPerf_ *perf )
+{
+	perf_read_( perf, perf->start );
+}
+
+static inline void perf_end_( MSUTimerPerf_ *perf, size_t ncalls )
+{
+	uint64_t v[ MSUT_NPERF_ ];
+	perf_read_( perf, v );
+	for (size_t i=0; i < MSUT_NPERF_; i++) {
+		perf->total[i] += v[i] - perf->start[i];
+	}
+	perf->ncalls += ncalls;
+}
+
+static void perf_reset_( MSUTimerPerf_ *perf )
+{
+	if ( perf ) {
+		memset( perf->total, 0, sizeof(perf->total) );
+		perf->ncalls = 0;
+	}
+}
+
+static MSUTimerPerf_ *perf_close_( MSUTimerPerf_ *perf )
+{
+	if ( perf ) {
+#if MSUT_HAS_PERF
+		for (size_t i = MSUT_NPERF_; i-- > 0; ) {
+			if ( perf->pc[i] ) {
+				munmap( perf->pc[i], perf->pagesize );
+			}
+			if ( perf->fd[i] >= 0 ) {
+				close( perf->fd[i] );
+			}
+		}
+#endif
+		free( perf );
+	}
+	return NULL;
+}
+
+// ----------------------------------------
+// Open the counter group. Return NULL on error, with errno set by the kernel.
+//
+static MSUTimerPerf_ *perf_open_( void )
+{
+#if MSUT_HAS_PERF
+	static const uint64_t configs[ MSUT_NPERF_ ] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+	MSUTimerPerf_ *perf = calloc( 1, sizeof(*perf) );
+	if ( !perf ) {
+		return NULL;
+	}
+	for (size_t i=0; i < MSUT_NPERF_; i++) {
+		perf->fd[i] = -1;
+	}
+	perf->pagesize = (size_t) sysconf( _SC_PAGESIZE );
+
+	for (size_t i=0; i < MSUT_NPERF_; i++) {
+		struct perf_event_attr attr;
+		memset( &attr, 0, sizeof(attr) );
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = configs[i];
+		attr.read_format = PERF_FORMAT_GROUP;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		perf->fd[i] = (int) syscall( SYS_perf_event_open, &attr, 0, -1, 0 == i ? -1 : perf->fd[0], 0 );
+		if ( perf->fd[i] < 0 ) {
+			int err = errno;
+			perf_close_( perf );
+			errno = err;
+			return NULL;
+		}
+		void *pc = mmap( NULL, perf->pagesize, PROT_READ, MAP_SHARED, perf->fd[i], 0 );
+		perf->pc[i] = (MAP_FAILED == pc) ? NULL : pc;	// NULL: read() only
+	}
+	return perf;
+#else
+	errno = ENOSYS;
+	return NULL;
+#endif
+}
+
+// ----------------------------------------
+// Pass back the per-call counters of the latest bench run
+//
+static void perf_get_( const MSUTimerPerf_ *perf, MSUTimerCounters *counters )
+{
+	memset( counters, 0, sizeof(*counters) );
+	if ( !perf || 0 == perf->ncalls ) {
+		return;
+	}
+	double n = (double)perf->ncalls;
+	counters->valid = true;
+	counters->cycles = (double)perf->total[0] / n;
+	counters->instructions = (double)perf->total[1] / n;
+	counters->cache_misses = (double)perf->total[2] / n;
+	counters->branch_misses = (double)perf->total[3] / n;
+	counters->ipc = perf->total[0] ? (double)perf->total[1] / (double)perf->total[0] : 0.0;
+}
+
+// ----------------------------------------
+// Memory allocation tracking: the allocations of the calling thread are counted
+// (by msutimer_alloc_note() and msutimer_free_note(), called by the malloc()
+// wrappers) only inside the timed window of each bench sample.
+//
+typedef struct MSUTimerAllocTls_ {
+	bool on;
+	uint64_t allocs, frees, bytes;
+} MSUTimerAllocTls_;
+
+#if defined(MSUT_THREAD_LOCAL_)
+static MSUT_THREAD_LOCAL_ MSUTimerAllocTls_ alloc_tls_;
+#else
+static MSUTimerAllocTls_ alloc_tls_;	// counts the allocations of all threads
+#endif
+
+// Get the peak resident set size of the process, in bytes (-1 if unknown)
+static int64_t peak_rss_( void )
+{
+#if MSUT_OS_WINDOWS
+	PROCESS_MEMORY_COUNTERS pmc;
+	if ( GetProcessMemoryInfo( GetCurrentProcess(), &pmc, sizeof(pmc) ) ) {
+		return (int64_t) pmc.PeakWorkingSetSize;
+	}
+	return -1;
+#elif MSUT_OS_POSIX
+	struct rusage ru;
+	if ( 0 != getrusage( RUSAGE_SELF, &ru ) ) {
+		return -1;
+	}
+	#if MSUT_OS_APPLE
+	return (int64_t) ru.ru_maxrss;			// bytes
+	#else
+	return (int64_t) ru.ru_maxrss * 1024;	// kilobytes
+	#endif
+#else
+	return -1;
+#endif
+}
+
+static inline void alloc_begin_( void )
+{
+	alloc_tls_.on = true;
+}
+
+static inline void alloc_end_( MSUTimerAlloc_ *alloc, size_t ncalls )
+{
+	alloc_tls_.on = false;
+	alloc->allocs += alloc_tls_.allocs;
+	alloc->frees += alloc_tls_.frees;
+	alloc->bytes += alloc_tls_.bytes;
+	alloc->ncalls += ncalls;
+	alloc_tls_.allocs = alloc_tls_.frees = alloc_tls_.bytes = 0;
+}
+
+static void alloc_reset_( MSUTimerAlloc_ *alloc )
+{
+	if ( alloc->enabled ) {
+		alloc->allocs = alloc->frees = alloc->bytes = alloc->ncalls = 0;
+		alloc->rss0 = peak_rss_();
+	}
+}
+
+// Pass back the per-call allocations of the latest bench run
+static void alloc_get_( const MSUTimerAlloc_ *alloc, MSUTimerAllocs *allocs )
+{
+	memset( allocs, 0, sizeof(*allocs) );
+	if ( !alloc->enabled || 0 == alloc->ncalls ) {
+		return;
+	}
+	double n = (double)alloc->ncalls;
+	allocs->valid = true;
+	allocs->allocs = (double)alloc->allocs / n;
+	allocs->frees = (double)alloc->frees / n;
+	allocs->bytes = (double)alloc->bytes / n;
+	int64_t rss = peak_rss_();
+	if ( rss >= 0 && alloc->rss0 >= 0 ) {
+		allocs->peak_rss_delta = (double)(rss - alloc->rss0);
+	}
+}
+
+// ----------------------------------------
+// Forget the pauses made while no sample was timed (e.g. during the fixed
+// warm-up, or in the whole-run timing of msutimer_bench()), at the start of
+// a sample.
+//
+static inline void pause_reset_( MSUTimer *timer )
+{
+	timer->paused = false;
+	timer->paused_ticks = 0;
+}
+
+// ----------------------------------------
+// Exclude the time paused by the callback (see msutimer_pause()) from a sample
+// that ended at t2, lasting ticks. Reset for the next sample.
+//
+static inline MSUTimerTime unpaused_ticks_( MSUTimer *timer, MSUTimerTime t2, MSUTimerTime ticks )
+{
+	if ( timer->paused ) {		// never resumed: paused until the end
+		timer->paused_ticks += t2 - timer->pause_t1;
+		timer->paused = false;
+	}
+	MSUTimerTime paused = timer->paused_ticks;
+	timer->paused_ticks = 0;
+	return paused < ticks ? ticks - paused : 0;
+}
+
+// ----------------------------------------
+// Time a single call of the callback, in ticks. Return the callback's result.
+//
+static inline bool sample_ticks_( MSUTimer *timer, bool (*callback)(void *), void *userdata, MSUTimerTime *ticks )
+{
+	MSUTimerTime t1 = 0, t2 = 0;
+
+	if ( timer->perf ) {
+		perf_begin_( timer->perf );
+	}
+	if ( timer->alloc.enabled ) {
+		alloc_begin_();
+	}
+	pause_reset_( timer );
+	get_msuttime_( timer->source, &t1 );
+	bool ret = callback( userdata );
+	get_msuttime_( timer->source, &t2 );
+	if ( timer->alloc.enabled ) {
+		alloc_end_( &timer->alloc, ret ? 1 : 0 );
+	}
+	if ( timer->perf ) {
+		perf_end_( timer->perf, ret ? 1 : 0 );
+	}
+
+	*ticks = unpaused_ticks_( timer, t2, t2 - t1 );
+	return ret;
+}
+
+// ----------------------------------------
+// Convert a bench sample from ticks to microseconds, subtracting the timer
+// overhead if requested (never going below 0).
+//
+static void log_put_( MSUTimerLog *log, uint64_t ticks );
+
+static inline double sample_to_usecs_( const MSUTimer *timer, MSUTimerTime ticks )
+{
+	if ( timer->log ) {
+		log_put_( timer->log, ticks );
+	}
+	double t = (double)ticks;
+	if ( timer->subtract_overhead ) {
+		t = (t > timer->overhead_ticks) ? t - timer->overhead_ticks : 0.0;
+	}
+	return t * timer->usecs_per_tick;
+}
+
+// ----------------------------------------
+// Time a batch of consecutive calls of the callback, in ticks. Return false if
+// the callback failed, passing back in done the number of successful calls.
+//
+static inline bool sample_batch_ticks_( MSUTimer *timer, size_t batch, bool (*callback)(void *), void *userdata, MSUTimerTime *ticks, size_t *done )
+{
+	MSUTimerTime t1 = 0, t2 = 0;
+	bool ret = true;
+	size_t i;
+
+	if ( timer->perf ) {
+		perf_begin_( timer->perf );
+	}
+	if ( timer->alloc.enabled ) {
+		alloc_begin_();
+	}
+	pause_reset_( timer );
+	get_msuttime_( timer->source, &t1 );
+	for (i=0; i < batch; i++) {
+		if ( !callback( userdata ) ) {
+			ret = false;
+			break;
+		}
+	}
+	get_msuttime_( timer->source, &t2 );
+	if ( timer->alloc.enabled ) {
+		alloc_end_( &timer->alloc, i );
+	}
+	if ( timer->perf ) {
+		perf_end_( timer->perf, i );
+	}
+
+	*ticks = unpaused_ticks_( timer, t2, t2 - t1 );
+	*done = i;
+	return ret;
+}
+
+// ----------------------------------------
+// Get a buffer for n samples: the timer's reserved one if it is large enough,
+// otherwise a newly allocated one. Return NULL on allocation failure.
+//
+static double *acquire_samples_( MSUTimer *timer, size_t n )
+{
+	if ( timer->samples && n <= timer->nsamples ) {
+		return timer->samples;
+	}
+	double *ret = malloc( n * sizeof(double) );
+	if ( !ret ) {
+		MSUT_DBGMSG( "ERROR", "malloc(%zu) failed!\n", n * sizeof(double) );
+	}
+	return ret;
+}
+
+// ----------------------------------------
+// Release a buffer obtained with acquire_samples_().
+//
+static inline void release_samples_( MSUTimer *timer, double *samples )
+{
+	if ( samples != timer->samples ) {
+		free( samples );
+	}
+}
+
+// ----------------------------------------
+// Return value of the benchmark functions that return a time, when their
+// callback failed with no time to report (e.g. during warm-up, or at the first
+// iteration): -0.0 compares equal to 0.0, so errno tells it apart from success.
+//
+static double failed_zero_( void )
+{
+	errno = ECANCELED;
+	MSUT_DBGMSG( "WARNING", "%s\n", "(ECANCELED) callback failed with no time to report. Return: -0.0 secs" );
+	return -0.0;
+}
+
+// ----------------------------------------
+// Record nrepeats timings of the callback into rectimes, and return their
+// median (negative if the callback failed, see msutimer_bench_median()).
+//
+static double record_median_( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat, double *rectimes )
+{
+	// record nrepeats timings
+	double bias = 1.0;
+	MSUTimerTime t;
+	for (size_t i=0; i < nrepeats; i++) {
+		if ( !sample_ticks_( timer, callback, userdata, &t ) ) {
+			if ( erepeat ) {
+				*erepeat = i;
+			}
+			bias = -1.0;
+			MSUT_DBGMSG(
+				"WARNING",
+				"Requested iterations: %zu, but FAILED at %zu (erepeat).\n"
+				"==> Returned: median secs until then (with negative sign).\n",
+				nrepeats,
+				i+1
+				);
+			nrepeats = i;	// # of successful iterations before failure
+			break;
+		}
+		rectimes[i] = sample_to_usecs_( timer, t );
+	}
+
+	return bias * median_of_doubles_( rectimes, nrepeats );
+}
+
+// ----------------------------------------
+// Count the leading zero bits of a non-zero 64-bit value.
+//
+static inline int clz64_( uint64_t v )
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_clzll( v );
+#else
+	int n = 0;
+	for (uint64_t bit = (uint64_t)1 << 63; !(v & bit); bit >>= 1) {
+		n++;
+	}
+	return n;
+#endif
+}
+
+// ----------------------------------------
+// Histogram index math (see the MSUTimerHist definition)
+//
+static inline int hist_bucket_( const MSUTimerHist *h, uint64_t v )
+{
+	return (64 - clz64_(v | h->sub_mask)) - (h->sub_half_mag + 1);
+}
+
+static inline size_t hist_index_( const MSUTimerHist *h, uint64_t v )
+{
+	int b = hist_bucket_( h, v );
+	uint64_t sb = v >> b;
+	return (size_t)((((uint64_t)b + 1) << h->sub_half_mag) + (sb - h->sub_half));
+}
+
+// lowest value that falls in counts[i]
+static inline uint64_t hist_value_at_( const MSUTimerHist *h, size_t i )
+{
+	long b = (long)(i >> h->sub_half_mag) - 1;
+	uint64_t sb = (i & (h->sub_half - 1)) + h->sub_half;
+	if ( b < 0 ) {
+		sb -= h->sub_half;
+		b = 0;
+	}
+	return sb << b;
+}
+
+// number of distinct values that fall in the same counts[] slot as v
+static inline uint64_t hist_range_( const MSUTimerHist *h, uint64_t v )
+{
+	return (uint64_t)1 << hist_bucket_( h, v );
+}
+
+// representative value of counts[i] (the middle of its range)
+static inline uint64_t hist_mid_at_( const MSUTimerHist *h, size_t i )
+{
+	uint64_t v = hist_value_at_( h, i );
+	return v + hist_range_( h, v ) / 2;
+}
+
+// ----------------------------------------
+// Get the value (nanosecs) at the given percentile of a non-empty histogram.
+//
+static uint64_t hist_value_at_percentile_( const MSUTimerHist *h, double p )
+{
+	p = (p < 0.0) ? 0.0 : ((p > 100.0) ? 100.0 : p);
+	uint64_t target = (uint64_t) ((p / 100.0) * (double)h->total + 0.5);
+	target = (target < 1) ? 1 : target;
+
+	uint64_t sum = 0;
+	for (size_t i=0; i < h->ncounts; i++) {
+		sum += h->counts[i];
+		if ( sum >= target ) {
+			uint64_t v = hist_value_at_( h, i );
+			v += hist_range_( h, v ) - 1;	// highest equivalent value
+			return (v < h->min) ? h->min : ((v > h->max) ? h->max : v);
+		}
+	}
+	return h->max;
+}
+
+// ----------------------------------------
+// Count the recorded values whose representative value lies in [lo, hi].
+//
+static uint64_t hist_count_between_( const MSUTimerHist *h, uint64_t lo, uint64_t hi )
+{
+	uint64_t n = 0;
+	for (size_t i=0; i < h->ncounts; i++) {
+		if ( h->counts[i] ) {
+			uint64_t v = hist_mid_at_( h, i );
+			if ( v >= lo && v <= hi ) {
+				n += h->counts[i];
+			}
+		}
+	}
+	return n;
+}
+
+// ----------------------------------------
+// Pin the calling thread to the specified CPU. Return false on error, or if
+// the platform does not support thread affinity (e.g. macOS).
+//
+static bool pin_thread_( size_t cpu )
+{
+#if MSUT_OS_WINDOWS
+	if ( cpu >= 8 * sizeof(DWORD_PTR) ) {
+		return false;
+	}
+	return 0 != SetThreadAffinityMask( GetCurrentThread(), (DWORD_PTR)1 << cpu );
+
+#elif MSUT_OS_POSIX && defined(__linux__)
+	cpu_set_t set;
+	if ( cpu >= CPU_SETSIZE ) {
+		return false;
+	}
+	CPU_ZERO( &set );
+	CPU_SET( cpu, &set );
+	return 0 == sched_setaffinity( 0, sizeof(set), &set );
+
+#else
+	(void)cpu;
+	return false;
+#endif
+}
+
+#if MSUT_HAS_THREADS
+// ----------------------------------------
+// Portable thread creation & joining. Return false on error.
+//
+typedef struct MSUTimerThreadArg_ {
+	void (*fn)(void *);
+	void *arg;
+} MSUTimerThreadArg_;
+
+#if MSUT_OS_WINDOWS
+static DWORD WINAPI thread_main_( LPVOID p )
+{
+	MSUTimerThreadArg_ *a = p;
+	a->fn( a->arg );
+	return 0;
+}
+#else
+static void *thread_main_( void *p )
+{
+	MSUTimerThreadArg_ *a = p;
+	a->fn( a->arg );
+	return NULL;
+}
+#endif
+
+static bool thread_start_( MSUTimerThread_ *th, MSUTimerThreadArg_ *a )
+{
+#if MSUT_OS_WINDOWS
+	*th = CreateThread( NULL, 0, thread_main_, a, 0, NULL );
+	return NULL != *th;
+#else
+	return 0 == pthread_create( th, NULL, thread_main_, a );
+#endif
+}
+
+static void thread_join_( MSUTimerThread_ th )
+{
+#if MSUT_OS_WINDOWS
+	WaitForSingleObject( th, INFINITE );
+	CloseHandle( th );
+#else
+	pthread_join( th, NULL );
+#endif
+}
+
+// ----------------------------------------
+// State of a msutimer_bench_parallel() run
+//
+typedef struct MSUTimerParRun_ {
+	const MSUTimer *timer;
+	size_t nrepeats;
+	bool (*callback)(void *);
+	bool pin;
+	int64_t ready;		// # of threads waiting at the start barrier
+	int64_t go;			// 1: start, -1: abort
+} MSUTimerParRun_;
+
+typedef struct MSUTimerParThread_ {
+	MSUTimerParRun_ *run;
+	MSUTimerThreadArg_ targ;
+	size_t index;
+	void *userdata;
+	MSUTimerTime t1, t2;	// start & end ticks
+	size_t done;			// successful iterations
+	double ops_per_sec;		// throughput of the thread
+	unsigned char pad[ MSUT_CACHELINE ];	// keep the threads' results apart
+} MSUTimerParThread_;
+
+static void par_worker_( void *p )
+{
+	MSUTimerParThread_ *pt = p;
+	MSUTimerParRun_ *run = pt->run;
+
+	if ( run->pin ) {
+		pin_thread_( pt->index );
+	}
+
+	// spin barrier: wait until all threads are ready
+	MSUT_ATOMIC_FETCH_ADD_( &run->ready, 1 );
+	int64_t go;
+	while ( 0 == (go = MSUT_ATOMIC_LOAD_(&run->go)) ) {
+#if MSUT_ARCH_X86
+		_mm_pause();
+#endif
+	}
+	if ( go < 0 ) {
+		return;
+	}
+
+	size_t i;
+	get_msuttime_( run->timer->source, &pt->t1 );
+	for (i=0; i < run->nrepeats; i++) {
+		if ( !run->callback( pt->userdata ) ) {
+			break;
+		}
+	}
+	get_msuttime_( run->timer->source, &pt->t2 );
+	pt->done = i;
+}
+
+// ----------------------------------------
+// Run callback nrepeats times on each of nthreads threads (all starting together)
+// and fill res. Return false if a thread could not be created (errno is set).
+//
+static bool par_run_( const MSUTimer *timer, size_t nthreads, size_t nrepeats, bool (*callback)(void *), void **userdata, bool pin, MSUTimerParThread_ *pts, MSUTimerThread_ *ths, MSUTimerParallel *res )
+{
+	MSUTimerParRun_ run = { timer, nrepeats, callback, pin, 0, 0 };
+	size_t nstarted;
+
+	for (nstarted=0; nstarted < nthreads; nstarted++) {
+		MSUTimerParThread_ *pt = &pts[nstarted];
+		memset( pt, 0, sizeof(*pt) );
+		pt->run = &run;
+		pt->index = nstarted;
+		pt->userdata = userdata ? userdata[nstarted] : NULL;
+		pt->targ.fn = par_worker_;
+		pt->targ.arg = pt;
+		if ( !thread_start_( &ths[nstarted], &pt->targ ) ) {
+			break;
+		}
+	}
+
+	if ( nstarted < nthreads ) {
+		int err = errno ? errno : EAGAIN;
+		MSUT_ATOMIC_STORE_( &run.go, -1 );
+		for (size_t i=0; i < nstarted; i++) {
+			thread_join_( ths[i] );
+		}
+		errno = err;
+		return false;
+	}
+
+	// release all threads at once, as soon as they are all spinning
+	while ( MSUT_ATOMIC_LOAD_(&run.ready) < (int64_t)nthreads ) {
+#if MSUT_OS_POSIX
+		sched_yield();
+#endif
+	}
+	MSUT_ATOMIC_STORE_( &run.go, 1 );
+
+	for (size_t i=0; i < nthreads; i++) {
+		thread_join_( ths[i] );
+	}
+
+	// aggregate
+	MSUTimerTime first = pts[0].t1, last = pts[0].t2;
+	size_t total = 0;
+	memset( res, 0, sizeof(*res) );
+	res->nthreads = nthreads;
+	res->min_thread_ops_per_sec = DBL_MAX;
+	for (size_t i=0; i < nthreads; i++) {
+		MSUTimerParThread_ *pt = &pts[i];
+		double secs = (double)(pt->t2 - pt->t1) * timer->usecs_per_tick * 0.000001;
+		pt->ops_per_sec = (secs > 0.0) ? (double)pt->done / secs : 0.0;
+
+		first = (pt->t1 < first) ? pt->t1 : first;
+		last  = (pt->t2 > last) ? pt->t2 : last;
+		total += pt->done;
+		res->failed = res->failed || pt->done < nrepeats;
+		res->min_thread_ops_per_sec = (pt->ops_per_sec < res->min_thread_ops_per_sec) ? pt->ops_per_sec : res->min_thread_ops_per_sec;
+		res->max_thread_ops_per_sec = (pt->ops_per_sec > res->max_thread_ops_per_sec) ? pt->ops_per_sec : res->max_thread_ops_per_sec;
+	}
+	res->elapsed_usecs = (double)(last - first) * timer->usecs_per_tick;
+	res->ops_per_sec = (res->elapsed_usecs > 0.0) ? (double)total / (0.000001 * res->elapsed_usecs) : 0.0;
+	res->speedup = 1.0;
+	res->efficiency = 1.0 / (double)nthreads;
+	return true;
+}
+#endif	// MSUT_HAS_THREADS
+
+// ----------------------------------------
+// Run the warm-up phase configured with msutimer_set_warmup() and
+// msutimer_set_steady_state(), before a bench run. Record in the timer the
+// number of warm-up iterations, and whether steady-state was reached.
+// Return false if the callback failed.
+//
+static bool warmup_( MSUTimer *timer, bool (*callback)(void *), void *userdata )
+{
+	MSUTimerTime start = 0, now = 0;
+	size_t n = 0;
+
+	timer->nwarmup = 0;
+	timer->steady = false;
+
+	// fixed warm-up, by iterations and/or by time
+	get_msuttime_( timer->source, &start );
+	now = start;
+	while ( n < timer->warmup_iters || (double)(now - start) * timer->usecs_per_tick < timer->warmup_usecs ) {
+		if ( !callback( userdata ) ) {
+			timer->nwarmup = n;
+			MSUT_DBGMSG( "WARNING", "Callback FAILED during warm-up, at %zu.\n", n );
+			return false;
+		}
+		n++;
+		get_msuttime_( timer->source, &now );
+	}
+
+	// steady-state: keep sampling until the coefficient of variation of the
+	// latest steady_window samples drops below steady_cv, or the budget is over
+	size_t w = timer->steady_window;
+	if ( w > 1 ) {
+		double *win = malloc( w * sizeof(double) );
+		if ( !win ) {
+			MSUT_DBGMSG( "WARNING", "malloc(%zu) failed! Skipping steady-state detection.\n", w * sizeof(double) );
+			timer->nwarmup = n;
+			perf_reset_( timer->perf );
+			alloc_reset_( &timer->alloc );
+			return true;
+		}
+
+		double sum = 0.0, sumsq = 0.0;
+		size_t filled = 0;
+		MSUTimerTime t;
+		get_msuttime_( timer->source, &start );
+		now = start;
+		while ( (double)(now - start) * timer->usecs_per_tick < timer->steady_usecs ) {
+			if ( !sample_ticks_( timer, callback, userdata, &t ) ) {
+				free( win );
+				timer->nwarmup = n;
+				MSUT_DBGMSG( "WARNING", "Callback FAILED during steady-state detection, at %zu.\n", n );
+				return false;
+			}
+			double x = (double)t;
+			size_t slot = n % w;
+			if ( filled == w ) {
+				sum -= win[slot];
+				sumsq -= win[slot] * win[slot];
+			}
+			else {
+				filled++;
+			}
+			win[slot] = x;
+			sum += x;
+			sumsq += x * x;
+			n++;
+
+			if ( filled == w && sum > 0.0 ) {
+				double mean = sum / (double)w;
+				double var = (sumsq - sum * mean) / (double)(w - 1);
+				if ( sqrt(var > 0.0 ? var : 0.0) / mean <= timer->steady_cv ) {
+					timer->steady = true;
+					break;
+				}
+			}
+			get_msuttime_( timer->source, &now );
+		}
+		free( win );
+	}
+
+	timer->nwarmup = n;
+	perf_reset_( timer->perf );	// count only the recorded samples
+	alloc_reset_( &timer->alloc );
+	return true;
+}
+
+// ----------------------------------------
+// Process-wide cache of the properties of each clock source, measured by the
+// first timer reading it, so that creating the rest is cheap (e.g. the TSC
+// calibration alone takes MSUT_TSC_CALIBRATION_USECS). Threads racing on an
+// uncached source measure it each, and the first one to finish caches it.
+//
+typedef struct MSUTimerClockInfo_ {
+	int64_t state;			// 0: not cached, 1: being cached, 2: cached
+	MSUTimerTime freq;
+	double usecs_per_tick;
+	double overhead_ticks;
+	double resolution_usecs;
+} MSUTimerClockInfo_;
+
+static MSUTimerClockInfo_ clock_info_[ MSUT_NCLOCKS ];
+
+// ----------------------------------------
+// Spin on the specified clock source until its reading changes, and return
+// the step in microseconds (what msutimer_accuracy_usecs() measures).
+//
+static double measure_resolution_( MSUTimerClock source, double usecs_per_tick )
+{
+	MSUTimerTime t1 = 0, t2 = 0;
+	if ( !get_msuttime_( source, &t1 ) ) {
+		return 0.0;
+	}
+	do {
+		if ( !get_msuttime_( source, &t2 ) ) {
+			return 0.0;
+		}
+	} while ( t2 <= t1 );
+	return (double)(t2 - t1) * usecs_per_tick;
+}
+
+static bool get_clock_info_( MSUTimerClock source, MSUTimerClockInfo_ *info )
+{
+	MSUTimerClockInfo_ *cached = &clock_info_[ source ];
+	if ( 2 == MSUT_ATOMIC_LOAD_( &cached->state ) ) {
+		*info = *cached;
+		return true;
+	}
+
+	if ( !get_msutfreq_( source, &info->freq, &info->usecs_per_tick ) ) {
+		return false;
+	}
+	info->overhead_ticks = calibrate_overhead_( source );
+	info->resolution_usecs = measure_resolution_( source, info->usecs_per_tick );
+	if ( MSUT_ATOMIC_CAS_( &cached->state, 0, 1 ) ) {
+		cached->freq = info->freq;
+		cached->usecs_per_tick = info->usecs_per_tick;
+		cached->overhead_ticks = info->overhead_ticks;
+		cached->resolution_usecs = info->resolution_usecs;
+		MSUT_ATOMIC_STORE_( &cached->state, 2 );
+	}
+	return true;
+}
+
+// ----------------------------------------
+// Initialize and start a zeroed timer, reading the specified (valid) clock
+// source. Return false with errno set to ERANGE if it is not supported.
+//
+static bool timer_setup_( MSUTimer *timer, MSUTimerClock source, int origin )
+{
+	MSUTimerClockInfo_ info;
+
+	timer->origin = origin;
+	timer->source = resolve_clock_( source );
+	if ( MSUT_NCLOCKS == timer->source ) {
+		MSUT_DBGMSG( "ERROR", "(ERANGE) clock source %s is not supported.\n", msutimer_clock_name(source) );
+		errno = ERANGE;
+		return false;
+	}
+
+	// get ticks per second (frequency)
+	if ( !get_clock_info_( timer->source, &info ) ) {
+		// hardware does not support a high-resolution performance counter
+		MSUT_DBGMSG( "ERROR", "%s\n", "(ERANGE) get_msutfreq_() failed." );
+		errno = ERANGE;
+		return false;
+	}
+	timer->freq = info.freq;
+	timer->usecs_per_tick = info.usecs_per_tick;
+	timer->nsecs_per_tick = 1000.0 * timer->usecs_per_tick;
+	timer->overhead_ticks = info.overhead_ticks;
+	timer->resolution_usecs = info.resolution_usecs;
+
+	// store current time in timer->t1 as ticks
+	if ( !get_msuttime_( timer->source, &timer->t1 ) ) {
+		// OS does not support the requested clock
+		MSUT_DBGMSG( "ERROR", "%s\n", "(ERANGE) get_msuttime() failed." );
+		errno = ERANGE;
+		return false;
+	}
+
+	timer->diffusecs = 0.0;
+	timer->subtract_overhead = false;
+	return true;
+}
+
+// ----------------------------------------
+// Release the resources owned by a timer (but not the timer itself)
+//
+static void timer_release_( MSUTimer *timer )
+{
+	timer->perf = perf_close_( timer->perf );
+	free( timer->samples );
+	timer->samples = NULL;
+	timer->nsamples = 0;
+}
+
+/* ----------------------------------
+ * Public Interface Functions
+ * ----------------------------------
+ */
+
+// ----------------------------------------
+// MSUTimer *msutimer_new( void );
+/**
+ * Constructs, initializes and starts a new timer, using the default clock source.
+ * De-allocation should be done by the caller, with msutimer_free().
+ *
+ * @return
+ *		The newly allocated timer, or `NULL` on error.
+ * @remarks
+ *		This is the same as calling msutimer_new_ex() with MSUT_CLOCK_DEFAULT.
+ *		The default clock source is MSUT_CLOCK_MONOTONIC, unless the library
+ *		is compiled with a different `MSUT_DEFAULT_CLOCK` (e.g. with
+ *		`-DMSUT_DEFAULT_CLOCK=MSUT_CLOCK_REALTIME`).
+ *
+ * @par Failures:
+ * 		- memory allocation failure (`errno` is set by the C runtime)
+ * 		- no OS/hardware support for hires timer (`errno` is set to `ERANGE`)
+ *
+ * @par Sample Usage
+ * @code
+ 		MSUTimer *timer = msutimer_new();
+ 		if ( !timer ) { handle error here }
+ 		...
+ * @endcode
+ */
+MSUTimer *msutimer_new( void )
+{
+	return msutimer_new_ex( MSUT_CLOCK_DEFAULT );
+}
+
+// ----------------------------------------
+// MSUTimer *msutimer_new_ex( MSUTimerClock source );
+/**
+ * Constructs, initializes and starts a new timer, reading the specified clock
+ * source. De-allocation should be done by the caller, with msutimer_free().
+ *
+ * @param source
+ *		The clock source to be used by the timer (see ::MSUTimerClock).
+ * @return
+ *		The newly allocated timer, or `NULL` on error.
+ * @remarks
+ *		The monotonic sources store integer *nanosecond* ticks on POSIX
+ *		(`clock_gettime()`), so they are not capped to the 1 *microsecond*
+ *		resolution of `gettimeofday()`, and they do not jump when the wall
+ *		clock gets adjusted. MSUT_CLOCK_MONOTONIC_RAW is not even slewed by NTP,
+ *		but on older Linux kernels it is not served by the vDSO, making every
+ *		read a system call.
+ *
+ *		MSUT_CLOCK_TSC reads the CPU cycle-counter directly (`rdtscp` on x86,
+ *		`cntvct_el0` on ARM64), which is the cheapest clock read available,
+ *		bracketed by fences so that out-of-order execution does not leak across
+ *		the measured region. On x86 it is accepted only when the CPU reports an
+ *		invariant TSC, and its frequency is calibrated against MSUT_CLOCK_MONOTONIC
+ *		for `MSUT_TSC_CALIBRATION_USECS` (10000 by default), which is how long
+ *		creating the first such timer takes.
+ *
+ *		The frequency and the overhead (see msutimer_overhead_usecs()) of each
+ *		clock source are measured only once per process, and shared by all the
+ *		timers reading it. For timers that do not need the heap, see
+ *		msutimer_init() and msutimer_pool_new().
+ *
+ *		MSUT_CLOCK_PROCESS_CPU and MSUT_CLOCK_THREAD_CPU measure CPU time
+ *		instead of elapsed time, so they leave out the time the process (or the
+ *		calling thread) spent descheduled or blocked. Reading them is a lot
+ *		costlier than reading the monotonic sources, and on Windows they only
+ *		advance on scheduler ticks (about 15.6 *milliseconds*). The thread
+ *		source measures the thread that reads it, so do not share such timers
+ *		across threads. To compare wall-clock and CPU time of a single run, see
+ *		the `cpu_ratio` of msutimer_bench_stats().
+ *
+ * @par Failures:
+ * 		- memory allocation failure (`errno` is set by the C runtime)
+ * 		- source is not a valid ::MSUTimerClock (`errno` is set to `EDOM`)
+ * 		- no OS/hardware support for the requested clock source (`errno` is set to `ERANGE`)
+ *
+ * @par Sample Usage
+ * @code
+ 		MSUTimer *timer = msutimer_new_ex( MSUT_CLOCK_MONOTONIC_RAW );
+ 		if ( !timer ) { handle error here }
+ 		...
+ * @endcode
+ */
+MSUTimer *msutimer_new_ex( MSUTimerClock source )
+{
+	errno = 0;
+
+	if ( (unsigned)source >= MSUT_NCLOCKS ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "(EDOM) function parameter (source=%d). Return: NULL\n", (int)source );
+		return NULL;
+	}
+
+	MSUTimer *timer = calloc( 1, sizeof(*timer) );
+	if ( !timer ) {
+		MSUT_DBGMSG( "ERROR", "calloc(%zu) failed. Return: NULL\n", sizeof(*timer) );
+		return NULL;
+	}
+
+	if ( !timer_setup_( timer, source, MSUT_ORIGIN_HEAP_ ) ) {
+		free( timer );
+		errno = ERANGE;
+		return NULL;
+	}
+	return timer;
+}
+
+// ----------------------------------------
+// MSUTimer *msutimer_free( MSUTimer *timer );
+/**
+ * De-allocates the memory reserved for its timer argument.
+ *
+ * Timers acquired from a pool (see msutimer_pool_acquire()) are given back to
+ * their pool, and timers created in caller-provided storage (see
+ * msutimer_init()) release their resources, as msutimer_fini() does.
+ *
+ * @param timer
+ *		The timer to be freed.
+ * @return
+ *		Always`NULL`, so the caller can opt to assign it back to the freed pointer,
+ *		to avoid leaving it in a dangling state.
+ *
+ * @par Sample Usage
+ * @code
+ 		MSUTimer *timer1 = msutimer_new();	// if ( !timer1 ) { handle error here }
+ 		MSUTimer *timer2 = msutimer_new();	// if ( !timer2 ) { handle error here }
+ 		...
+ 		msutimer_free( timer2 );			// free timer2 and leave it dangling
+ 		timer1 = msutimer_free( timer1 );	// free timer1 and reset it to NULL
+ * @endcode
+ */
+static void pool_release_( MSUTimerPool *pool, MSUTimer *timer );	// defined below
+
+MSUTimer *msutimer_free( MSUTimer *timer )
+{
+	if ( !timer ) {
+		return NULL;
+	}
+
+	timer_release_( timer );
+	if ( MSUT_ORIGIN_POOL_ == timer->origin ) {
+		pool_release_( timer->pool, timer );
+	}
+	else if ( MSUT_ORIGIN_HEAP_ == timer->origin ) {
+		free( timer );
+	}
+	return NULL;
+}
+// ----------------------------------------
+// double msutimer_gettime( MSUTimer *timer );
+/**
+ * Gets the current time and Updates its timer argument with the elapsed time
+ * since the previous call of the function, or the construction of the timer
  * (whichever came last). The time-difference can then get fetched as a `double`
  * with one of the functions: msutimer_diff_usecs(), msutimer_diff_msecs(),
  * msutimer_diff_secs(), which return *microseconds*, *millseconds* or *seconds*
  * respectively.
  *
- * Alternatively, the caller may opt to calculate the elapsed time manually, by
- * storing and then subtracting the `double` values returned by 2 calls of the
- * function (similar to how the standard C function `clock()` is used). This
- * also allows for time measurements over multiple calls of the function.
- * The result of the subtraction represents *microseconds*, which can then get
- * passed to the convenience macros MSUT_US2MS() or MSUT_US2S() for converting
- * them to *milliseconds* or *seconds*, respectively.
+ * Alternatively, the caller may opt to calculate the elapsed time manually, by
+ * storing and then subtracting the `double` values returned by 2 calls of the
+ * function (similar to how the standard C function `clock()` is used). This
+ * also allows for time measurements over multiple calls of the function.
+ * The result of the subtraction represents *microseconds*, which can then get
+ * passed to the convenience macros MSUT_US2MS() or MSUT_US2S() for converting
+ * them to *milliseconds* or *seconds*, respectively.
+ *
+ * @param timer
+ *		The timer to be updated.
+ * @return
+ *		A `double`, representing the current time in *microseconds*. Useful for
+ *		calculating manually the time-difference between 2 calls of the function.
+ * @remarks
+ *		Typically, the piece of code to be timed is placed between 2 calls of
+ *		this function. The very first time, the code may also be placed between
+ *		msutimer_new() and this function, but then the manual calculation method
+ *		cannot be used (moreover, the construction validation overhead is added
+ *		to the result).
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_bench(), msutimer_bench_average(), msutimer_bench_median()
+ *
+ * @par Sample Usage
+ *		See [Usage Quick Guide](@ref msut_use) for detailed examples.
+ */
+double msutimer_gettime( MSUTimer *timer )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
+		return -DBL_MAX;
+	}
+
+	MSUTimerTime t2 = timer->t1;	// a failed read yields no time-difference
+	get_msuttime_( timer->source, &t2 );
+	update_diffusecs_( timer, t2 );
+
+	timer->t1 = t2;
+	return msuttime_to_usecs_( timer, timer->t1 );
+}
+
+// ----------------------------------------
+// uint64_t msutimer_now_ticks( const MSUTimer *timer );
+/**
+ * Gets the current time as a raw tick count of the clock source of its timer
+ * argument, without any unit conversion and without updating the timer.
+ *
+ * This is the cheapest way to take a timestamp: the difference of 2 tick counts
+ * (`end - start`, as unsigned integers) can be stored as is, and be converted
+ * to *nanoseconds* with msutimer_ticks_to_ns() only when it gets reported.
+ *
+ * @param timer
+ *		The timer whose clock source is to be read.
+ * @return
+ *		The current tick count, or 0 on error.
+ * @remarks
+ *		Unlike the rest of the functions, this one does **not** reset `errno`
+ *		to 0 on success, to keep it out of the measured code. Tick counts are
+ *		meaningful only to timers created with the same clock source.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_ticks_to_ns(), msutimer_ticks_per_sec(), msutimer_gettime()
+ *
+ * @par Sample Usage
+ * @code
+		MSUTimer *timer = msutimer_new();	// if ( !timer ) { handle error here }
+		...
+		uint64_t start = msutimer_now_ticks( timer );
+		handle_request();
+		uint64_t ticks = msutimer_now_ticks( timer ) - start;
+		...
+		printf( "Elapsed: %.3f nsecs\n", msutimer_ticks_to_ns(timer, ticks) );
+ * @endcode
+ */
+uint64_t msutimer_now_ticks( const MSUTimer *timer )
+{
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: 0" );
+		return 0;
+	}
+
+	MSUTimerTime t = 0;
+	get_msuttime_( timer->source, &t );
+	return t;
+}
+
+// ----------------------------------------
+// uint64_t msutimer_default_ticks( void );
+/**
+ * Gets the current time as a raw tick count of the default clock source
+ * (MSUT_CLOCK_DEFAULT), without needing a timer.
+ *
+ * @return
+ *		The current tick count, or 0 if the clock cannot be read.
+ * @remarks
+ *		The ticks are the same as those of msutimer_now_ticks() on a timer created
+ *		with msutimer_new(), so they can be converted with msutimer_ticks_to_ns().
+ *		Like msutimer_now_ticks(), the function does not touch `errno`. The inline
+ *		functions of `msutimer_inline.h` are even cheaper, when available.
+ * @sa
+ *		msutimer_now_ticks(), msutimer_inline_now_ticks()
+ */
+uint64_t msutimer_default_ticks( void )
+{
+	MSUTimerTime t = 0;
+	get_msuttime_( resolve_clock_(MSUT_CLOCK_DEFAULT), &t );
+	return t;
+}
+
+// ----------------------------------------
+// double msutimer_ticks_to_ns( const MSUTimer *timer, uint64_t ticks );
+/**
+ * Converts a raw tick count (or a difference of tick counts) obtained with
+ * msutimer_now_ticks(), to *nanoseconds*, using the conversion factor that
+ * was precomputed when its timer argument was created.
+ *
+ * @param timer
+ *		The timer that produced the ticks (or any timer using the same clock source).
+ * @param ticks
+ *		The tick count to be converted.
+ * @return
+ *		A `double` representing the ticks in *nanoseconds*, or `-DBL_MAX` on error.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_now_ticks(), msutimer_ticks_per_sec()
+ */
+double msutimer_ticks_to_ns( const MSUTimer *timer, uint64_t ticks )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
+		return -DBL_MAX;
+	}
+	return (double)ticks * timer->nsecs_per_tick;
+}
+
+// ----------------------------------------
+// uint64_t msutimer_ticks_per_sec( const MSUTimer *timer );
+/**
+ * Queries its timer argument for the frequency of its clock source.
+ *
+ * @param timer
+ *		The timer to be queried.
+ * @return
+ *		The number of ticks per second (e.g. 1000000000 for *nanosecond* ticks),
+ *		or 0 on error.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_now_ticks(), msutimer_ticks_to_ns()
+ */
+uint64_t msutimer_ticks_per_sec( const MSUTimer *timer )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: 0" );
+		return 0;
+	}
+	return timer->freq;
+}
+
+// ----------------------------------------
+// double msutimer_diff_usecs( MSUTimer *timer );
+/**
+ * Queries its timer argument for the updated time-difference, after a call to
+ * msutimer_gettime(). Calling this function before calling msutimer_gettime()
+ * first, results to a random value (bogus time-difference).
+ *
+ * @param timer
+ *		The timer to be queried.
+ * @return
+ *		A `double` reflecting the updated time-difference in *microseconds*
+ *		after a call to msutimer_gettime(),	or `-DBL_MAX` on error.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_diff_msecs(), msutimer_diff_secs(), [Usage Quick Guide](@ref msut_use)
+ *
+ * @par Sample Usage
+ * @code
+ 		MSUTimer *timer = msutimer_new();	// if ( !timer1 ) { handle error here }
+ 		...
+		msutimer_gettime( timer );
+		printf( "Elapsed: %.9lf usecs\n", msutimer_diff_usecs(timer) );
+		...
+		msutimer_gettime( timer );
+		printf( "Elapsed: %.9lf usecs\n", msutimer_diff_usecs(timer) );
+ 		msutimer_free( timer );
+ * @endcode
+ */
+double msutimer_diff_usecs( MSUTimer *timer )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
+		return -DBL_MAX;
+	}
+	return timer->diffusecs;
+}
+
+// ----------------------------------------
+// double msutimer_diff_msecs(MSUTimer *timer);
+/**
+ * Queries its timer argument for the updated time-difference, after a call to
+ * msutimer_gettime(). Calling this function before calling msutimer_gettime()
+ * first, results to a random value (bogus time-difference).
+ *
+ * @param timer
+ *		The timer to be queried.
+ * @return
+ *		A `double` reflecting the updated time-difference in *milliseconds*
+ *		after a call to msutimer_gettime(), or `-DBL_MAX` on error.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_diff_usecs(), msutimer_diff_secs(), [Usage Quick Guide](@ref msut_use)
+ */
+double msutimer_diff_msecs( MSUTimer *timer )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
+		return -DBL_MAX;
+	}
+	return 0.001 * timer->diffusecs;
+}
+
+// ----------------------------------------
+// double msutimer_diff_secs( MSUTimer *timer );
+/**
+ * Queries its timer argument for the updated time-difference, after a call to
+ * msutimer_gettime(). Calling this function before calling msutimer_gettime()
+ * first, results to a random value (bogus time-difference).
+ *
+ * @param timer
+ *		The timer to be queried.
+ * @return
+ *		A `double` reflecting the updated time-difference in *seconds* after
+ *		a call to msutimer_gettime(), or `-DBL_MAX` on error.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_diff_usecs(), msutimer_diff_msecs(), [Usage Quick Guide](@ref msut_use)
+ */
+double msutimer_diff_secs( MSUTimer *timer )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
+		return -DBL_MAX;
+	}
+	return 0.000001 * timer->diffusecs;
+}
+
+// ----------------------------------------
+// MSUTimerClock msutimer_clock( const MSUTimer *timer );
+/**
+ * Queries its timer argument for the clock source it reads.
+ *
+ * @param timer
+ *		The timer to be queried.
+ * @return
+ *		The ::MSUTimerClock the timer was created with, with MSUT_CLOCK_DEFAULT
+ *		(and sources the platform does not distinguish) resolved to the clock
+ *		source that is actually read, or MSUT_NCLOCKS on error.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_new_ex(), msutimer_clock_name()
+ */
+MSUTimerClock msutimer_clock( const MSUTimer *timer )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: MSUT_NCLOCKS" );
+		return MSUT_NCLOCKS;
+	}
+	return timer->source;
+}
+
+// ----------------------------------------
+// const char *msutimer_clock_name( MSUTimerClock source );
+/**
+ * Gets a short, human-readable name for a clock source.
+ *
+ * @param source
+ *		The clock source.
+ * @return
+ *		A pointer to a static, read-only string (e.g. `"monotonic"`).
+ *		Invalid clock sources yield `"unknown"`.
+ * @sa
+ *		msutimer_clock()
+ */
+const char *msutimer_clock_name( MSUTimerClock source )
+{
+	static const char *names[MSUT_NCLOCKS] = {
+		[MSUT_CLOCK_DEFAULT]		= "default",
+		[MSUT_CLOCK_MONOTONIC]		= "monotonic",
+		[MSUT_CLOCK_MONOTONIC_RAW]	= "monotonic_raw",
+		[MSUT_CLOCK_REALTIME]		= "realtime",
+		[MSUT_CLOCK_PORTABLE]		= "portable",
+		[MSUT_CLOCK_TSC]			= "tsc",
+		[MSUT_CLOCK_PROCESS_CPU]	= "process_cpu",
+		[MSUT_CLOCK_THREAD_CPU]		= "thread_cpu"
+	};
+	if ( (unsigned)source >= MSUT_NCLOCKS ) {
+		return "unknown";
+	}
+	return names[source];
+}
+
+// ----------------------------------------
+// double msutimer_accuracy_usecs( MSUTimer *timer )
+/**
+ * Obtains the minimum time-interval that can be measured by *MSUTimer*, on
+ * the running platform. The returned *microseconds* can be converted to
+ * *milliseconds* or *seconds*, with the convenience macros MSUT_US2MS() or
+ * MSUT_US2S(), respectively.
+ *
+ * @param timer
+ *		Any already created timer.
+ * @return
+ *		A `double` representing the *MSUTimer* accuracy on the current platform
+ *		in *microseconds*, or `-DBL_MAX` on error.
+ * @remarks
+ *		On Windows, a typical accuracy is around 0.320 *microseconds*.
+ *		Occasionally the function may return a bogus value, but it is pretty
+ *		rare (and I really don't know why it's doing that).
+ *
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		[Platform Dependent Measurements](@ref msut_pdm)
+ *
+ * @par Sample Usage
+ * @code
+		#include "msutimer.h"
+		...
+		int main( void ) {
+			MSUTimer *timer = msutimer_new();
+			if (!timer) { fputs("msutimer_new()failed!\n", stderr); exit(1); }
+
+			double usecs = msutimer_accuracy_usecs(timer);
+			printf( "MSUTimer accuracy: %.9.lf secs\n", MSUT_US2S(usecs) );
+			printf( "MSUTimer accuracy: %.9.lf msecs\n", MSUT_US2MS(usecs) );
+			printf( "MSUTimer accuracy: %.9.lf usecs\n", usecs );
+
+			msutimer_free( timer );
+			exit(0);
+		}
+		// Output -------------
+		// MSUTimer accuracy: 0.000000320 secs
+		// MSUTimer accuracy: 0.000320801 msecs
+		// MSUTimer accuracy: 0.320312500 usecs
+ * @endcode
+ */
+// ----------------------------------------
+// DUNNO WHY, but with MingW32 it sometimes gives bogus result, especially
+// with gettimeofday() and clock(). IS NOT tested with other compilers.
+//
+double msutimer_accuracy_usecs( MSUTimer *timer )
+{
+	errno = 0;
+	if ( !timer ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
+		return -DBL_MAX;
+	}
+
+	double t1 = msutimer_gettime( timer );
+	double t2 = t1;
+	for ( ;; ) {
+		if ( (t2 = msutimer_gettime(timer)) > t1 ) {
+			break;
+		}
+	}
+	return t2 - t1;
+}
+
+// ----------------------------------------
+// bool msutimer_set_warmup( MSUTimer *timer, size_t niters, double usecs );
+/**
+ * Configures the warm-up phase of the benchmark functions of its timer argument.
+ *
+ * Before recording anything, the benchmark functions then execute the
+ * callback-function (untimed) for at least `niters` iterations, and for at
+ * least `usecs` *microseconds*, so that cold caches, page faults, branch
+ * predictor training and CPU frequency ramp-up are left out of the results.
+ * There is no warm-up by default.
+ *
+ * @param timer
+ *		The timer to be modified.
+ * @param niters
+ *		The minimum number of warm-up iterations (0 for no minimum).
+ * @param usecs
+ *		The minimum warm-up time in *microseconds* (0.0 for no minimum).
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		A callback-function failure during warm-up makes the benchmark function
+ *		fail as if it failed at its very first iteration: those returning a time
+ *		return -0.0 with `errno` set to `ECANCELED` (see msutimer_bench()), the
+ *		others return `false` (or a failed result). The warm-up applies to
+ *		all single-threaded benchmark functions; msutimer_warmup_iters() reports
+ *		how many warm-up iterations the latest one made.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- usecs is negative (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_set_steady_state(), msutimer_warmup_iters()
+ */
+bool msutimer_set_warmup( MSUTimer *timer, size_t niters, double usecs )
+{
+	errno = 0;
+	if ( !timer || !(usecs >= 0.0) ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL or usecs < 0). Return: false" );
+		return false;
+	}
+	timer->warmup_iters = niters;
+	timer->warmup_usecs = usecs;
+	return true;
+}
+
+// ----------------------------------------
+// bool msutimer_set_steady_state( MSUTimer *timer, size_t window, double max_cv, double budget_usecs );
+/**
+ * Enables (or disables) steady-state detection at the end of the warm-up phase
+ * of the benchmark functions of its timer argument (see msutimer_set_warmup()).
+ *
+ * After the fixed warm-up, the benchmark functions keep timing the
+ * callback-function until the coefficient of variation (standard deviation
+ * over mean) of the latest `window` samples falls to `max_cv` or below, or
+ * until `budget_usecs` *microseconds* have elapsed, whichever comes first.
+ * Only then they start recording.
+ *
+ * @param timer
+ *		The timer to be modified.
+ * @param window
+ *		The number of samples of the sliding window (it must be at least 2,
+ *		or 0 to disable steady-state detection).
+ * @param max_cv
+ *		The coefficient of variation to reach (e.g. 0.05 for 5%).
+ * @param budget_usecs
+ *		The maximum time spent on steady-state detection, in *microseconds*.
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		Whether steady-state was reached is reported by the `steady` member of
+ *		::MSUTimerStats (msutimer_bench_stats()). Samples taken during the
+ *		detection are counted as warm-up iterations.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- window is 1, or max_cv or budget_usecs is negative (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_set_warmup(), msutimer_warmup_iters()
+ */
+bool msutimer_set_steady_state( MSUTimer *timer, size_t window, double max_cv, double budget_usecs )
+{
+	errno = 0;
+	if ( !timer || 1 == window || !(max_cv >= 0.0) || !(budget_usecs >= 0.0) ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer, window, max_cv or budget_usecs). Return: false" );
+		return false;
+	}
+	timer->steady_window = window;
+	timer->steady_cv = max_cv;
+	timer->steady_usecs = budget_usecs;
+	return true;
+}
+
+// ----------------------------------------
+// size_t msutimer_warmup_iters( const MSUTimer *timer );
+/**
+ * Queries its timer argument for the number of warm-up iterations made by its
+ * latest benchmark run (including those of steady-state detection).
+ *
+ * @param timer
+ *		The timer to be queried.
+ * @return
+ *		The number of warm-up iterations, or 0 on error.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_set_warmup(), msutimer_set_steady_state()
+ */
+size_t msutimer_warmup_iters( const MSUTimer *timer )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: 0" );
+		return 0;
+	}
+	return timer->nwarmup;
+}
+
+// ----------------------------------------
+// double msutimer_overhead_usecs( const MSUTimer *timer );
+/**
+ * Queries its timer argument for the cost of an empty timed region, i.e. of
+ * the 2 clock reads that surround every sample of the benchmark functions.
+ * It is measured once per clock source, when the first timer reading it gets
+ * created (as the median of `MSUT_OVERHEAD_SAMPLES` empty regions, 101 by
+ * default).
+ *
+ * @param timer
+ *		The timer to be queried.
+ * @return
+ *		A `double` representing the timer overhead in *microseconds*, or
+ *		`-DBL_MAX` on error.
+ * @remarks
+ *		On clocks coarser than the overhead (e.g. MSUT_CLOCK_REALTIME) the
+ *		overhead is typically measured as 0.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_subtract_overhead(), msutimer_accuracy_usecs()
+ */
+double msutimer_overhead_usecs( const MSUTimer *timer )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
+		return -DBL_MAX;
+	}
+	return timer->overhead_ticks * timer->usecs_per_tick;
+}
+
+// ----------------------------------------
+// bool msutimer_subtract_overhead( MSUTimer *timer, bool enable );
+/**
+ * Enables or disables the subtraction of the timer overhead (see
+ * msutimer_overhead_usecs()) from the samples recorded by the benchmark
+ * functions of its timer argument. It is disabled by default.
+ *
+ * When enabled, msutimer_bench_average() and msutimer_bench_median() subtract
+ * the overhead from every per-iteration sample, and msutimer_bench() from its
+ * total, so the results for tiny callbacks are not dominated by the timer
+ * itself. Samples never go below 0.
+ *
+ * @param timer
+ *		The timer to be modified.
+ * @param enable
+ *		`true` to subtract the overhead, `false` to record raw samples.
+ * @return
+ *		The previous setting, or `false` on error.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_overhead_usecs(), [Benchmarking](@ref msut_bench)
+ */
+bool msutimer_subtract_overhead( MSUTimer *timer, bool enable )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: false" );
+		return false;
+	}
+	bool ret = timer->subtract_overhead;
+	timer->subtract_overhead = enable;
+	return ret;
+}
+
+// ----------------------------------------
+// double msutimer_bench( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat );
+/**
+ * Measures the execution time of its callback-function argument, after a
+ * specified number of iterations. 
+ *
+ * @param timer
+ *		An already created timer.
+ * @param nrepeats
+ *		The number of times to execute the callback-function (iterations).
+ * @param callback
+ *		The callback-function to be measured. It should be of type `bool` (C99)
+ *		returning `false` on error, `true` otherwise. Its prototype should be
+ *		the following:
+ * @code
+		bool (*callback)(void *userdata);
+ * @endcode
+ * @param userdata
+ *		A `void` pointer to caller-defined data, used by the callback-function.
+ *		This pointer gets directly passed to the callback-function without any
+ *		processing. It may be `NULL` if the callback-functions doesn't use any
+ *		extra data.
+ * @param erepeat
+ *		If non-`NULL`, then in case of callback error (`false`) `erepeat` passes
+ *		back to the caller the last successful iteration.
+ * @return
+ *		A `double` representing the time spent (in *microseconds*) to execute
+ *		the callback-function `nrepeats` times.
+ *
+ *		If the callback-function errors before completing `nrepeats` iterations,
+ *		then the returned value is	**negative** and `erepeat` (if non-`NULL`)
+ *		passes back to the caller the last successful iteration. Hence a negative
+ *		return value reflects the number of *microseconds* elpased until the
+ *		`erepeat`'th iteration. If there is no elapsed time to report (e.g. the
+ *		callback-function failed during warm-up), the function returns -0.0 and
+ *		sets `errno` to `ECANCELED`.
+ *
+ *		On all other errors, `errno` is set to `EDOM` and the function returns 0.0
+ *
+ * @remarks
+ * 		- When the function returns 0.0 (or -0.0, which compares equal to it),
+ * 		  the caller can tell if there was an error by checking `errno` against
+ * 		  `EDOM` or `ECANCELED` (or not being 0). In *MSUTimer* debug
+ * 		  mode (e.g. compiled with `-DMSUTDEBUG` or `-DMSUTDEBUG=2`) errors are
+ * 		  auto reported to `stderr`.
+ * 		- The return value can be converted to *milliseconds* or *seconds* with
+ * 		  the convenience macros MSUT_US2MS() or MSUT_US2S(), respectively.
+ * 		- For an example (without error-handling) see the section
+ * 		  [Benchmarking](@ref msut_bench).
+ *
+ * @par Failures:
+ * 		- timer is `NULL` (returns 0.0, `errno` is set to `EDOM`)
+ * 		- nrepeats is 0 (returns 0.0, `errno` is set to `EDOM`)
+ * 		- callback is `NULL` (returns 0.0, `errno` is set to `EDOM`)
+ * 		- callback returns `false` (`erepeat` is set to the last successful
+ * 	      iteration and the function returns the elapsed *microseconds* until
+ *		  then, as a negative `double`; -0.0 with `errno` set to `ECANCELED` if
+ *		  there are none).
+ * @sa
+ *		msutimer_bench_average(), msutimer_bench_median(), [Benchmarking](@ref msut_bench)
+ */
+double msutimer_bench( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat )
+{
+	errno = 0;
+
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( !callback ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( nrepeats == 0 ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nrepeats=0. Returned 0 secs." );
+		return 0.0;
+	}
+
+	if ( !warmup_( timer, callback, userdata ) ) {
+		if ( erepeat ) {
+			*erepeat = 0;
+		}
+		return failed_zero_();
+	}
+
+	if ( erepeat ) {
+		*erepeat = 0;	// reset
+	}
+
+	double bias = 1.0;
+	double t = msutimer_gettime( timer );
+	for (size_t i=0; i < nrepeats; i++) {
+		if ( !callback( userdata ) ) {
+			if ( erepeat ) {
+				*erepeat = i;
+			}
+			bias = -1.0;
+			MSUT_DBGMSG(
+				"WARNING",
+				"Requested iterations: %zu, but FAILED at %zu (erepeat).\n"
+				"==> Returned: elapsed secs until then (with negative sign).\n",
+				nrepeats,
+				i);
+			break;
+		}
+	}
+
+	t = msutimer_gettime(timer) - t;
+	if ( timer->subtract_overhead ) {
+		t -= timer->overhead_ticks * timer->usecs_per_tick;
+		t = (t < 0.0) ? 0.0 : t;
+	}
+	if ( bias < 0.0 && 0.0 == t ) {
+		return failed_zero_();
+	}
+	return bias * t;
+}
+
+// ----------------------------------------
+// double msutimer_bench_average( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat );
+/**
+ * Measures the average execution time of its callback-function argument, after
+ * a specified number of iterations. 
+ *
+ * @remarks
+ *		For details see the function msutimer_bench(). The only difference
+ *		is that msutimer_bench_average() returns the average time after `nrepeats`
+ *		iterations, instead of summing up all iterations.
+ *
+ *		Put otherwise, msutimer_bench() returns the total time after `nrepeats`
+ *		iterations, while msutimer_bench_average() returns the average time of
+ *		a single call after `nrepeats` iterations.
+ *
+ *		Compared to msutimer_bench_median(), this function accounts excessive
+ *		spikes in the computation ([average vs. median](https://www.diffen.com/difference/Mean_vs_Median)).
+ *
+ * @sa
+ *		msutimer_bench(), msutimer_bench_median(), [Benchmarking](@ref msut_bench)
+ */
+double msutimer_bench_average( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat )
+{
+	errno = 0;
+
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( !callback ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( nrepeats == 0 ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nrepeats=0. Returned 0 secs." );
+		return 0.0;
+	}
+
+	if ( !warmup_( timer, callback, userdata ) ) {
+		if ( erepeat ) {
+			*erepeat = 0;
+		}
+		return failed_zero_();
+	}
+
+	// run callback nrepeats times and time the average
+	double bias = 1.0;
+	double sum = 0;
+	MSUTimerTime t;
+	for (size_t i=0; i < nrepeats; i++) {
+		if ( !sample_ticks_( timer, callback, userdata, &t ) ) {
+			if ( erepeat ) {
+				*erepeat = i;
+			}
+			bias = -1.0;
+			MSUT_DBGMSG(
+				"WARNING",
+				"Requested iterations: %zu, but FAILED at %zu (erepeat).\n"
+				"==> Returned: average secs until then (with negative sign).\n",
+				nrepeats,
+				i+1
+				);
+			nrepeats = i;	// # of successful iterations before failure
+			break;
+		}
+		sum += sample_to_usecs_( timer, t );
+	}
+
+	if ( bias < 0.0 && 0.0 == sum ) {
+		return failed_zero_();
+	}
+	return bias * sum / nrepeats;
+}
+
+// ----------------------------------------
+// double msutimer_bench_median( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat );
+/**
+ * Measures the median execution time of its callback-function argument, after
+ * a specified number of iterations. 
+ *
+ * @remarks
+ *		For details see the function msutimer_bench(). The only difference
+ *		is that msutimer_bench_median() returns the median time after `nrepeats`
+ *		iterations, instead of summing up all iterations.
+ *
+ *		Put otherwise, msutimer_bench() returns the total time after `nrepeats`
+ *		iterations, while msutimer_bench_median() returns the median time of
+ *		a single call after `nrepeats` iterations.
+ *
+ *		Compared to msutimer_bench_average(), this function ignores excessive
+ *		spikes in the computation ([average vs. median](https://www.diffen.com/difference/Mean_vs_Median)).
+ *
+ *		The median is extracted with a selection algorithm (linear time on
+ *		average), not by sorting all `nrepeats` samples. For an even number of
+ *		samples it is the average of the 2 middle ones.
+ *
+ * @sa
+ *		msutimer_bench(), msutimer_bench_median(), [Benchmarking](@ref msut_bench)
+ */
+double msutimer_bench_median( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat )
+{
+	errno = 0;
+
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( !callback ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( nrepeats == 0 ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nrepeats=0. Returned 0 secs." );
+		return 0.0;
+	}
+
+	if ( !warmup_( timer, callback, userdata ) ) {
+		if ( erepeat ) {
+			*erepeat = 0;
+		}
+		return failed_zero_();
+	}
+
+	// array of recorded times
+	double *rectimes = acquire_samples_( timer, nrepeats );
+	if ( !rectimes ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "Sample buffer allocation failed! Returned: 0 secs." );
+		return 0.0;
+	}
+
+	double ret = record_median_( timer, nrepeats, callback, userdata, erepeat, rectimes );
+
+	release_samples_( timer, rectimes );
+	return ( 0.0 == ret && signbit(ret) ) ? failed_zero_() : ret;
+}
+
+// ----------------------------------------
+// double msutimer_bench_median_buf( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat, double *samples );
+/**
+ * Measures the median execution time of its callback-function argument, after
+ * a specified number of iterations, recording the samples into a caller-supplied
+ * buffer.
+ *
+ * @param samples
+ *		A caller-owned array of at least `nrepeats` doubles. On return, it holds
+ *		the recorded samples in *microseconds*, in unspecified order (only the
+ *		successful iterations, if the callback-function failed).
+ * @remarks
+ *		For the rest of the arguments, the return value and the failures see
+ *		msutimer_bench_median(). The only difference is that no memory gets
+ *		allocated, so repeated benchmark runs in a long-lived process may
+ *		reuse the same (already touched, hence pre-faulted) buffer.
+ *
+ *		Alternatively, msutimer_reserve_samples() keeps such a buffer inside
+ *		the timer, for msutimer_bench_median() to use.
+ * @par Failures:
+ * 		- samples is `NULL` (returns 0.0, `errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_bench_median(), msutimer_reserve_samples()
+ */
+double msutimer_bench_median_buf( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat, double *samples )
+{
+	errno = 0;
+
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( !callback ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( !samples ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to samples=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( nrepeats == 0 ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nrepeats=0. Returned 0 secs." );
+		return 0.0;
+	}
+
+	if ( !warmup_( timer, callback, userdata ) ) {
+		if ( erepeat ) {
+			*erepeat = 0;
+		}
+		return failed_zero_();
+	}
+
+	double ret = record_median_( timer, nrepeats, callback, userdata, erepeat, samples );
+	return ( 0.0 == ret && signbit(ret) ) ? failed_zero_() : ret;
+}
+
+// ----------------------------------------
+// bool msutimer_reserve_samples( MSUTimer *timer, size_t nsamples );
+/**
+ * Reserves a pre-faulted sample buffer inside its timer argument, so that the
+ * benchmark functions that record per-iteration samples (msutimer_bench_median(),
+ * msutimer_bench_auto()) do not allocate memory for up to `nsamples` samples.
+ *
+ * Without a reserved buffer, every such call allocates and frees its own
+ * buffer, which costs page faults on fresh memory during the first samples.
+ * The reserved buffer is written once by this function, so its pages are
+ * already mapped when the samples get recorded.
+ *
+ * @param timer
+ *		The timer to be modified.
+ * @param nsamples
+ *		The number of samples to reserve room for. Calls with a larger `nrepeats`
+ *		keep allocating their own buffer. Passing 0 releases the reserved buffer.
+ * @return
+ *		`true` on success, `false` on error (the previously reserved buffer,
+ *		if any, is kept).
+ * @remarks
+ *		The buffer is released by msutimer_free().
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- memory allocation failure (`errno` is set by the C runtime)
+ * @sa
+ *		msutimer_bench_median(), msutimer_bench_median_buf()
+ */
+bool msutimer_reserve_samples( MSUTimer *timer, size_t nsamples )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: false" );
+		return false;
+	}
+
+	if ( 0 == nsamples ) {
+		free( timer->samples );
+		timer->samples = NULL;
+		timer->nsamples = 0;
+		return true;
+	}
+
+	if ( nsamples > timer->nsamples ) {
+		double *samples = malloc( nsamples * sizeof(double) );
+		if ( !samples ) {
+			MSUT_DBGMSG( "ERROR", "malloc(%zu) failed! Return: false\n", nsamples * sizeof(double) );
+			return false;
+		}
+		free( timer->samples );
+		timer->samples = samples;
+		timer->nsamples = nsamples;
+	}
+
+	// pre-fault: touch every page of the buffer
+	memset( timer->samples, 0, timer->nsamples * sizeof(double) );
+	return true;
+}
+
+// ----------------------------------------
+// double msutimer_bench_auto( MSUTimer *timer, size_t nbatches, bool (*callback)(void *), void *userdata, size_t *erepeat, size_t *batchsize );
+/**
+ * Measures the median execution time of its callback-function argument, when
+ * a single call may be too short for the clock to measure.
+ *
+ * The callback-function is first called in batches of growing size (1, 2, 4, ...)
+ * until a single batch takes at least `MSUT_AUTO_ACCURACY_FACTOR` (100 by default)
+ * times the timer accuracy (see msutimer_accuracy_usecs()). Then `nbatches`
+ * batches of that size are timed, and the returned value is their median time
+ * divided by the batch size.
+ *
+ * @param timer
+ *		An already created timer.
+ * @param nbatches
+ *		The number of batches to be timed.
+ * @param callback
+ *		The callback-function to be measured (see msutimer_bench()).
+ * @param userdata
+ *		A `void` pointer to caller-defined data, used by the callback-function
+ *		(see msutimer_bench()).
+ * @param erepeat
+ *		If non-`NULL`, then in case of callback error (`false`) `erepeat` passes
+ *		back to the caller the number of successful calls in the timed batches.
+ * @param batchsize
+ *		If non-`NULL`, it passes back to the caller the batch size that was used
+ *		(the number of calls per batch).
+ * @return
+ *		A `double` representing the median time (in *microseconds*) of a single
+ *		call of the callback-function.
+ *
+ *		If the callback-function errors before all batches are timed, then the
+ *		returned value is **negative**, reflecting the median of the completed
+ *		batches (-0.0 with `errno` set to `ECANCELED` if none was completed).
+ *		On all other errors, `errno` is set to `EDOM` and the function returns
+ *		0.0
+ * @remarks
+ *		This is how statistical benchmark harnesses get stable numbers for very
+ *		short functions (e.g. hashing or parsing small inputs). If overhead
+ *		subtraction is enabled (see msutimer_subtract_overhead()), the overhead
+ *		is subtracted once per batch. The batch size never exceeds
+ *		`MSUT_AUTO_MAX_BATCH`.
+ * @par Failures:
+ * 		- timer is `NULL` (returns 0.0, `errno` is set to `EDOM`)
+ * 		- nbatches is 0 (returns 0.0, `errno` is set to `EDOM`)
+ * 		- callback is `NULL` (returns 0.0, `errno` is set to `EDOM`)
+ * 		- memory allocation failure (returns 0.0, `errno` is set by the C runtime)
+ * 		- callback returns `false` (see above)
+ * @sa
+ *		msutimer_bench_median(), msutimer_accuracy_usecs(), [Benchmarking](@ref msut_bench)
+ */
+double msutimer_bench_auto( MSUTimer *timer, size_t nbatches, bool (*callback)(void *), void *userdata, size_t *erepeat, size_t *batchsize )
+{
+	errno = 0;
+
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( !callback ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( nbatches == 0 ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nbatches=0. Returned 0 secs." );
+		return 0.0;
+	}
+
+	if ( !warmup_( timer, callback, userdata ) ) {
+		if ( erepeat ) {
+			*erepeat = 0;
+		}
+		return failed_zero_();
+	}
+
+	if ( erepeat ) {
+		*erepeat = 0;	// reset
+	}
+
+	// array of recorded per-call times
+	double *rectimes = acquire_samples_( timer, nbatches );
+	if ( !rectimes ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "Sample buffer allocation failed! Returned: 0 secs." );
+		return 0.0;
+	}
+
+	// grow the batch until it lasts well above the clock resolution
+	double target = MSUT_AUTO_ACCURACY_FACTOR * msutimer_accuracy_usecs( timer ) / timer->usecs_per_tick;
+	size_t batch = 1;
+	size_t done;
+	MSUTimerTime t;
+	for (;;) {
+		if ( !sample_batch_ticks_( timer, batch, callback, userdata, &t, &done ) ) {
+			MSUT_DBGMSG(
+				"WARNING",
+				"FAILED while sizing the batches, at batch size %zu.\n",
+				batch
+				);
+			release_samples_( timer, rectimes );
+			if ( batchsize ) {
+				*batchsize = batch;
+			}
+			return failed_zero_();
+		}
+		if ( (double)t >= target || batch >= MSUT_AUTO_MAX_BATCH ) {
+			break;
+		}
+		batch *= 2;
+	}
+	if ( batchsize ) {
+		*batchsize = batch;
+	}
+
+	// record nbatches timings
+	double bias = 1.0;
+	for (size_t i=0; i < nbatches; i++) {
+		if ( !sample_batch_ticks_( timer, batch, callback, userdata, &t, &done ) ) {
+			if ( erepeat ) {
+				*erepeat = i * batch + done;
+			}
+			bias = -1.0;
+			MSUT_DBGMSG(
+				"WARNING",
+				"Requested batches: %zu, but FAILED at %zu (erepeat: %zu).\n"
+				"==> Returned: median secs until then (with negative sign).\n",
+				nbatches,
+				i+1,
+				i * batch + done
+				);
+			nbatches = i;	// # of successful batches before failure
+			break;
+		}
+		rectimes[i] = sample_to_usecs_( timer, t ) / (double)batch;
+	}
+
+	double ret = median_of_doubles_( rectimes, nbatches );
+
+	release_samples_( timer, rectimes );
+	if ( bias < 0.0 && 0.0 == ret ) {
+		return failed_zero_();
+	}
+	return bias * ret;
+}
+
+// ----------------------------------------
+// bool msutimer_bench_stats( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, MSUTimerStats *stats );
+/**
+ * Measures the execution time statistics of its callback-function argument,
+ * from a single run of a specified number of iterations.
+ *
+ * Instead of running the callback-function 3 times with msutimer_bench(),
+ * msutimer_bench_average() and msutimer_bench_median(), a single sampling pass
+ * fills an ::MSUTimerStats with the total, minimum, maximum, mean, standard
+ * deviation, median, 90th/99th/99.9th percentiles and the median absolute
+ * deviation of the per-iteration times. The moments are accumulated online
+ * (Welford's method) while sampling, and the order statistics are extracted
+ * with linear-time selections.
+ *
+ * @param timer
+ *		An already created timer.
+ * @param nrepeats
+ *		The number of times to execute the callback-function (iterations).
+ * @param callback
+ *		The callback-function to be measured (see msutimer_bench()).
+ * @param userdata
+ *		A `void` pointer to caller-defined data, used by the callback-function
+ *		(see msutimer_bench()).
+ * @param stats
+ *		The statistics to be filled. If the callback-function fails, they
+ *		reflect the successful iterations until then, `stats->failed` is
+ *		`true` and `stats->erepeat` is the iteration it failed at.
+ * @return
+ *		`true` if all `nrepeats` iterations were timed, `false` otherwise.
+ * @remarks
+ *		Like msutimer_bench_median(), the samples are recorded in the buffer
+ *		reserved with msutimer_reserve_samples(), if it is large enough.
+ *		Overhead subtraction (see msutimer_subtract_overhead()) applies to
+ *		every sample.
+ *
+ *		Whatever the clock source of the timer, the whole sampling pass is also
+ *		timed on both the wall-clock and the CPU time of the calling thread
+ *		(`stats->wall_usecs` and `stats->cpu_usecs`, including the cost of the
+ *		sampling itself). A `stats->cpu_ratio` clearly below 1.0 means that
+ *		the thread was descheduled (or blocked) during the run, so its
+ *		wall-clock samples include scheduler interference.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- nrepeats is 0 (`errno` is set to `EDOM`)
+ * 		- callback is `NULL` (`errno` is set to `EDOM`)
+ * 		- stats is `NULL` (`errno` is set to `EDOM`)
+ * 		- memory allocation failure (`errno` is set by the C runtime)
+ * 		- callback returns `false` (see above)
+ * @sa
+ *		msutimer_bench(), msutimer_bench_average(), msutimer_bench_median()
+ *
+ * @par Sample Usage
+ * @code
+		MSUTimerStats st;
+		if ( !msutimer_bench_stats(timer, 100000, parse_cb, &input, &st) ) {
+			handle error here
+		}
+		printf( "median: %.3f usecs, p99: %.3f usecs\n", st.median, st.p99 );
+ * @endcode
+ */
+bool msutimer_bench_stats( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, MSUTimerStats *stats )
+{
+	errno = 0;
+
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: false" );
+		return false;
+	}
+	if ( !callback ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: false" );
+		return false;
+	}
+	if ( !stats ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to stats=NULL. Return: false" );
+		return false;
+	}
+	if ( nrepeats == 0 ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nrepeats=0. Return: false" );
+		return false;
+	}
+
+	memset( stats, 0, sizeof(*stats) );
+
+	bool warm = warmup_( timer, callback, userdata );
+	stats->nwarmup = timer->nwarmup;
+	stats->steady = timer->steady;
+	if ( !warm ) {
+		stats->failed = true;
+		return false;
+	}
+
+	// array of recorded times
+	double *rectimes = acquire_samples_( timer, nrepeats );
+	if ( !rectimes ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "Sample buffer allocation failed! Return: false" );
+		return false;
+	}
+
+	// record nrepeats timings, accumulating the moments on the fly
+	Welford_ w;
+	welford_reset_( &w );
+	MSUTimerTime t, cpuwall[2];
+	cpu_wall_begin_( cpuwall );
+	for (size_t i=0; i < nrepeats; i++) {
+		if ( !sample_ticks_( timer, callback, userdata, &t ) ) {
+			stats->failed = true;
+			stats->erepeat = i;
+			MSUT_DBGMSG(
+				"WARNING",
+				"Requested iterations: %zu, but FAILED at %zu (erepeat).\n"
+				"==> Returned: stats until then.\n",
+				nrepeats,
+				i+1
+				);
+			break;
+		}
+		rectimes[i] = sample_to_usecs_( timer, t );
+		welford_add_( &w, rectimes[i] );
+	}
+	cpu_wall_end_( cpuwall, stats );
+
+	finish_stats_( stats, &w, rectimes );
+	perf_get_( timer->perf, &stats->counters );
+	alloc_get_( &timer->alloc, &stats->allocs );
+	stats->env = timer->env;
+
+	release_samples_( timer, rectimes );
+	return !stats->failed;
+}
+
+// ----------------------------------------
+// MSUTimerHist *msutimer_hist_new( double max_usecs, int sigdigits );
+/**
+ * Constructs a new, empty histogram of time values. De-allocation should be
+ * done by the caller, with msutimer_hist_free().
+ *
+ * Values are stored as integer *nanoseconds* in log-linear buckets (as in
+ * HdrHistogram), so the memory footprint is fixed at creation, regardless of
+ * how many values get recorded, while every value is tracked with `sigdigits`
+ * significant decimal digits. This allows percentiles to be reported after
+ * runs of any length (e.g. 100M-iteration soak tests, or production code paths
+ * instrumented for hours), which storing every sample cannot afford.
+ *
+ * @param max_usecs
+ *		The highest value (in *microseconds*) to be tracked precisely. Larger
+ *		values are recorded as `max_usecs`.
+ * @param sigdigits
+ *		The number of significant decimal digits, from 1 to 5.
+ * @return
+ *		The newly allocated histogram, or `NULL` on error.
+ * @remarks
+ *		The footprint grows linearly with the number of powers of 2 up to
+ *		`max_usecs`, and about 8-fold with each extra digit of precision.
+ *		Tracking up to 1 hour takes about 5 KB with 1 significant digit,
+ *		37 KB with 2, and 270 KB with 3 (see msutimer_hist_footprint()).
+ * @par Failures:
+ * 		- max_usecs is less than 0.001 (`errno` is set to `EDOM`)
+ * 		- sigdigits is not between 1 and 5 (`errno` is set to `EDOM`)
+ * 		- memory allocation failure (`errno` is set by the C runtime)
+ *
+ * @par Sample Usage
+ * @code
+		MSUTimerHist *hist = msutimer_hist_new( 1000000.0, 2 );	// up to 1 sec
+		if ( !hist ) { handle error here }
+		...
+		msutimer_gettime( timer );
+		handle_request();
+		msutimer_gettime( timer );
+		msutimer_hist_record( hist, msutimer_diff_usecs(timer) );
+		...
+		printf( "p99: %.3f usecs\n", msutimer_hist_percentile(hist, 99.0) );
+		msutimer_hist_free( hist );
+ * @endcode
+ */
+MSUTimerHist *msutimer_hist_new( double max_usecs, int sigdigits )
+{
+	errno = 0;
+
+	if ( !(max_usecs >= 0.001) ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "(EDOM) function parameter (max_usecs=%g). Return: NULL\n", max_usecs );
+		return NULL;
+	}
+	if ( sigdigits < 1 || sigdigits > 5 ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "(EDOM) function parameter (sigdigits=%d). Return: NULL\n", sigdigits );
+		return NULL;
+	}
+
+	uint64_t highest = (max_usecs * 1000.0 >= (double)(UINT64_MAX / 4)) ? UINT64_MAX / 4 : (uint64_t)(max_usecs * 1000.0);
+	highest = (highest < 2) ? 2 : highest;
+
+	// sub-buckets: the smallest power of 2 >= 2 * 10^sigdigits
+	uint64_t largest_single_unit = 2;
+	for (int i=0; i < sigdigits; i++) {
+		largest_single_unit *= 10;
+	}
+	int sub_count_mag = 0;
+	while ( ((uint64_t)1 << sub_count_mag) < largest_single_unit ) {
+		sub_count_mag++;
+	}
+	uint64_t sub_count = (uint64_t)1 << sub_count_mag;
+
+	// buckets: enough powers of 2 to cover highest
+	size_t nbuckets = 1;
+	for (uint64_t untrackable = sub_count; untrackable <= highest; untrackable <<= 1) {
+		nbuckets++;
+	}
+	size_t ncounts = (nbuckets + 1) * (size_t)(sub_count / 2);
+
+	MSUTimerHist *hist = calloc( 1, sizeof(*hist) + ncounts * sizeof(uint64_t) );
+	if ( !hist ) {
+		MSUT_DBGMSG( "ERROR", "calloc(%zu) failed. Return: NULL\n", sizeof(*hist) + ncounts * sizeof(uint64_t) );
+		return NULL;
+	}
+
+	hist->sigdigits = sigdigits;
+	hist->highest = highest;
+	hist->sub_half_mag = sub_count_mag - 1;
+	hist->sub_count = sub_count;
+	hist->sub_half = sub_count / 2;
+	hist->sub_mask = sub_count - 1;
+	hist->ncounts = ncounts;
+	hist->min = UINT64_MAX;
+	hist->max = 0;
+	hist->sum = 0.0;
+	hist->total = 0;
+
+	return hist;
+}
+
+// ----------------------------------------
+// MSUTimerHist *msutimer_hist_free( MSUTimerHist *hist );
+/**
+ * De-allocates the memory reserved for its histogram argument.
+ *
+ * @param hist
+ *		The histogram to be freed.
+ * @return
+ *		Always`NULL`, so the caller can opt to assign it back to the freed pointer,
+ *		to avoid leaving it in a dangling state.
+ */
+MSUTimerHist *msutimer_hist_free( MSUTimerHist *hist )
+{
+	if ( hist ) {
+		free( hist );
+	}
+	return NULL;
+}
+
+// ----------------------------------------
+// bool msutimer_hist_reset( MSUTimerHist *hist );
+/**
+ * Removes all recorded values from its histogram argument.
+ *
+ * @param hist
+ *		The histogram to be reset.
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- hist is `NULL` (`errno` is set to `EDOM`)
+ */
+bool msutimer_hist_reset( MSUTimerHist *hist )
+{
+	errno = 0;
+	if ( !hist ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (hist=NULL). Return: false" );
+		return false;
+	}
+
+	memset( hist->counts, 0, hist->ncounts * sizeof(uint64_t) );
+	hist->total = 0;
+	hist->min = UINT64_MAX;
+	hist->max = 0;
+	hist->sum = 0.0;
+	return true;
+}
+
+// ----------------------------------------
+// bool msutimer_hist_record_ns( MSUTimerHist *hist, uint64_t nsecs );
+/**
+ * Records a value in *nanoseconds* into its histogram argument. This is the
+ * cheapest way to feed a histogram, e.g. with msutimer_now_ticks() differences
+ * converted by msutimer_ticks_to_ns().
+ *
+ * @param hist
+ *		The histogram to be updated.
+ * @param nsecs
+ *		The value to be recorded. Values above the `max_usecs` the histogram
+ *		was created with are recorded as `max_usecs`.
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		The function does not reset `errno` on success (it is meant to be
+ *		called in instrumented code paths).
+ * @par Failures:
+ * 		- hist is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_hist_record()
+ */
+bool msutimer_hist_record_ns( MSUTimerHist *hist, uint64_t nsecs )
+{
+	if ( !hist ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (hist=NULL). Return: false" );
+		return false;
+	}
+
+	nsecs = (nsecs > hist->highest) ? hist->highest : nsecs;
+	hist->counts[ hist_index_(hist, nsecs) ]++;
+	hist->total++;
+	hist->sum += (double)nsecs;
+	hist->min = (nsecs < hist->min) ? nsecs : hist->min;
+	hist->max = (nsecs > hist->max) ? nsecs : hist->max;
+	return true;
+}
+
+// ----------------------------------------
+// bool msutimer_hist_record_ns_n( MSUTimerHist *hist, uint64_t nsecs, uint64_t count );
+/**
+ * Records a value in *nanoseconds* into its histogram argument, as if it was
+ * recorded `count` times, e.g. to scale sampled measurements back up (see
+ * msutimer_sampler_init()).
+ *
+ * @param hist
+ *		The histogram to be updated.
+ * @param nsecs
+ *		The value to be recorded (see msutimer_hist_record_ns()).
+ * @param count
+ *		How many times to record it (0 records nothing).
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		The function does not reset `errno` on success.
+ * @par Failures:
+ * 		- hist is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_hist_record_ns()
+ */
+bool msutimer_hist_record_ns_n( MSUTimerHist *hist, uint64_t nsecs, uint64_t count )
+{
+	if ( !hist ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (hist=NULL). Return: false" );
+		return false;
+	}
+	if ( 0 == count ) {
+		return true;
+	}
+
+	nsecs = (nsecs > hist->highest) ? hist->highest : nsecs;
+	hist->counts[ hist_index_(hist, nsecs) ] += count;
+	hist->total += count;
+	hist->sum += (double)nsecs * (double)count;
+	hist->min = (nsecs < hist->min) ? nsecs : hist->min;
+	hist->max = (nsecs > hist->max) ? nsecs : hist->max;
+	return true;
+}
+
+// ----------------------------------------
+// bool msutimer_hist_record( MSUTimerHist *hist, double usecs );
+/**
+ * Records a value in *microseconds* into its histogram argument, e.g. the
+ * value returned by msutimer_diff_usecs(), or the difference of 2 values
+ * returned by msutimer_gettime().
+ *
+ * @param hist
+ *		The histogram to be updated.
+ * @param usecs
+ *		The value to be recorded, rounded to the nearest *nanosecond*.
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- hist is `NULL` (`errno` is set to `EDOM`)
+ * 		- usecs is negative (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_hist_record_ns()
+ */
+bool msutimer_hist_record( MSUTimerHist *hist, double usecs )
+{
+	errno = 0;
+	if ( !(usecs >= 0.0) ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "(EDOM) function parameter (usecs=%g). Return: false\n", usecs );
+		return false;
+	}
+	double ns = usecs * 1000.0 + 0.5;
+	return msutimer_hist_record_ns( hist, (ns >= (double)UINT64_MAX) ? UINT64_MAX : (uint64_t)ns );
+}
+
+// ----------------------------------------
+// bool msutimer_hist_merge( MSUTimerHist *dst, const MSUTimerHist *src );
+/**
+ * Adds all the values recorded in the `src` histogram to the `dst` histogram.
+ * Both histograms must have been created with the same arguments.
+ *
+ * @param dst
+ *		The histogram to be updated.
+ * @param src
+ *		The histogram to be added.
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- dst or src is `NULL` (`errno` is set to `EDOM`)
+ * 		- the histograms have different precision or range (`errno` is set to `EDOM`)
+ */
+bool msutimer_hist_merge( MSUTimerHist *dst, const MSUTimerHist *src )
+{
+	errno = 0;
+	if ( !dst || !src ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (dst or src=NULL). Return: false" );
+		return false;
+	}
+	if ( dst->ncounts != src->ncounts || dst->sub_count != src->sub_count || dst->highest != src->highest ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) histograms of different precision or range. Return: false" );
+		return false;
+	}
+
+	for (size_t i=0; i < src->ncounts; i++) {
+		dst->counts[i] += src->counts[i];
+	}
+	dst->total += src->total;
+	dst->sum += src->sum;
+	dst->min = (src->min < dst->min) ? src->min : dst->min;
+	dst->max = (src->max > dst->max) ? src->max : dst->max;
+	return true;
+}
+
+// ----------------------------------------
+// uint64_t msutimer_hist_count( const MSUTimerHist *hist );
+/**
+ * Queries its histogram argument for the number of recorded values.
+ *
+ * @param hist
+ *		The histogram to be queried.
+ * @return
+ *		The number of recorded values, or 0 on error.
+ * @par Failures:
+ * 		- hist is `NULL` (`errno` is set to `EDOM`)
+ */
+uint64_t msutimer_hist_count( const MSUTimerHist *hist )
+{
+	errno = 0;
+	if ( !hist ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (hist=NULL). Return: 0" );
+		return 0;
+	}
+	return hist->total;
+}
+
+// ----------------------------------------
+// double msutimer_hist_percentile( const MSUTimerHist *hist, double percentile );
+/**
+ * Queries its histogram argument for the value at a given percentile.
+ *
+ * @param hist
+ *		The histogram to be queried.
+ * @param percentile
+ *		The percentile, from 0.0 to 100.0 (e.g. 99.9). Values out of this range
+ *		are clamped.
+ * @return
+ *		A `double` representing the value (in *microseconds*) below or equal to
+ *		which the given percentage of the recorded values lies, within the
+ *		precision of the histogram. It is 0.0 if nothing has been recorded,
+ *		and `-DBL_MAX` on error.
+ * @par Failures:
+ * 		- hist is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_hist_stats()
+ */
+double msutimer_hist_percentile( const MSUTimerHist *hist, double percentile )
+{
+	errno = 0;
+	if ( !hist ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (hist=NULL). Return: -DBL_MAX" );
+		return -DBL_MAX;
+	}
+	if ( 0 == hist->total ) {
+		return 0.0;
+	}
+	return 0.001 * (double) hist_value_at_percentile_( hist, percentile );
+}
+
+// ----------------------------------------
+// bool msutimer_hist_stats( const MSUTimerHist *hist, MSUTimerStats *stats );
+/**
+ * Fills an ::MSUTimerStats with the statistics of the values recorded in its
+ * histogram argument (in *microseconds*).
+ *
+ * The count, total, minimum, maximum and mean are exact. The percentiles,
+ * the standard deviation and the median absolute deviation are computed
+ * within the precision of the histogram.
+ *
+ * @param hist
+ *		The histogram to be queried.
+ * @param stats
+ *		The statistics to be filled (`failed` and `erepeat` are always reset).
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- hist or stats is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_hist_percentile(), msutimer_bench_hist()
+ */
+bool msutimer_hist_stats( const MSUTimerHist *hist, MSUTimerStats *stats )
+{
+	errno = 0;
+	if ( !hist || !stats ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (hist or stats=NULL). Return: false" );
+		return false;
+	}
+
+	memset( stats, 0, sizeof(*stats) );
+	stats->nsamples = (size_t) hist->total;
+	if ( 0 == hist->total ) {
+		return true;
+	}
+
+	double mean = hist->sum / (double)hist->total;
+	stats->total  = 0.001 * hist->sum;
+	stats->min    = 0.001 * (double)hist->min;
+	stats->max    = 0.001 * (double)hist->max;
+	stats->mean   = 0.001 * mean;
+
+	if ( hist->total > 1 ) {
+		double m2 = 0.0;
+		for (size_t i=0; i < hist->ncounts; i++) {
+			if ( hist->counts[i] ) {
+				double d = (double)hist_mid_at_( hist, i ) - mean;
+				m2 += d * d * (double)hist->counts[i];
+			}
+		}
+		stats->stddev = 0.001 * sqrt( m2 / (double)(hist->total - 1) );
+	}
+
+	uint64_t median = hist_value_at_percentile_( hist, 50.0 );
+	stats->median = 0.001 * (double)median;
+	stats->p90    = 0.001 * (double)hist_value_at_percentile_( hist, 90.0 );
+	stats->p99    = 0.001 * (double)hist_value_at_percentile_( hist, 99.0 );
+	stats->p999   = 0.001 * (double)hist_value_at_percentile_( hist, 99.9 );
+
+	// MAD: the smallest deviation d, for which at least half the values lie
+	// within [median - d, median + d] (binary search)
+	uint64_t half = (hist->total + 1) / 2;
+	uint64_t lo = 0;
+	uint64_t hi = hist->max - hist->min;
+	while ( lo < hi ) {
+		uint64_t d = lo + (hi - lo) / 2;
+		uint64_t from = (median > d) ? median - d : 0;
+		if ( hist_count_between_(hist, from, median + d) >= half ) {
+			hi = d;
+		}
+		else {
+			lo = d + 1;
+		}
+	}
+	stats->mad = 0.001 * (double)lo;
+
+	return true;
+}
+
+// ----------------------------------------
+// size_t msutimer_hist_footprint( const MSUTimerHist *hist );
+/**
+ * Queries its histogram argument for the memory it occupies. It is fixed when
+ * the histogram gets created.
+ *
+ * @param hist
+ *		The histogram to be queried.
+ * @return
+ *		The size of the histogram in bytes, or 0 on error.
+ * @par Failures:
+ * 		- hist is `NULL` (`errno` is set to `EDOM`)
+ */
+size_t msutimer_hist_footprint( const MSUTimerHist *hist )
+{
+	errno = 0;
+	if ( !hist ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (hist=NULL). Return: 0" );
+		return 0;
+	}
+	return sizeof(*hist) + hist->ncounts * sizeof(uint64_t);
+}
+
+// ----------------------------------------
+// bool msutimer_bench_hist( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat, MSUTimerHist *hist );
+/**
+ * Records the execution times of its callback-function argument into a
+ * histogram, for a specified number of iterations, in constant memory.
+ *
+ * Unlike msutimer_bench_median() and msutimer_bench_stats(), no samples are
+ * stored: each one is recorded into the histogram as soon as it is taken. The
+ * recorded values get added to any values the histogram already holds, so
+ * several runs may be accumulated before querying it with
+ * msutimer_hist_percentile() or msutimer_hist_stats().
+ *
+ * @param timer
+ *		An already created timer.
+ * @param nrepeats
+ *		The number of times to execute the callback-function (iterations).
+ * @param callback
+ *		The callback-function to be measured (see msutimer_bench()).
+ * @param userdata
+ *		A `void` pointer to caller-defined data, used by the callback-function
+ *		(see msutimer_bench()).
+ * @param erepeat
+ *		If non-`NULL`, then in case of callback error (`false`) `erepeat` passes
+ *		back to the caller the last successful iteration.
+ * @param hist
+ *		The histogram to record into.
+ * @return
+ *		`true` if all `nrepeats` iterations were recorded, `false` otherwise.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- nrepeats is 0 (`errno` is set to `EDOM`)
+ * 		- callback is `NULL` (`errno` is set to `EDOM`)
+ * 		- hist is `NULL` (`errno` is set to `EDOM`)
+ * 		- callback returns `false` (`erepeat` is set to the last successful
+ * 	      iteration, whose samples remain recorded)
+ * @sa
+ *		msutimer_hist_new(), msutimer_bench_stats()
+ */
+bool msutimer_bench_hist( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat, MSUTimerHist *hist )
+{
+	errno = 0;
+
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: false" );
+		return false;
+	}
+	if ( !callback ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: false" );
+		return false;
+	}
+	if ( !hist ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to hist=NULL. Return: false" );
+		return false;
+	}
+	if ( nrepeats == 0 ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nrepeats=0. Return: false" );
+		return false;
+	}
+
+	if ( !warmup_( timer, callback, userdata ) ) {
+		if ( erepeat ) {
+			*erepeat = 0;
+		}
+		return false;
+	}
+
+	if ( erepeat ) {
+		*erepeat = 0;	// reset
+	}
+
+	MSUTimerTime t;
+	for (size_t i=0; i < nrepeats; i++) {
+		if ( !sample_ticks_( timer, callback, userdata, &t ) ) {
+			if ( erepeat ) {
+				*erepeat = i;
+			}
+			MSUT_DBGMSG(
+				"WARNING",
+				"Requested iterations: %zu, but FAILED at %zu (erepeat).\n"
+				"==> Returned: false (samples until then are recorded).\n",
+				nrepeats,
+				i+1
+				);
+			return false;
+		}
+		msutimer_hist_record_ns( hist, (uint64_t)(1000.0 * sample_to_usecs_(timer, t) + 0.5) );
+	}
+
+	return true;
+}
+
+// ----------------------------------------
+// MSUTimerGroup *msutimer_group_new( MSUTimerClock source, size_t nslots, double max_usecs, int sigdigits );
+/**
+ * Constructs a group of per-thread timing slots, for measuring the same code
+ * path on many threads without sharing any mutable state between them.
+ * De-allocation should be done by the caller, with msutimer_group_free().
+ *
+ * Each worker thread claims its own slot once, with msutimer_group_join(),
+ * and then records into it with msutimer_slot_begin() / msutimer_slot_end()
+ * (or msutimer_slot_record_ns()). Slots are padded to whole cache-lines and
+ * own a separate histogram, so recording involves no locks, no atomics and no
+ * false sharing. The histograms of all slots get merged on demand with
+ * msutimer_collect().
+ *
+ * @param source
+ *		The clock source of the slots (see ::MSUTimerClock). It should be one
+ *		that is consistent across threads (not a per-thread CPU clock).
+ * @param nslots
+ *		The maximum number of threads that may join the group.
+ * @param max_usecs
+ *		The range of the slot histograms (see msutimer_hist_new()).
+ * @param sigdigits
+ *		The precision of the slot histograms (see msutimer_hist_new()).
+ * @return
+ *		The newly allocated group, or `NULL` on error.
+ * @par Failures:
+ * 		- nslots is 0 (`errno` is set to `EDOM`)
+ * 		- any of the failures of msutimer_new_ex() and msutimer_hist_new()
+ *
+ * @par Sample Usage
+ * @code
+		// main thread
+		MSUTimerGroup *group = msutimer_group_new( MSUT_CLOCK_DEFAULT, 64, 1000000.0, 2 );
+		...
+		// each worker thread
+		MSUTimerSlot *slot = msutimer_group_join( group );
+		for (;;) {
+			msutimer_slot_begin( slot );
+			handle_request();
+			msutimer_slot_end( slot );
+		}
+		...
+		// main thread, at any time
+		MSUTimerHist *all = msutimer_group_hist_new( group );
+		msutimer_collect( group, all, &stats );
+ * @endcode
+ */
+MSUTimerGroup *msutimer_group_new( MSUTimerClock source, size_t nslots, double max_usecs, int sigdigits )
+{
+	errno = 0;
+
+	if ( 0 == nslots ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (nslots=0). Return: NULL" );
+		return NULL;
+	}
+
+	MSUTimerGroup *group = calloc( 1, sizeof(*group) );
+	if ( !group ) {
+		MSUT_DBGMSG( "ERROR", "calloc(%zu) failed. Return: NULL\n", sizeof(*group) );
+		return NULL;
+	}
+
+	group->mem = calloc( 1, nslots * sizeof(MSUTimerSlot) + MSUT_CACHELINE );
+	if ( !group->mem ) {
+		MSUT_DBGMSG( "ERROR", "calloc(%zu) failed. Return: NULL\n", nslots * sizeof(MSUTimerSlot) + MSUT_CACHELINE );
+		free( group );
+		return NULL;
+	}
+	group->slots = (MSUTimerSlot *) (((uintptr_t)group->mem + MSUT_CACHELINE - 1) & ~(uintptr_t)(MSUT_CACHELINE - 1));
+	group->nslots = nslots;
+	group->max_usecs = max_usecs;
+	group->sigdigits = sigdigits;
+
+	group->timer = msutimer_new_ex( source );
+	if ( !group->timer ) {
+		int err = errno;	// set by msutimer_new_ex()
+		msutimer_group_free( group );
+		errno = err;
+		return NULL;
+	}
+
+	for (size_t i=0; i < nslots; i++) {
+		MSUTimerSlotData_ *d = &group->slots[i].d;
+		d->source = group->timer->source;
+		d->nsecs_per_tick = group->timer->nsecs_per_tick;
+		d->hist = msutimer_hist_new( max_usecs, sigdigits );
+		if ( !d->hist ) {
+			int err = errno;
+			msutimer_group_free( group );
+			errno = err;
+			return NULL;
+		}
+	}
+
+	return group;
+}
+
+// ----------------------------------------
+// MSUTimerGroup *msutimer_group_free( MSUTimerGroup *group );
+/**
+ * De-allocates the memory reserved for its group argument, including all of
+ * its slots. No thread should be using any of them.
+ *
+ * @param group
+ *		The group to be freed.
+ * @return
+ *		Always`NULL`, so the caller can opt to assign it back to the freed pointer,
+ *		to avoid leaving it in a dangling state.
+ */
+MSUTimerGroup *msutimer_group_free( MSUTimerGroup *group )
+{
+	if ( group ) {
+		if ( group->slots ) {
+			for (size_t i=0; i < group->nslots; i++) {
+				msutimer_hist_free( group->slots[i].d.hist );
+			}
+		}
+		msutimer_free( group->timer );
+		free( group->mem );
+		free( group );
+	}
+	return NULL;
+}
+
+// ----------------------------------------
+// MSUTimerSlot *msutimer_group_join( MSUTimerGroup *group );
+/**
+ * Claims a slot of its group argument, for the exclusive use of the calling
+ * thread. Each thread should call it once, and keep the returned slot (e.g. in
+ * a thread-local variable) for all its measurements.
+ *
+ * @param group
+ *		The group to join.
+ * @return
+ *		The claimed slot, or `NULL` on error.
+ * @remarks
+ *		This is the only function of the group that uses an atomic operation.
+ *		On compilers without atomic builtins, threads must join one at a time.
+ * @par Failures:
+ * 		- group is `NULL` (`errno` is set to `EDOM`)
+ * 		- all slots have already been claimed (`errno` is set to `ERANGE`)
+ */
+MSUTimerSlot *msutimer_group_join( MSUTimerGroup *group )
+{
+	errno = 0;
+	if ( !group ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (group=NULL). Return: NULL" );
+		return NULL;
+	}
+
+	int64_t i = MSUT_ATOMIC_FETCH_ADD_( &group->njoined, 1 );
+	if ( i < 0 || (size_t)i >= group->nslots ) {
+		errno = ERANGE;
+		MSUT_DBGMSG( "ERROR", "(ERANGE) all %zu slots are taken. Return: NULL\n", group->nslots );
+		return NULL;
+	}
+	return &group->slots[i];
+}
+
+// ----------------------------------------
+// void msutimer_slot_begin( MSUTimerSlot *slot );
+/**
+ * Starts a measurement on a slot claimed with msutimer_group_join(). Only the
+ * thread that claimed the slot may call it.
+ *
+ * @param slot
+ *		The slot of the calling thread (it must not be `NULL`; the function does
+ *		no sanity checks and does not touch `errno`, to stay out of the measurement).
+ * @sa
+ *		msutimer_slot_end()
+ */
+void msutimer_slot_begin( MSUTimerSlot *slot )
+{
+	get_msuttime_( slot->d.source, &slot->d.t1 );
+}
+
+// ----------------------------------------
+// void msutimer_slot_end( MSUTimerSlot *slot );
+/**
+ * Ends the measurement started by the latest msutimer_slot_begin() on the same
+ * slot, and records the elapsed time into the slot's histogram. Only the thread
+ * that claimed the slot may call it.
+ *
+ * @param slot
+ *		The slot of the calling thread (it must not be `NULL`; see msutimer_slot_begin()).
+ * @sa
+ *		msutimer_slot_begin(), msutimer_collect()
+ */
+void msutimer_slot_end( MSUTimerSlot *slot )
+{
+	MSUTimerTime t2 = slot->d.t1;
+	get_msuttime_( slot->d.source, &t2 );
+	msutimer_hist_record_ns( slot->d.hist, (uint64_t)((double)(t2 - slot->d.t1) * slot->d.nsecs_per_tick + 0.5) );
+}
+
+// ----------------------------------------
+// bool msutimer_slot_record_ns( MSUTimerSlot *slot, uint64_t nsecs );
+/**
+ * Records a value measured by other means (in *nanoseconds*) into the histogram
+ * of a slot claimed with msutimer_group_join(). Only the thread that claimed
+ * the slot may call it.
+ *
+ * @param slot
+ *		The slot of the calling thread.
+ * @param nsecs
+ *		The value to be recorded.
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- slot is `NULL` (`errno` is set to `EDOM`)
+ */
+bool msutimer_slot_record_ns( MSUTimerSlot *slot, uint64_t nsecs )
+{
+	if ( !slot ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (slot=NULL). Return: false" );
+		return false;
+	}
+	return msutimer_hist_record_ns( slot->d.hist, nsecs );
+}
+
+// ----------------------------------------
+// MSUTimerHist *msutimer_group_hist_new( const MSUTimerGroup *group );
+/**
+ * Constructs a new, empty histogram with the same range and precision as the
+ * slots of its group argument, suitable for msutimer_collect().
+ *
+ * @param group
+ *		The group whose histogram layout is to be used.
+ * @return
+ *		The newly allocated histogram, or `NULL` on error. De-allocation should
+ *		be done by the caller, with msutimer_hist_free().
+ * @par Failures:
+ * 		- group is `NULL` (`errno` is set to `EDOM`)
+ * 		- memory allocation failure (`errno` is set by the C runtime)
+ */
+MSUTimerHist *msutimer_group_hist_new( const MSUTimerGroup *group )
+{
+	errno = 0;
+	if ( !group ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (group=NULL). Return: NULL" );
+		return NULL;
+	}
+	return msutimer_hist_new( group->max_usecs, group->sigdigits );
+}
+
+// ----------------------------------------
+// bool msutimer_collect( const MSUTimerGroup *group, MSUTimerHist *hist, MSUTimerStats *stats );
+/**
+ * Merges the histograms of all the slots of its group argument.
+ *
+ * @param group
+ *		The group to be collected.
+ * @param hist
+ *		The histogram to receive the merged values (its previous contents get
+ *		discarded). It must have the group's layout (see msutimer_group_hist_new()).
+ * @param stats
+ *		If non-`NULL`, it gets filled with the statistics of the merged values
+ *		(see msutimer_hist_stats()).
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		It may be called while the worker threads keep recording: their slots
+ *		are read without any synchronization (so that recording needs none),
+ *		hence values being recorded at that very moment may or may not be
+ *		included. The result is exact once the workers are idle.
+ * @par Failures:
+ * 		- group or hist is `NULL` (`errno` is set to `EDOM`)
+ * 		- hist has a different layout than the group (`errno` is set to `EDOM`)
+ */
+bool msutimer_collect( const MSUTimerGroup *group, MSUTimerHist *hist, MSUTimerStats *stats )
+{
+	errno = 0;
+	if ( !group || !hist ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (group or hist=NULL). Return: false" );
+		return false;
+	}
+
+	msutimer_hist_reset( hist );
+	for (size_t i=0; i < group->nslots; i++) {
+		if ( !msutimer_hist_merge(hist, group->slots[i].d.hist) ) {
+			return false;	// errno is set by msutimer_hist_merge()
+		}
+	}
+
+	return stats ? msutimer_hist_stats( hist, stats ) : true;
+}
+
+// ----------------------------------------
+// bool msutimer_bench_parallel( MSUTimer *timer, size_t nthreads, size_t nrepeats, bool (*callback)(void *), void **userdata, unsigned flags, MSUTimerParallel *results, double *thread_ops_per_sec );
+/**
+ * Measures how the throughput of its callback-function argument scales, when
+ * it runs concurrently on several threads.
+ *
+ * The callback-function is executed `nrepeats` times on each of `nthreads`
+ * threads. All threads spin at a barrier until every one of them is ready,
+ * so they begin together. The run yields the aggregate throughput (total
+ * iterations over the time from the first start to the last finish), along
+ * with the slowest and fastest per-thread throughput.
+ *
+ * With the flag MSUT_PARALLEL_SCALING, runs with 1, 2, ..., `nthreads` threads
+ * are made one after the other, giving a scaling curve: `results[k-1]` holds
+ * the run with `k` threads, and its speedup over the single-thread run.
+ *
+ * @param timer
+ *		An already created timer (its clock must be consistent across threads).
+ * @param nthreads
+ *		The number of threads.
+ * @param nrepeats
+ *		The number of times each thread executes the callback-function.
+ * @param callback
+ *		The callback-function to be measured (see msutimer_bench()). It gets
+ *		called concurrently, so it must be thread-safe for the given `userdata`.
+ * @param userdata
+ *		Either `NULL` (every thread passes `NULL` to the callback-function), or
+ *		an array of `nthreads` pointers, one per thread.
+ * @param flags
+ *		Bitwise-or of: MSUT_PARALLEL_PIN to pin thread `i` to CPU `i` (where
+ *		supported), MSUT_PARALLEL_SCALING to run the whole scaling curve.
+ * @param results
+ *		Array of results to be filled: 1 element, or `nthreads` elements with
+ *		MSUT_PARALLEL_SCALING.
+ * @param thread_ops_per_sec
+ *		If non-`NULL`, an array of `nthreads` doubles that receives the
+ *		throughput (*iterations per second*) of every thread of the run with
+ *		`nthreads` threads.
+ * @return
+ *		`true` if all threads completed all iterations, `false` otherwise
+ *		(the `failed` member of the results tells which runs failed).
+ * @par Failures:
+ * 		- timer, callback or results is `NULL` (`errno` is set to `EDOM`)
+ * 		- nthreads or nrepeats is 0 (`errno` is set to `EDOM`)
+ * 		- no thread support on the platform (`errno` is set to `ENOSYS`)
+ * 		- thread creation failure (`errno` is set by the system, or to `EAGAIN`)
+ * 		- memory allocation failure (`errno` is set by the C runtime)
+ * 		- callback returns `false` (that thread stops early, and only its
+ *		  successful iterations are counted)
+ * @sa
+ *		msutimer_bench(), msutimer_group_new()
+ */
+bool msutimer_bench_parallel( MSUTimer *timer, size_t nthreads, size_t nrepeats, bool (*callback)(void *), void **userdata, unsigned flags, MSUTimerParallel *results, double *thread_ops_per_sec )
+{
+	errno = 0;
+
+	if ( !timer || !callback || !results ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer, callback or results=NULL. Return: false" );
+		return false;
+	}
+	if ( 0 == nthreads || 0 == nrepeats ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nthreads=0 or nrepeats=0. Return: false" );
+		return false;
+	}
+
+#if MSUT_HAS_THREADS
+	MSUTimerParThread_ *pts = malloc( nthreads * sizeof(*pts) );
+	MSUTimerThread_ *ths = malloc( nthreads * sizeof(*ths) );
+	if ( !pts || !ths ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "malloc() failed. Return: false" );
+		free( pts );
+		free( ths );
+		return false;
+	}
+
+	bool pin = 0 != (flags & MSUT_PARALLEL_PIN);
+	bool ret = true;
+	bool complete = false;	// has the run with nthreads threads been made?
+	size_t from = (flags & MSUT_PARALLEL_SCALING) ? 1 : nthreads;
+	for (size_t n = from; n <= nthreads; n++) {
+		MSUTimerParallel *res = (flags & MSUT_PARALLEL_SCALING) ? &results[n-1] : &results[0];
+		if ( !par_run_(timer, n, nrepeats, callback, userdata, pin, pts, ths, res) ) {
+			MSUT_DBGMSG( "ERROR", "Could not start %zu threads. Return: false\n", n );
+			ret = false;
+			break;
+		}
+		complete = (n == nthreads);
+		if ( res->failed ) {
+			MSUT_DBGMSG( "WARNING", "A callback FAILED in the run with %zu threads.\n", n );
+			ret = false;
+		}
+		if ( flags & MSUT_PARALLEL_SCALING ) {
+			res->speedup = (results[0].ops_per_sec > 0.0) ? res->ops_per_sec / results[0].ops_per_sec : 0.0;
+			res->efficiency = res->speedup / (double)n;
+		}
+	}
+
+	if ( thread_ops_per_sec && complete ) {
+		for (size_t i=0; i < nthreads; i++) {
+			thread_ops_per_sec[i] = pts[i].ops_per_sec;
+		}
+	}
+
+	free( pts );
+	free( ths );
+	return ret;
+
+#else
+	(void)userdata; (void)flags; (void)thread_ops_per_sec;
+	errno = ENOSYS;
+	MSUT_DBGMSG( "ERROR", "%s\n", "(ENOSYS) no thread support on this platform. Return: false" );
+	return false;
+#endif
+}
+
+// ----------------------------------------
+// double msutimer_bench_for( MSUTimer *timer, double budget_usecs, bool (*callback)(void *), void *userdata, size_t *niters );
+/**
+ * Measures the average execution time of its callback-function argument, running
+ * it as many times as fit in a time budget, instead of a fixed number of times.
+ *
+ * The callback-function is called in batches, and the clock is read only once
+ * per batch, so checking the budget does not inflate the cost of each call.
+ * Batches start with a single call and double in size, until a batch lasts
+ * about 1/`MSUT_FOR_CHECK_FRACTION` (1/64 by default) of the budget. Near the
+ * end of the budget they shrink again, so the budget is not overshot by more
+ * than about a single call.
+ *
+ * @param timer
+ *		An already created timer.
+ * @param budget_usecs
+ *		The time budget, in *microseconds* (it does not include the warm-up,
+ *		see msutimer_set_warmup()).
+ * @param callback
+ *		The callback-function to be measured (see msutimer_bench()).
+ * @param userdata
+ *		A `void` pointer to caller-defined data, used by the callback-function
+ *		(see msutimer_bench()).
+ * @param niters
+ *		If non-`NULL`, it passes back to the caller the number of successful
+ *		calls of the callback-function.
+ * @return
+ *		A `double` representing the average time (in *microseconds*) of a single
+ *		call of the callback-function.
+ *
+ *		If the callback-function errors, then the returned value is **negative**,
+ *		reflecting the average of the batches completed until then (-0.0 with
+ *		`errno` set to `ECANCELED` if none was completed). On all other errors,
+ *		`errno` is set to `EDOM` and the function returns 0.0
+ * @remarks
+ *		Use it for suites whose callbacks vary widely in cost: each one gets
+ *		about the same wall-clock time, so cheap ones get many samples and
+ *		expensive ones do not take minutes. If overhead subtraction is enabled
+ *		(see msutimer_subtract_overhead()), the overhead is subtracted once per
+ *		batch. A batch never exceeds `MSUT_AUTO_MAX_BATCH` calls.
+ * @par Failures:
+ * 		- timer is `NULL` (returns 0.0, `errno` is set to `EDOM`)
+ * 		- budget_usecs is not positive (returns 0.0, `errno` is set to `EDOM`)
+ * 		- callback is `NULL` (returns 0.0, `errno` is set to `EDOM`)
+ * 		- callback returns `false` (see above)
+ * @sa
+ *		msutimer_bench_average(), msutimer_bench_auto(), [Benchmarking](@ref msut_bench)
+ */
+double msutimer_bench_for( MSUTimer *timer, double budget_usecs, bool (*callback)(void *), void *userdata, size_t *niters )
+{
+	errno = 0;
+
+	if ( niters ) {
+		*niters = 0;
+	}
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( !callback ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( !(budget_usecs > 0.0) ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to budget_usecs <= 0. Returned 0 secs." );
+		return 0.0;
+	}
+
+	if ( !warmup_( timer, callback, userdata ) ) {
+		return failed_zero_();
+	}
+
+	const double budget = budget_usecs / timer->usecs_per_tick;	// in ticks
+	const double maxbatch = budget / MSUT_FOR_CHECK_FRACTION;		// in ticks
+	double elapsed = 0.0;	// in ticks
+	double sum = 0.0;		// in usecs, with the overhead subtracted
+	size_t batch = 1, n = 0, done = 0;
+	MSUTimerTime t;
+
+	while ( elapsed < budget ) {
+		if ( !sample_batch_ticks_( timer, batch, callback, userdata, &t, &done ) ) {
+			if ( niters ) {
+				*niters = n + done;
+			}
+			MSUT_DBGMSG(
+				"WARNING",
+				"Callback FAILED after %zu calls.\n"
+				"==> Returned: average secs of the completed batches (with negative sign).\n",
+				n + done
+				);
+			return ( n > 0 && sum > 0.0 ) ? -sum / n : failed_zero_();
+		}
+		n += batch;
+		elapsed += (double)t;
+		sum += sample_to_usecs_( timer, t );
+
+		// grow the batch while it is short, but never past the end of the budget
+		double percall = (double)t / batch;
+		if ( 2.0 * (double)t <= maxbatch && batch < MSUT_AUTO_MAX_BATCH ) {
+			batch *= 2;
+		}
+		if ( percall > 0.0 && (double)batch * percall > budget - elapsed ) {
+			double left = (budget - elapsed) / percall;
+			batch = left > 1.0 ? (size_t)left : 1;
+		}
+	}
+
+	if ( niters ) {
+		*niters = n;
+	}
+	return sum / n;
+}
+
+/* ----------------------------------
+ * Named Zones
+ * ----------------------------------
+ */
+
+static MSUTimerZone *zones_ = NULL;		// registered zones, most recent first
+static int64_t zones_lock_ = 0;			// guards zones_ & zones_nsecs_per_tick_
+static double zones_nsecs_per_tick_ = 0.0;	// of the default clock source
+
+// ----------------------------------------
+// Spin locks, for the (rare) registration of zones and their histograms, and
+// for the (short) free-list operations of timer pools
+//
+static void zone_lock_( int64_t *lock )
+{
+	while ( !MSUT_ATOMIC_CAS_( lock, 0, 1 ) ) {
+#if MSUT_ARCH_X86
+		_mm_pause();
+#elif MSUT_OS_POSIX
+		sched_yield();
+#endif
+	}
+}
+
+static void zone_unlock_( int64_t *lock )
+{
+	MSUT_ATOMIC_STORE_( lock, 0 );
+}
+
+// ----------------------------------------
+// void msutimer_zone_register_( MSUTimerZone *zone, int level );
+/**
+ * Registers a named zone on its first completed pass (internal, called by
+ * MSUT_ZONE_END()), so that msutimer_zones_dump() can find it.
+ *
+ * @param zone
+ *		The static zone of the call site.
+ * @param level
+ *		The value of `MSUT_ZONES` in the caller's translation unit. When it is
+ *		at least 2, the zone also gets a histogram.
+ * @remarks
+ *		It is thread-safe, and does nothing if the zone is already registered.
+ *		If the histogram cannot be created, the zone still records its count
+ *		and total.
+ */
+void msutimer_zone_register_( MSUTimerZone *zone, int level )
+{
+	zone_lock_( &zones_lock_ );
+	if ( 0 == zone->state ) {
+		if ( 0.0 == zones_nsecs_per_tick_ ) {
+			MSUTimerTime freq;
+			double usecs_per_tick;
+			if ( get_msutfreq_( resolve_clock_(MSUT_CLOCK_DEFAULT), &freq, &usecs_per_tick ) ) {
+				zones_nsecs_per_tick_ = 1000.0 * usecs_per_tick;
+			}
+		}
+		if ( level >= 2 ) {
+			MSUTimerHist *hist = msutimer_hist_new( MSUT_ZONE_HIST_MAX_USECS, MSUT_ZONE_HIST_SIGDIGITS );
+			if ( !hist ) {
+				MSUT_DBGMSG( "WARNING", "No histogram for zone \"%s\" (%s:%d).\n", zone->name, zone->file, zone->line );
+			}
+			zone_lock_( &zone->lock );
+			zone->hist = hist;
+			zone_unlock_( &zone->lock );
+		}
+		zone->next = zones_;
+		zones_ = zone;
+		MSUT_ATOMIC_STORE_( &zone->state, 1 );
+	}
+	zone_unlock_( &zones_lock_ );
+}
+
+// ----------------------------------------
+// void msutimer_zone_record_( MSUTimerZone *zone, uint64_t ticks );
+/**
+ * Records a duration into the histogram of a named zone (internal, called by
+ * MSUT_ZONE_END() when `MSUT_ZONES` is 2).
+ *
+ * @param zone
+ *		The static zone of the call site.
+ * @param ticks
+ *		The duration of the pass, in ticks of the default clock source.
+ * @remarks
+ *		It is used only by the threads that have no slot of their own in the
+ *		zone (see msutimer_zone_slot_()). The histogram is guarded by a per-zone
+ *		spin lock, so concurrent passes of such threads serialize here.
+ */
+void msutimer_zone_record_( MSUTimerZone *zone, uint64_t ticks )
+{
+	zone_lock_( &zone->lock );
+	if ( zone->hist ) {
+		msutimer_hist_record_ns( zone->hist, (uint64_t)((double)ticks * zones_nsecs_per_tick_ + 0.5) );
+	}
+	zone_unlock_( &zone->lock );
+}
+
+// ----------------------------------------
+// MSUTimerZoneSlot *msutimer_zone_slot_( MSUTimerZone *zone, int level );
+/**
+ * Creates the slot of the calling thread in a named zone (internal, called by
+ * MSUT_ZONE_END() on the first pass of each thread through its zone), and
+ * registers the zone if needed.
+ *
+ * The thread then records its passes into its own slot with plain additions,
+ * so passes on different threads neither serialize nor share cache lines.
+ * msutimer_zones_dump() adds all the slots up.
+ *
+ * @param zone
+ *		The static zone of the call site.
+ * @param level
+ *		The value of `MSUT_ZONES` in the caller's translation unit. When it is
+ *		at least 2, the slot also gets a histogram.
+ * @return
+ *		The slot, or `NULL` if it cannot be allocated (the thread then records
+ *		into the zone itself, with atomic additions).
+ * @remarks
+ *		Slots are kept until the program ends, so that the passes of exited
+ *		threads still get reported. If the histogram cannot be created, the
+ *		thread still records its count and total.
+ */
+MSUTimerZoneSlot *msutimer_zone_slot_( MSUTimerZone *zone, int level )
+{
+	if ( 0 == MSUT_ATOMIC_LOAD_( &zone->state ) ) {
+		msutimer_zone_register_( zone, level );
+	}
+	if ( 2 == MSUT_ATOMIC_LOAD_( &zone->state ) ) {
+		return NULL;	// an earlier allocation failed
+	}
+
+	// a cache line of its own (assuming the slot fits in one)
+	void *mem = calloc( 1, sizeof(MSUTimerZoneSlot) + 2 * MSUT_CACHELINE );
+	MSUTimerHist *hist = (level >= 2) ? msutimer_hist_new( MSUT_ZONE_HIST_MAX_USECS, MSUT_ZONE_HIST_SIGDIGITS ) : NULL;
+	if ( !mem ) {
+		MSUT_DBGMSG( "WARNING", "No per-thread slot for zone \"%s\" (%s:%d).\n", zone->name, zone->file, zone->line );
+		msutimer_hist_free( hist );
+		MSUT_ATOMIC_STORE_( &zone->state, 2 );
+		return NULL;
+	}
+	if ( level >= 2 && !hist ) {
+		MSUT_DBGMSG( "WARNING", "No histogram for zone \"%s\" (%s:%d).\n", zone->name, zone->file, zone->line );
+	}
+
+	MSUTimerZoneSlot *slot = (MSUTimerZoneSlot *) (((uintptr_t)mem + MSUT_CACHELINE - 1) & ~(uintptr_t)(MSUT_CACHELINE - 1));
+	slot->mem = mem;
+	slot->hist = hist;
+	slot->nsecs_per_tick = zones_nsecs_per_tick_;
+
+	zone_lock_( &zone->lock );
+	slot->next = zone->slots;
+	zone->slots = slot;
+	zone_unlock_( &zone->lock );
+	return slot;
+}
+
+// ----------------------------------------
+// bool msutimer_zones_dump( FILE *fp );
+/**
+ * Prints a table of all the named zones passed through so far.
+ *
+ * A line per zone, most recently registered first, with the zone's name and
+ * call site, its number of passes, its total and average time, and (when
+ * compiled with `MSUT_ZONES=2`) the median, the 99th percentile and the
+ * maximum of its histogram.
+ *
+ * @param fp
+ *		The output stream (e.g. `stdout`).
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		It may be called while other threads pass through zones: it adds up
+ *		the per-thread counts, totals and histograms of each zone, so a pass
+ *		that is in progress may show up in some of them and not yet in the
+ *		others.
+ * @par Failures:
+ * 		- fp is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		MSUT_ZONE_BEGIN(), msutimer_zones_reset()
+ */
+bool msutimer_zones_dump( FILE *fp )
+{
+	errno = 0;
+	if ( !fp ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (fp=NULL). Return: false" );
+		return false;
+	}
+
+	zone_lock_( &zones_lock_ );
+	fprintf( fp, "%-24s %-28s %12s %14s %12s %12s %12s %12s\n",
+		"zone", "site", "count", "total(ms)", "avg(us)", "p50(us)", "p99(us)", "max(us)" );
+	for (MSUTimerZone *z = zones_; z; z = z->next) {
+		char site[256];
+		int64_t count = MSUT_ATOMIC_LOAD_( &z->count );
+		int64_t ticks = MSUT_ATOMIC_LOAD_( &z->ticks );
+		MSUTimerHist *hist = NULL;	// the merged histograms of z
+
+		zone_lock_( &z->lock );
+		if ( z->hist && msutimer_hist_count(z->hist) > 0 ) {
+			hist = msutimer_hist_new( MSUT_ZONE_HIST_MAX_USECS, MSUT_ZONE_HIST_SIGDIGITS );
+			msutimer_hist_merge( hist, z->hist );
+		}
+		for (MSUTimerZoneSlot *slot = z->slots; slot; slot = slot->next) {
+			count += MSUT_ATOMIC_LOAD_( &slot->count );
+			ticks += MSUT_ATOMIC_LOAD_( &slot->ticks );
+			if ( slot->hist && msutimer_hist_count(slot->hist) > 0 ) {
+				hist = hist ? hist : msutimer_hist_new( MSUT_ZONE_HIST_MAX_USECS, MSUT_ZONE_HIST_SIGDIGITS );
+				msutimer_hist_merge( hist, slot->hist );
+			}
+		}
+		zone_unlock_( &z->lock );
+
+		double usecs = (double)ticks * zones_nsecs_per_tick_ / 1000.0;
+		snprintf( site, sizeof(site), "%s:%d", z->file, z->line );
+		fprintf( fp, "%-24s %-28s %12lld %14.3f %12.3f", z->name, site,
+			(long long)count, usecs / 1000.0, count > 0 ? usecs / (double)count : 0.0 );
+		if ( hist && msutimer_hist_count(hist) > 0 ) {
+			fprintf( fp, " %12.3f %12.3f %12.3f",
+				msutimer_hist_percentile( hist, 50.0 ),
+				msutimer_hist_percentile( hist, 99.0 ),
+				msutimer_hist_percentile( hist, 100.0 ) );
+		}
+		msutimer_hist_free( hist );
+		fputc( '\n', fp );
+	}
+	zone_unlock_( &zones_lock_ );
+
+	errno = 0;
+	return true;
+}
+
+// ----------------------------------------
+// void msutimer_zones_reset( void );
+/**
+ * Zeroes the counts, totals and histograms of all the named zones passed
+ * through so far (e.g. after a warm-up phase of the program).
+ *
+ * @remarks
+ *		The zones stay registered. Passes that complete while it runs may be
+ *		partially lost.
+ * @sa
+ *		msutimer_zones_dump()
+ */
+void msutimer_zones_reset( void )
+{
+	errno = 0;
+	zone_lock_( &zones_lock_ );
+	for (MSUTimerZone *z = zones_; z; z = z->next) {
+		MSUT_ATOMIC_STORE_( &z->count, 0 );
+		MSUT_ATOMIC_STORE_( &z->ticks, 0 );
+		zone_lock_( &z->lock );
+		if ( z->hist ) {
+			msutimer_hist_reset( z->hist );
+		}
+		for (MSUTimerZoneSlot *slot = z->slots; slot; slot = slot->next) {
+			MSUT_ATOMIC_STORE_( &slot->count, 0 );
+			MSUT_ATOMIC_STORE_( &slot->ticks, 0 );
+			if ( slot->hist ) {
+				msutimer_hist_reset( slot->hist );
+			}
+		}
+		zone_unlock_( &z->lock );
+	}
+	zone_unlock_( &zones_lock_ );
+}
+
+/* ----------------------------------
+ * Event Trace
+ * ----------------------------------
+ */
+
+int64_t msutimer_tracing_ = 0;		// non-zero while a trace is running
+
+#if MSUT_HAS_THREADS && defined(MSUT_THREAD_LOCAL_)
+
+// A recorded event: a complete zone pass, in ticks of the default clock source
+typedef struct MSUTimerTraceEvent_ {
+	uint64_t start;
+	uint64_t ticks;
+	const char *name;
+} MSUTimerTraceEvent_;
+
+// Single-producer (its thread), single-consumer (the writer thread) ring buffer
+typedef struct MSUTimerRing_ {
+	int64_t head;		// written by the producer only
+	unsigned char pad1[ MSUT_CACHELINE - sizeof(int64_t) ];
+	int64_t tail;		// written by the consumer only
+	unsigned char pad2[ MSUT_CACHELINE - sizeof(int64_t) ];
+	int64_t dropped;	// events lost because the buffer was full
+	MSUTimerTraceEvent_ *events;
+	unsigned char pad3[ MSUT_CACHELINE ];
+} MSUTimerRing_;
+
+static struct {
+	FILE *fp;
+	MSUTimerRing_ *rings;
+	MSUTimerTraceEvent_ *events;
+	size_t nrings;
+	size_t mask;			// capacity of each ring - 1
+	int64_t nclaimed;		// rings claimed by threads so far
+	int64_t unclaimed;		// events lost because there were no rings left
+	int64_t gen;			// trace session, to invalidate stale thread-local rings
+	int64_t stop;			// tells the writer thread to exit
+	bool first;				// no event written yet
+	MSUTimerTime t0;		// trace start, in ticks of the default clock source
+	double usecs_per_tick;
+	MSUTimerThread_ writer;
+	MSUTimerThreadArg_ warg;
+} trace_;
+
+// the ring of the calling thread, for the trace session gen
+static MSUT_THREAD_LOCAL_ int64_t trace_tls_gen_ = 0;
+static MSUT_THREAD_LOCAL_ MSUTimerRing_ *trace_tls_ring_ = NULL;
+
+// ----------------------------------------
+// Write a JSON string (the name of an event), escaping it as needed
+//
+static void trace_puts_json_( const char *str, FILE *fp )
+{
+	fputc( '"', fp );
+	for (const unsigned char *c = (const unsigned char *)str; *c; c++) {
+		if ( '"' == *c || '\\' == *c ) {
+			fputc( '\\', fp );
+			fputc( *c, fp );
+		}
+		else if ( *c < 0x20 ) {
+			fprintf( fp, "\\u%04x", *c );
+		}
+		else {
+			fputc( *c, fp );
+		}
+	}
+	fputc( '"', fp );
+}
+
+// ----------------------------------------
+// Write all the pending events of all rings, as Chrome Trace Event "complete"
+// events (called by the writer thread, and by msutimer_trace_stop() after it)
+//
+static void trace_flush_( void )
+{
+	for (size_t r=0; r < trace_.nrings; r++) {
+		MSUTimerRing_ *ring = &trace_.rings[r];
+		int64_t tail = ring->tail;
+		int64_t head = MSUT_ATOMIC_LOAD_( &ring->head );
+		for (; tail < head; tail++) {
+			const MSUTimerTraceEvent_ *ev = &ring->events[ (size_t)tail & trace_.mask ];
+			fputs( trace_.first ? "\n" : ",\n", trace_.fp );
+			trace_.first = false;
+			fputs( "{\"name\":", trace_.fp );
+			trace_puts_json_( ev->name ? ev->name : "", trace_.fp );
+			fprintf( trace_.fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+				r + 1,
+				(double)(int64_t)(ev->start - trace_.t0) * trace_.usecs_per_tick,
+				(double)ev->ticks * trace_.usecs_per_tick );
+		}
+		MSUT_ATOMIC_STORE_( &ring->tail, tail );
+	}
+}
+
+static void trace_writer_( void *unused )
+{
+	(void)unused;
+	while ( 0 == MSUT_ATOMIC_LOAD_(&trace_.stop) ) {
+		trace_flush_();
+#if MSUT_OS_WINDOWS
+		Sleep( MSUT_TRACE_FLUSH_USECS / 1000 );
+#else
+		struct timespec ts = { MSUT_TRACE_FLUSH_USECS / 1000000, (MSUT_TRACE_FLUSH_USECS % 1000000) * 1000L };
+		nanosleep( &ts, NULL );
+#endif
+	}
+}
+
+#endif	// MSUT_HAS_THREADS && defined(MSUT_THREAD_LOCAL_)
+
+// ----------------------------------------
+// bool msutimer_trace_start( const char *fname, size_t nthreads, size_t capacity );
+/**
+ * Starts recording an event trace: a timeline of the passes through the named
+ * zones (see MSUT_ZONE_BEGIN()) and of the events of msutimer_trace_event(),
+ * written to a file in the Chrome Trace Event JSON format.
+ *
+ * All memory is allocated here: each of up to `nthreads` recording threads gets
+ * its own ring buffer of `capacity` fixed-size events, on its first event. A
+ * background thread empties the buffers into the file every
+ * `MSUT_TRACE_FLUSH_USECS` *microseconds* (10000 by default).
+ *
+ * @param fname
+ *		The name of the file to be created (e.g. "trace.json").
+ * @param nthreads
+ *		The maximum number of recording threads. Events of any further threads
+ *		are dropped.
+ * @param capacity
+ *		The number of events per ring buffer (rounded up to a power of 2). When a
+ *		buffer is full, further events of its thread are dropped until the
+ *		background thread catches up.
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		The file can be opened in [Perfetto](https://ui.perfetto.dev) or in
+ *		`chrome://tracing`. Each recording thread appears as a separate track,
+ *		in the order the threads recorded their first events.
+ *
+ *		Only one trace may run at a time, and it must be stopped with
+ *		msutimer_trace_stop().
+ * @par Failures:
+ * 		- fname is `NULL`, nthreads or capacity is 0 (`errno` is set to `EDOM`)
+ * 		- a trace is already running (`errno` is set to `EBUSY`)
+ * 		- no thread support on this platform (`errno` is set to `ENOSYS`)
+ * 		- the file cannot be created, memory allocation or thread creation
+ * 		  failure (`errno` is set by the C runtime)
+ * @sa
+ *		msutimer_trace_stop(), msutimer_trace_event(), MSUT_ZONE_BEGIN()
+ */
+bool msutimer_trace_start( const char *fname, size_t nthreads, size_t capacity )
+{
+	errno = 0;
+	if ( !fname || 0 == nthreads || 0 == capacity ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (fname=NULL, nthreads=0 or capacity=0). Return: false" );
+		return false;
+	}
+
+#if MSUT_HAS_THREADS && defined(MSUT_THREAD_LOCAL_)
+	if ( MSUT_ATOMIC_LOAD_(&msutimer_tracing_) || trace_.fp ) {
+		errno = EBUSY;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EBUSY) a trace is already running. Return: false" );
+		return false;
+	}
+
+	size_t cap = 1;
+	while ( cap < capacity ) {
+		cap <<= 1;
+	}
+
+	MSUTimerTime freq;
+	MSUTimerClock source = resolve_clock_( MSUT_CLOCK_DEFAULT );
+	if ( !get_msutfreq_( source, &freq, &trace_.usecs_per_tick ) ) {
+		errno = ERANGE;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(ERANGE) get_msutfreq_() failed. Return: false" );
+		return false;
+	}
+
+	trace_.rings = calloc( nthreads, sizeof(MSUTimerRing_) );
+	trace_.events = malloc( nthreads * cap * sizeof(MSUTimerTraceEvent_) );
+	if ( !trace_.rings || !trace_.events ) {
+		MSUT_DBGMSG( "ERROR", "allocation of %zu ring buffers failed. Return: false\n", nthreads );
+		goto fail;
+	}
+	// pre-fault them, so recording never page-faults
+	memset( trace_.events, 0, nthreads * cap * sizeof(MSUTimerTraceEvent_) );
+	for (size_t i=0; i < nthreads; i++) {
+		trace_.rings[i].events = &trace_.events[ i * cap ];
+	}
+
+	trace_.fp = fopen( fname, "w" );
+	if ( !trace_.fp ) {
+		MSUT_DBGMSG( "ERROR", "fopen(\"%s\") failed. Return: false\n", fname );
+		goto fail;
+	}
+	fputs( "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", trace_.fp );
+
+	trace_.nrings = nthreads;
+	trace_.mask = cap - 1;
+	trace_.nclaimed = 0;
+	trace_.unclaimed = 0;
+	trace_.stop = 0;
+	trace_.first = true;
+	get_msuttime_( source, &trace_.t0 );
+
+	trace_.warg.fn = trace_writer_;
+	trace_.warg.arg = NULL;
+	if ( !thread_start_( &trace_.writer, &trace_.warg ) ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "cannot start the writer thread. Return: false" );
+		goto fail;
+	}
+
+	MSUT_ATOMIC_FETCH_ADD_( &trace_.gen, 1 );
+	MSUT_ATOMIC_STORE_( &msutimer_tracing_, 1 );
+	return true;
+
+fail:
+	{
+		int err = errno;
+		if ( trace_.fp ) {
+			fclose( trace_.fp );
+			remove( fname );
+			trace_.fp = NULL;
+		}
+		free( trace_.events );
+		free( trace_.rings );
+		trace_.events = NULL;
+		trace_.rings = NULL;
+		trace_.nrings = 0;
+		errno = err;
+	}
+	return false;
+
+#else
+	(void)fname; (void)nthreads; (void)capacity;
+	errno = ENOSYS;
+	MSUT_DBGMSG( "ERROR", "%s\n", "(ENOSYS) no thread support on this platform. Return: false" );
+	return false;
+#endif
+}
+
+// ----------------------------------------
+// bool msutimer_trace_event( const char *name, uint64_t start, uint64_t ticks );
+/**
+ * Records an event into the running trace (see msutimer_trace_start()).
+ *
+ * The named zones call it on each pass while a trace is running; it may also
+ * be called directly, e.g. with the ticks of msutimer_inline_start() &
+ * msutimer_inline_stop().
+ *
+ * @param name
+ *		The name of the event. It is stored as a pointer, so it must stay valid
+ *		until msutimer_trace_stop() (e.g. a string literal).
+ * @param start
+ *		The start of the event, in ticks of the default clock source (e.g. of
+ *		msutimer_inline_now_ticks(), or of msutimer_now_ticks() on a timer
+ *		created with msutimer_new()).
+ * @param ticks
+ *		The duration of the event, in ticks of the same clock.
+ * @return
+ *		`true` if the event was recorded, `false` if there is no running trace,
+ *		or if the event was dropped.
+ * @remarks
+ *		It never allocates, locks or waits: it writes a fixed-size record into
+ *		the ring buffer of the calling thread, or drops the event if the buffer
+ *		is full. Like the other raw tick functions, it does not touch `errno`.
+ * @sa
+ *		msutimer_trace_start(), msutimer_trace_stop()
+ */
+bool msutimer_trace_event( const char *name, uint64_t start, uint64_t ticks )
+{
+#if MSUT_HAS_THREADS && defined(MSUT_THREAD_LOCAL_)
+	if ( 0 == MSUT_ATOMIC_LOAD_(&msutimer_tracing_) ) {
+		return false;
+	}
+
+	// claim a ring on the first event of the thread in this trace session
+	int64_t gen = MSUT_ATOMIC_LOAD_( &trace_.gen );
+	if ( trace_tls_gen_ != gen ) {
+		int64_t i = MSUT_ATOMIC_FETCH_ADD_( &trace_.nclaimed, 1 );
+		trace_tls_ring_ = i < (int64_t)trace_.nrings ? &trace_.rings[i] : NULL;
+		trace_tls_gen_ = gen;
+	}
+
+	MSUTimerRing_ *ring = trace_tls_ring_;
+	if ( !ring ) {
+		MSUT_ATOMIC_FETCH_ADD_( &trace_.unclaimed, 1 );
+		return false;
+	}
+
+	int64_t head = ring->head;
+	if ( head - MSUT_ATOMIC_LOAD_(&ring->tail) > (int64_t)trace_.mask ) {
+		ring->dropped++;
+		return false;
+	}
+	MSUTimerTraceEvent_ *ev = &ring->events[ (size_t)head & trace_.mask ];
+	ev->start = start;
+	ev->ticks = ticks;
+	ev->name = name;
+	MSUT_ATOMIC_STORE_( &ring->head, head + 1 );
+	return true;
+
+#else
+	(void)name; (void)start; (void)ticks;
+	return false;
+#endif
+}
+
+// ----------------------------------------
+// bool msutimer_trace_stop( uint64_t *dropped );
+/**
+ * Stops the running trace (see msutimer_trace_start()), writes all its
+ * pending events, and closes its file.
+ *
+ * @param dropped
+ *		If non-`NULL`, it passes back to the caller the number of events that
+ *		were dropped, because their ring buffers were full or because there
+ *		were more recording threads than the maximum.
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		The ring buffers are freed here, so no other thread may be recording
+ *		events (or passing through named zones) while it runs.
+ * @par Failures:
+ * 		- no trace is running (`errno` is set to `EDOM`)
+ * 		- the file could not be written (`errno` is set by the C runtime)
+ * @sa
+ *		msutimer_trace_start()
+ */
+bool msutimer_trace_stop( uint64_t *dropped )
+{
+	errno = 0;
+	if ( dropped ) {
+		*dropped = 0;
+	}
+
+#if MSUT_HAS_THREADS && defined(MSUT_THREAD_LOCAL_)
+	if ( !trace_.fp ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) no trace is running. Return: false" );
+		return false;
+	}
+
+	MSUT_ATOMIC_STORE_( &msutimer_tracing_, 0 );
+	MSUT_ATOMIC_STORE_( &trace_.stop, 1 );
+	thread_join_( trace_.writer );
+	trace_flush_();
+
+	// name the threads' tracks, and close the JSON
+	uint64_t lost = (uint64_t)trace_.unclaimed;
+	size_t nused = (size_t)trace_.nclaimed < trace_.nrings ? (size_t)trace_.nclaimed : trace_.nrings;
+	for (size_t r=0; r < nused; r++) {
+		fprintf( trace_.fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"thread %zu\"}}",
+			trace_.first ? "\n" : ",\n", r + 1, r + 1 );
+		trace_.first = false;
+		lost += (uint64_t)trace_.rings[r].dropped;
+	}
+	fputs( "\n]}\n", trace_.fp );
+
+	bool ret = !ferror( trace_.fp );
+	if ( 0 != fclose( trace_.fp ) ) {
+		ret = false;
+	}
+	if ( !ret ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "writing the trace file failed. Return: false" );
+	}
+	int err = errno;
+	free( trace_.events );
+	free( trace_.rings );
+	trace_.fp = NULL;
+	trace_.events = NULL;
+	trace_.rings = NULL;
+	trace_.nrings = 0;
+
+	if ( dropped ) {
+		*dropped = lost;
+	}
+	errno = ret ? 0 : err;
+	return ret;
+
+#else
+	errno = EDOM;
+	MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) no trace is running. Return: false" );
+	return false;
+#endif
+}
+
+/* ----------------------------------
+ * Binary Sample Logs
+ * ----------------------------------
+ */
+
+// File layout: a 64-byte header of little-endian fields, followed by the
+// samples as zigzag-encoded LEB128 varints of their difference from the
+// previous sample (the first one from 0).
+#define MSUT_LOG_MAGIC_			"MSUTLOG"	// plus its '\0'
+#define MSUT_LOG_VERSION_		1u
+#define MSUT_LOG_HEADER_SIZE_	64
+enum {
+	MSUT_LOG_OFF_VERSION_	= 8,	// uint32
+	MSUT_LOG_OFF_SOURCE_	= 12,	// uint32 (MSUTimerClock)
+	MSUT_LOG_OFF_FREQ_		= 16,	// uint64, ticks per sec
+	MSUT_LOG_OFF_TICKS_		= 24,	// uint64, clock ticks at creation
+	MSUT_LOG_OFF_TIME_		= 32,	// int64, calendar time at creation (secs since the Epoch)
+	MSUT_LOG_OFF_COUNT_		= 40,	// uint64, number of samples
+	MSUT_LOG_OFF_SIZE_		= 48	// uint64, bytes of samples after the header
+};
+
+struct MSUTimerLog_ {
+	unsigned char *map;		// the mapped file
+	size_t mapsize;			// its size
+	size_t pos;				// write offset
+	uint64_t prev;			// previous sample
+	uint64_t count;			// samples written
+	bool failed;			// a resize failed: samples are dropped
+#if MSUT_OS_WINDOWS
+	HANDLE file, mapping;
+#elif MSUT_OS_POSIX
+	int fd;
+#endif
+};
+
+static void put_le_( unsigned char *p, uint64_t v, int nbytes )
+{
+	for (int i=0; i < nbytes; i++) {
+		p[i] = (unsigned char)(v >> (8*i));
+	}
+}
+
+static uint64_t get_le_( const unsigned char *p, int nbytes )
+{
+	uint64_t v = 0;
+	for (int i=0; i < nbytes; i++) {
+		v |= (uint64_t)p[i] << (8*i);
+	}
+	return v;
+}
+
+#if MSUT_OS_WINDOWS || MSUT_OS_POSIX
+// ----------------------------------------
+// (Re)map the log file with the specified size, growing it. Return false on error.
+//
+static bool log_map_( MSUTimerLog *log, size_t size )
+{
+#if MSUT_OS_WINDOWS
+	if ( log->map ) {
+		UnmapViewOfFile( log->map );
+		CloseHandle( log->mapping );
+		log->map = NULL;
+	}
+	log->mapping = CreateFileMappingA( log->file, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL );
+	if ( !log->mapping ) {
+		return false;
+	}
+	log->map = MapViewOfFile( log->mapping, FILE_MAP_WRITE, 0, 0, size );
+	if ( !log->map ) {
+		CloseHandle( log->mapping );
+		return false;
+	}
+#else
+	if ( log->map ) {
+		munmap( log->map, log->mapsize );
+		log->map = NULL;
+	}
+	if ( 0 != ftruncate(log->fd, (off_t)size) ) {
+		return false;
+	}
+	void *map = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, 0 );
+	if ( MAP_FAILED == map ) {
+		return false;
+	}
+	log->map = map;
+#endif
+	log->mapsize = size;
+	return true;
+}
+
+// ----------------------------------------
+// Write the sample count & size into the header of the mapped file
+//
+static void log_sync_header_( MSUTimerLog *log )
+{
+	put_le_( log->map + MSUT_LOG_OFF_COUNT_, log->count, 8 );
+	put_le_( log->map + MSUT_LOG_OFF_SIZE_, log->pos - MSUT_LOG_HEADER_SIZE_, 8 );
+}
+#endif
+
+// ----------------------------------------
+// Append a sample to the log (a varint takes at most 10 bytes)
+//
+static void log_put_( MSUTimerLog *log, uint64_t ticks )
+{
+#if MSUT_OS_WINDOWS || MSUT_OS_POSIX
+	if ( log->failed ) {
+		return;
+	}
+	if ( log->pos + 10 > log->mapsize ) {
+		log_sync_header_( log );
+		size_t grow = log->mapsize / 4 > MSUT_LOG_CHUNK ? log->mapsize / 4 : MSUT_LOG_CHUNK;
+		size_t pos = log->pos;
+		if ( !log_map_(log, log->mapsize + grow) ) {
+			MSUT_DBGMSG( "ERROR", "cannot grow the sample log to %zu bytes: dropping samples.\n", log->mapsize + grow );
+			log->failed = true;
+			return;
+		}
+		log->pos = pos;
+	}
+
+	int64_t delta = (int64_t)(ticks - log->prev);
+	uint64_t z = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);	// zigzag
+	unsigned char *p = log->map + log->pos;
+	while ( z >= 0x80 ) {
+		*p++ = (unsigned char)(z | 0x80);
+		z >>= 7;
+	}
+	*p++ = (unsigned char)z;
+	log->pos = (size_t)(p - log->map);
+	log->prev = ticks;
+	log->count++;
+#else
+	(void)log; (void)ticks;
+#endif
+}
+
+// ----------------------------------------
+// MSUTimerLog *msutimer_log_new( const char *fname, const MSUTimer *timer );
+/**
+ * Creates a new binary sample log: a memory-mapped file, into which the raw
+ * samples of a timer's benchmark functions can be streamed (see
+ * msutimer_attach_log()).
+ *
+ * The file starts with a small header (the timer's clock source and frequency,
+ * and the clock's ticks and the calendar time at creation). The samples follow
+ * as the differences of their ticks from the previous ones, zigzag & varint
+ * encoded, so typical samples take 1 to 3 bytes each. The file grows on demand,
+ * by at least `MSUT_LOG_CHUNK` bytes (1 MB by default) at a time.
+ *
+ * @param fname
+ *		The name of the file to be created (it is overwritten if it exists).
+ * @param timer
+ *		The timer whose clock source is recorded in the header.
+ * @return
+ *		A pointer to the newly created log, or `NULL` on error.
+ * @remarks
+ *		The header is updated every time the file grows, so if the process
+ *		dies the log is readable up to then. Destroy the log with
+ *		msutimer_log_free() to write it out completely. msutimer_log_read()
+ *		reads it back.
+ * @par Failures:
+ * 		- fname or timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- no memory-mapped files on this platform (`errno` is set to `ENOSYS`)
+ * 		- the file cannot be created or mapped, or memory allocation failure
+ * 		  (`errno` is set by the C runtime)
+ * @sa
+ *		msutimer_log_free(), msutimer_attach_log(), msutimer_log_read()
+ */
+MSUTimerLog *msutimer_log_new( const char *fname, const MSUTimer *timer )
+{
+	errno = 0;
+	if ( !fname || !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (fname=NULL or timer=NULL). Return: NULL" );
+		return NULL;
+	}
+
+#if MSUT_OS_WINDOWS || MSUT_OS_POSIX
+	MSUTimerLog *log = calloc( 1, sizeof(*log) );
+	if ( !log ) {
+		MSUT_DBGMSG( "ERROR", "calloc(%zu) failed. Return: NULL\n", sizeof(*log) );
+		return NULL;
+	}
+
+#if MSUT_OS_WINDOWS
+	log->file = CreateFileA( fname, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( INVALID_HANDLE_VALUE == log->file ) {
+		errno = EACCES;
+		MSUT_DBGMSG( "ERROR", "cannot create \"%s\". Return: NULL\n", fname );
+		free( log );
+		return NULL;
+	}
+#else
+	log->fd = open( fname, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+	if ( log->fd < 0 ) {
+		MSUT_DBGMSG( "ERROR", "cannot create \"%s\". Return: NULL\n", fname );
+		free( log );
+		return NULL;
+	}
+#endif
+	if ( !log_map_(log, MSUT_LOG_CHUNK) ) {
+		MSUT_DBGMSG( "ERROR", "cannot map \"%s\". Return: NULL\n", fname );
+		int err = errno;
+		msutimer_log_free( log );
+		remove( fname );
+		errno = err;
+		return NULL;
+	}
+
+	MSUTimerTime now = 0;
+	get_msuttime_( timer->source, &now );
+	memcpy( log->map, MSUT_LOG_MAGIC_, sizeof(MSUT_LOG_MAGIC_) );
+	put_le_( log->map + MSUT_LOG_OFF_VERSION_, MSUT_LOG_VERSION_, 4 );
+	put_le_( log->map + MSUT_LOG_OFF_SOURCE_, (uint64_t)timer->source, 4 );
+	put_le_( log->map + MSUT_LOG_OFF_FREQ_, timer->freq, 8 );
+	put_le_( log->map + MSUT_LOG_OFF_TICKS_, now, 8 );
+	put_le_( log->map + MSUT_LOG_OFF_TIME_, (uint64_t)(int64_t)time(NULL), 8 );
+	log->pos = MSUT_LOG_HEADER_SIZE_;
+	log_sync_header_( log );
+	return log;
+
+#else
+	errno = ENOSYS;
+	MSUT_DBGMSG( "ERROR", "%s\n", "(ENOSYS) no memory-mapped files on this platform. Return: NULL" );
+	return NULL;
+#endif
+}
+
+// ----------------------------------------
+// MSUTimerLog *msutimer_log_free( MSUTimerLog *log );
+/**
+ * Writes out and closes the file of a binary sample log, and destroys the log.
+ *
+ * The file is truncated to its actual size. The log must first be detached
+ * from any timer (see msutimer_attach_log()).
+ *
+ * @param log
+ *		The log to be destroyed.
+ * @return
+ *		`NULL`. On errors writing out the file, `errno` is set to non-zero.
+ * @sa
+ *		msutimer_log_new()
+ */
+MSUTimerLog *msutimer_log_free( MSUTimerLog *log )
+{
+	errno = 0;
+	if ( !log ) {
+		return NULL;
+	}
+
+#if MSUT_OS_WINDOWS
+	if ( log->map ) {
+		log_sync_header_( log );
+		if ( !FlushViewOfFile(log->map, 0) ) {
+			errno = EIO;
+		}
+		UnmapViewOfFile( log->map );
+		CloseHandle( log->mapping );
+		LARGE_INTEGER li;
+		li.QuadPart = (LONGLONG)log->pos;
+		if ( !SetFilePointerEx(log->file, li, NULL, FILE_BEGIN) || !SetEndOfFile(log->file) ) {
+			errno = EIO;
+		}
+	}
+	CloseHandle( log->file );
+#elif MSUT_OS_POSIX
+	if ( log->map ) {
+		log_sync_header_( log );
+		if ( 0 != munmap(log->map, log->mapsize) || 0 != ftruncate(log->fd, (off_t)log->pos) ) {
+			MSUT_DBGMSG( "ERROR", "%s\n", "cannot write out the sample log." );
+		}
+	}
+	if ( 0 != close(log->fd) ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "cannot close the sample log." );
+	}
+#endif
+	if ( log->failed && 0 == errno ) {
+		errno = ENOSPC;
+	}
+	free( log );
+	return NULL;
+}
+
+// ----------------------------------------
+// bool msutimer_attach_log( MSUTimer *timer, MSUTimerLog *log );
+/**
+ * Attaches a binary sample log to its timer argument (or detaches it).
+ *
+ * While attached, every sample timed by the benchmark functions that time
+ * each call (or batch of calls) of their callback-function is appended to the
+ * log, as raw clock ticks (before any overhead subtraction, see
+ * msutimer_subtract_overhead()). Warm-up samples are not logged, and
+ * msutimer_bench() is not either, as it times all its iterations at once.
+ *
+ * @param timer
+ *		The timer to be modified.
+ * @param log
+ *		The log to be attached (created with the same timer), or `NULL` to
+ *		detach the current one.
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		A log may be attached to only one timer at a time, and its timer must
+ *		not be used by several threads at once. If the file cannot grow, the
+ *		further samples are dropped and msutimer_log_free() reports it.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_log_new(), msutimer_log_read()
+ */
+bool msutimer_attach_log( MSUTimer *timer, MSUTimerLog *log )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: false" );
+		return false;
+	}
+	timer->log = log;
+	return true;
+}
+
+// ----------------------------------------
+// bool msutimer_log_read( const char *fname, MSUTimerLogInfo *info, bool (*callback)(void *, uint64_t), void *userdata );
+/**
+ * Reads a binary sample log (see msutimer_log_new()), passing its samples one
+ * by one to a callback-function.
+ *
+ * The file is memory-mapped and decoded sequentially, so it is never loaded
+ * into memory as a whole, however large it is.
+ *
+ * @param fname
+ *		The name of the log file.
+ * @param info
+ *		If non-`NULL`, it passes back to the caller the header of the log. It is
+ *		filled in before the first call of the callback-function.
+ * @param callback
+ *		If non-`NULL`, it is called with `userdata` and each sample, in *ticks*
+ *		of the clock source of the header (convert them with its `freq`). If it
+ *		returns `false`, reading stops there (and this is not an error).
+ * @param userdata
+ *		A `void` pointer to caller-defined data, passed to the callback-function.
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- fname is `NULL` (`errno` is set to `EDOM`)
+ * 		- the file is not a sample log, or it is truncated (`errno` is set to `EILSEQ`)
+ * 		- no memory-mapped files on this platform (`errno` is set to `ENOSYS`)
+ * 		- the file cannot be opened or mapped (`errno` is set by the C runtime)
+ * @sa
+ *		msutimer_log_new(), msutimer_attach_log()
+ */
+bool msutimer_log_read( const char *fname, MSUTimerLogInfo *info, bool (*callback)(void *, uint64_t), void *userdata )
+{
+	errno = 0;
+	if ( !fname ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (fname=NULL). Return: false" );
+		return false;
+	}
+
+#if MSUT_OS_WINDOWS || MSUT_OS_POSIX
+	const unsigned char *map = NULL;
+	size_t size = 0;
+	bool ret = false;
+
+#if MSUT_OS_WINDOWS
+	HANDLE file = CreateFileA( fname, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	HANDLE mapping = NULL;
+	LARGE_INTEGER li;
+	if ( INVALID_HANDLE_VALUE == file ) {
+		errno = ENOENT;
+		MSUT_DBGMSG( "ERROR", "cannot open \"%s\". Return: false\n", fname );
+		return false;
+	}
+	if ( GetFileSizeEx(file, &li) && li.QuadPart > 0 ) {
+		size = (size_t)li.QuadPart;
+		mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+		map = mapping ? MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) : NULL;
+	}
+#else
+	int fd = open( fname, O_RDONLY );
+	struct stat st;
+	if ( fd < 0 ) {
+		MSUT_DBGMSG( "ERROR", "cannot open \"%s\". Return: false\n", fname );
+		return false;
+	}
+	if ( 0 == fstat(fd, &st) && st.st_size > 0 ) {
+		size = (size_t)st.st_size;
+		void *p = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( MAP_FAILED != p ) {
+			map = p;
+	#ifdef MADV_SEQUENTIAL
+			madvise( p, size, MADV_SEQUENTIAL );
+	#endif
+		}
+	}
+#endif
+
+	if ( !map ) {
+		if ( 0 == errno ) {
+			errno = EILSEQ;
+		}
+		MSUT_DBGMSG( "ERROR", "cannot map \"%s\". Return: false\n", fname );
+		goto done;
+	}
+	if ( size < MSUT_LOG_HEADER_SIZE_
+	|| 0 != memcmp(map, MSUT_LOG_MAGIC_, sizeof(MSUT_LOG_MAGIC_))
+	|| get_le_(map + MSUT_LOG_OFF_VERSION_, 4) != MSUT_LOG_VERSION_
+	) {
+		errno = EILSEQ;
+		MSUT_DBGMSG( "ERROR", "(EILSEQ) \"%s\" is not a sample log. Return: false\n", fname );
+		goto done;
+	}
+
+	uint64_t count = get_le_( map + MSUT_LOG_OFF_COUNT_, 8 );
+	uint64_t paysize = get_le_( map + MSUT_LOG_OFF_SIZE_, 8 );
+	if ( paysize > size - MSUT_LOG_HEADER_SIZE_ ) {
+		errno = EILSEQ;
+		MSUT_DBGMSG( "ERROR", "(EILSEQ) \"%s\" is truncated. Return: false\n", fname );
+		goto done;
+	}
+	if ( info ) {
+		info->source = (MSUTimerClock) get_le_( map + MSUT_LOG_OFF_SOURCE_, 4 );
+		info->freq = get_le_( map + MSUT_LOG_OFF_FREQ_, 8 );
+		info->start_ticks = get_le_( map + MSUT_LOG_OFF_TICKS_, 8 );
+		info->start_time = (int64_t) get_le_( map + MSUT_LOG_OFF_TIME_, 8 );
+		info->nsamples = count;
+	}
+
+	const unsigned char *p = map + MSUT_LOG_HEADER_SIZE_;
+	const unsigned char *end = p + paysize;
+	uint64_t prev = 0;
+	ret = true;
+	while ( callback && p < end ) {
+		uint64_t z = 0;
+		int shift = 0;
+		while ( p < end && (*p & 0x80) && shift < 63 ) {
+			z |= (uint64_t)(*p++ & 0x7f) << shift;
+			shift += 7;
+		}
+		if ( p == end ) {
+			errno = EILSEQ;
+			MSUT_DBGMSG( "ERROR", "(EILSEQ) \"%s\" ends in a partial sample. Return: false\n", fname );
+			ret = false;
+			break;
+		}
+		z |= (uint64_t)*p++ << shift;
+		prev += (uint64_t)((int64_t)(z >> 1) ^ -(int64_t)(z & 1));	// un-zigzag
+		if ( !callback(userdata, prev) ) {
+			break;
+		}
+	}
+
+done:
+	{
+		int err = errno;
+#if MSUT_OS_WINDOWS
+		if ( map ) {
+			UnmapViewOfFile( map );
+		}
+		if ( mapping ) {
+			CloseHandle( mapping );
+		}
+		CloseHandle( file );
+#else
+		if ( map ) {
+			munmap( (void *)map, size );
+		}
+		close( fd );
+#endif
+		errno = err;
+	}
+	return ret;
+
+#else
+	(void)info; (void)callback; (void)userdata;
+	errno = ENOSYS;
+	MSUT_DBGMSG( "ERROR", "%s\n", "(ENOSYS) no memory-mapped files on this platform. Return: false" );
+	return false;
+#endif
+}
+
+/* ----------------------------------
+ * Hardware Performance Counters
+ * ----------------------------------
+ */
+
+// ----------------------------------------
+// bool msutimer_perf_enable( MSUTimer *timer, bool enable );
+/**
+ * Enables (or disables) hardware performance counters on its timer argument.
+ *
+ * When enabled, the benchmark functions that time each call (or batch of calls)
+ * of their callback-function also count CPU cycles, retired instructions, cache
+ * misses and branch misses in the same window, in user-space only. The per-call
+ * counts and the instructions per cycle of the latest run are then reported by
+ * msutimer_perf_counters(), and in the `counters` member of ::MSUTimerStats.
+ *
+ * @param timer
+ *		The timer to be modified.
+ * @param enable
+ *		`true` to open the counters, `false` to close them.
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		The counters are a `perf_event_open()` group of the calling thread, so
+ *		they are available only on Linux, and only if the kernel allows it (see
+ *		`/proc/sys/kernel/perf_event_paranoid`; inside virtual machines and
+ *		containers they are often missing). On x86 they are read with the
+ *		`rdpmc` instruction when the kernel allows it (about 100 cycles for all
+ *		4 of them), and with a `read()` system call otherwise; either way the
+ *		reads are done outside the timed window of the clock.
+ *
+ *		The timer must then be used only by the thread that enabled them.
+ *		Counting is not supported by msutimer_bench() (it times all its
+ *		iterations at once) and msutimer_bench_parallel().
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- not on Linux (`errno` is set to `ENOSYS`)
+ * 		- the counters cannot be opened (`errno` is set by the kernel, e.g. to
+ * 		  `EACCES`, `ENOENT` or `EOPNOTSUPP`)
+ * @sa
+ *		msutimer_perf_counters(), msutimer_bench_stats()
+ */
+bool msutimer_perf_enable( MSUTimer *timer, bool enable )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: false" );
+		return false;
+	}
+
+	if ( !enable ) {
+		timer->perf = perf_close_( timer->perf );
+		return true;
+	}
+	if ( !timer->perf ) {
+		timer->perf = perf_open_();
+		if ( !timer->perf ) {
+			MSUT_DBGMSG( "ERROR", "cannot open the performance counters (errno: %d). Return: false\n", errno );
+			return false;
+		}
+	}
+	return true;
+}
+
+// ----------------------------------------
+// bool msutimer_perf_counters( const MSUTimer *timer, MSUTimerCounters *counters );
+/**
+ * Queries its timer argument for the hardware performance counters of its
+ * latest benchmark run (see msutimer_perf_enable()).
+ *
+ * @param timer
+ *		The timer to be queried.
+ * @param counters
+ *		It passes back to the caller the counts per call of the callback-function.
+ *		Its `valid` member is `false` if the counters are not enabled, or if no
+ *		call was counted yet.
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- timer or counters is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_perf_enable()
+ */
+bool msutimer_perf_counters( const MSUTimer *timer, MSUTimerCounters *counters )
+{
+	errno = 0;
+	if ( !timer || !counters ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL or counters=NULL). Return: false" );
+		return false;
+	}
+	perf_get_( timer->perf, counters );
+	return true;
+}
+
+/* ----------------------------------
+ * Memory Allocation Tracking
+ * ----------------------------------
+ */
+
+// ----------------------------------------
+// bool msutimer_alloc_enable( MSUTimer *timer, bool enable );
+/**
+ * Enables (or disables) memory allocation tracking on its timer argument.
+ *
+ * When enabled, the benchmark functions that time each call (or batch of calls)
+ * of their callback-function also count the allocations, de-allocations and
+ * allocated bytes of the calling thread in the same window. The per-call counts
+ * of the latest run, along with the growth of the peak resident set size of the
+ * process, are then reported by msutimer_alloc_counts(), and in the `allocs`
+ * member of ::MSUTimerStats.
+ *
+ * The allocations are counted by msutimer_alloc_note() and msutimer_free_note().
+ * To have them called by the standard allocator, compile msutimer.c with
+ * `-DMSUT_MALLOC_WRAP`, and link the program with the GNU (or LLVM) linker
+ * option `-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free`: it
+ * redirects the calls of all the statically linked code to wrappers, which
+ * count them and forward them to the C runtime. Calls made inside shared
+ * libraries, and other allocators, are not redirected: call the note
+ * functions from their hooks instead (e.g. in a custom allocator, or in an
+ * `LD_PRELOAD` shim).
+ *
+ * @param timer
+ *		The timer to be modified.
+ * @param enable
+ *		`true` to start tracking, `false` to stop it.
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		Each `realloc()` counts as an allocation, and as a de-allocation of its
+ *		old block (if any). The counts are per thread, so allocations done by
+ *		other threads (e.g. by a thread pool serving the callback-function) are
+ *		not included, and the timer must be used only by the calling thread.
+ *		Without compiler support for thread-local storage, the allocations of
+ *		all threads are counted.
+ *
+ *		The peak resident set size is process-wide (`getrusage()` on POSIX,
+ *		`GetProcessMemoryInfo()` on Windows), so it grows only when a run needs
+ *		more memory than the process ever did before; it is measured from the
+ *		start of the timed iterations until the counts are queried (at the end
+ *		of the run, for msutimer_bench_stats()).
+ *
+ *		Tracking is not supported by msutimer_bench() (it times all its
+ *		iterations at once) and msutimer_bench_parallel().
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_alloc_counts(), msutimer_bench_stats()
+ */
+bool msutimer_alloc_enable( MSUTimer *timer, bool enable )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: false" );
+		return false;
+	}
+
+	memset( &timer->alloc, 0, sizeof(timer->alloc) );
+	timer->alloc.enabled = enable;
+	timer->alloc.rss0 = -1;
+	return true;
+}
+
+// ----------------------------------------
+// bool msutimer_alloc_counts( const MSUTimer *timer, MSUTimerAllocs *allocs );
+/**
+ * Queries its timer argument for the memory allocations of its latest
+ * benchmark run (see msutimer_alloc_enable()).
+ *
+ * @param timer
+ *		The timer to be queried.
+ * @param allocs
+ *		It passes back to the caller the counts per call of the callback-function.
+ *		Its `valid` member is `false` if the tracking is not enabled, or if no
+ *		call was counted yet.
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- timer or allocs is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_alloc_enable()
+ */
+bool msutimer_alloc_counts( const MSUTimer *timer, MSUTimerAllocs *allocs )
+{
+	errno = 0;
+	if ( !timer || !allocs ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL or allocs=NULL). Return: false" );
+		return false;
+	}
+	alloc_get_( &timer->alloc, allocs );
+	return true;
+}
+
+// ----------------------------------------
+// void msutimer_alloc_note( size_t bytes );
+/**
+ * Counts an allocation of the calling thread, if it is inside the timed
+ * window of a benchmark run with allocation tracking enabled (see
+ * msutimer_alloc_enable()); otherwise it does nothing.
+ *
+ * It is called by the `malloc()` wrappers of `MSUT_MALLOC_WRAP`, and it may be
+ * called by custom allocators. It does not allocate, nor touch `errno`.
+ *
+ * @param bytes
+ *		The size of the allocation.
+ * @sa
+ *		msutimer_free_note()
+ */
+void msutimer_alloc_note( size_t bytes )
+{
+	if ( alloc_tls_.on ) {
+		alloc_tls_.allocs++;
+		alloc_tls_.bytes += bytes;
+	}
+}
+
+// ----------------------------------------
+// void msutimer_free_note( void );
+/**
+ * Counts a de-allocation of the calling thread (see msutimer_alloc_note()).
+ */
+void msutimer_free_note( void )
+{
+	if ( alloc_tls_.on ) {
+		alloc_tls_.frees++;
+	}
+}
+
+// ----------------------------------------
+// Wrappers of the C runtime allocator, for the linker option
+// -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free
+// (see msutimer_alloc_enable())
+//
+#if defined(MSUT_MALLOC_WRAP)
+void *__real_malloc( size_t size );
+void *__real_calloc( size_t nmemb, size_t size );
+void *__real_realloc( void *ptr, size_t size );
+void __real_free( void *ptr );
+
+void *__wrap_malloc( size_t size );
+void *__wrap_calloc( size_t nmemb, size_t size );
+void *__wrap_realloc( void *ptr, size_t size );
+void __wrap_free( void *ptr );
+
+void *__wrap_malloc( size_t size )
+{
+	void *p = __real_malloc( size );
+	if ( p ) {
+		msutimer_alloc_note( size );
+	}
+	return p;
+}
+
+void *__wrap_calloc( size_t nmemb, size_t size )
+{
+	void *p = __real_calloc( nmemb, size );
+	if ( p ) {
+		msutimer_alloc_note( nmemb * size );
+	}
+	return p;
+}
+
+void *__wrap_realloc( void *ptr, size_t size )
+{
+	void *p = __real_realloc( ptr, size );
+	if ( p || 0 == size ) {
+		if ( ptr ) {
+			msutimer_free_note();
+		}
+		if ( p ) {
+			msutimer_alloc_note( size );
+		}
+	}
+	return p;
+}
+
+void __wrap_free( void *ptr )
+{
+	if ( ptr ) {
+		msutimer_free_note();
+	}
+	__real_free( ptr );
+}
+#endif	// MSUT_MALLOC_WRAP
+
+/* ----------------------------------
+ * Inline Benchmark Loops
+ * ----------------------------------
+ */
+
+const volatile void *volatile msutimer_sink_ = NULL;
+
+// ----------------------------------------
+// void msutimer_clobber_memory_( void );
+/**
+ * A compiler barrier for compilers without one (internal, used by
+ * msutimer_clobber_memory() and msutimer_do_not_optimize()): the compiler
+ * cannot see what it does, so it must assume that it reads & writes memory.
+ */
+void msutimer_clobber_memory_( void )
+{
+}
+
+// ----------------------------------------
+// MSUTimerLoop msutimer_loop_begin_( MSUTimer *timer, size_t nrepeats, MSUTimerStats *stats );
+/**
+ * Prepares a MSUT_BENCH_LOOP() (internal).
+ *
+ * @return
+ *		The state of the loop. On errors it is set up to run no iteration, and
+ *		`errno` is set (see MSUT_BENCH_LOOP()).
+ */
+MSUTimerLoop msutimer_loop_begin_( MSUTimer *timer, size_t nrepeats, MSUTimerStats *stats )
+{
+	MSUTimerLoop loop;
+
+	errno = 0;
+	memset( &loop, 0, sizeof(loop) );
+	if ( stats ) {
+		memset( stats, 0, sizeof(*stats) );
+	}
+
+	if ( !timer || !stats || 0 == nrepeats ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL, stats=NULL or n=0). No iteration." );
+		return loop;
+	}
+	if ( timer->source != resolve_clock_(MSUT_CLOCK_DEFAULT) ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "(EDOM) the timer uses %s, not the default clock source. No iteration.\n", msutimer_clock_name(timer->source) );
+		return loop;
+	}
+	loop.samples = acquire_samples_( timer, nrepeats );
+	if ( !loop.samples ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "Sample buffer allocation failed! No iteration." );
+		return loop;
+	}
+
+	loop.timer = timer;
+	loop.stats = stats;
+	loop.nwarmup = timer->warmup_iters;
+	loop.n = nrepeats;
+	timer->nwarmup = loop.nwarmup;
+	timer->steady = false;
+	cpu_wall_begin_( loop.cpuwall );
+	return loop;
+}
+
+// ----------------------------------------
+// void msutimer_loop_end_( MSUTimerLoop *loop );
+/**
+ * Finishes a MSUT_BENCH_LOOP() (internal): converts its samples from ticks,
+ * and computes their statistics, along with the wall-clock and CPU time of
+ * the whole loop (as msutimer_bench_stats() does, but including the warm-up
+ * iterations).
+ */
+void msutimer_loop_end_( MSUTimerLoop *loop )
+{
+	if ( !loop->timer ) {
+		return;		// msutimer_loop_begin_() failed
+	}
+	cpu_wall_end_( loop->cpuwall, loop->stats );
+
+	Welford_ w;
+	welford_reset_( &w );
+	for (size_t i=0; i < loop->n; i++) {
+		loop->samples[i] = sample_to_usecs_( loop->timer, (MSUTimerTime)loop->samples[i] );
+		welford_add_( &w, loop->samples[i] );
+	}
+	finish_stats_( loop->stats, &w, loop->samples );
+	loop->stats->nwarmup = loop->nwarmup;
+	loop->stats->env = loop->timer->env;
+
+	release_samples_( loop->timer, loop->samples );
+	loop->samples = NULL;
+	loop->timer = NULL;
+}
+
+/* ----------------------------------
+ * A/B Comparison
+ * ----------------------------------
+ */
+
+// ----------------------------------------
+// xorshift64* pseudo-random numbers (state must be non-zero)
+//
+static inline uint64_t xorshift64s_( uint64_t *state )
+{
+	uint64_t x = *state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return x * UINT64_C(2685821657736338717);
+}
+
+// ----------------------------------------
+// Two-sided p-value of the Mann-Whitney U test of a[] vs b[] (n values each),
+// with the normal approximation and the correction for ties. The values of
+// both arrays are copied into tmp[] (2*n of them) and sorted there.
+//
+typedef struct MSUTimerRanked_ {
+	double value;
+	int group;		// 0: a, 1: b
+} MSUTimerRanked_;
+
+static int compare_ranked_for_qsort_( const void *a, const void *b )
+{
+	double x = ((const MSUTimerRanked_ *)a)->value;
+	double y = ((const MSUTimerRanked_ *)b)->value;
+	return (x > y) - (x < y);
+}
+
+static double mann_whitney_p_( const double *a, const double *b, size_t n, MSUTimerRanked_ *tmp )
+{
+	size_t N = 2 * n;
+	for (size_t i=0; i < n; i++) {
+		tmp[i].value = a[i];
+		tmp[i].group = 0;
+		tmp[n+i].value = b[i];
+		tmp[n+i].group = 1;
+	}
+	qsort( tmp, N, sizeof(*tmp), compare_ranked_for_qsort_ );
+
+	// sum of the ranks of a[] (tied values get their average rank)
+	double ranksum = 0.0, ties = 0.0;
+	for (size_t i=0; i < N; ) {
+		size_t j = i + 1;
+		while ( j < N && tmp[j].value == tmp[i].value ) {
+			j++;
+		}
+		double rank = 0.5 * (double)(i + 1 + j);		// average of ranks i+1 .. j
+		double t = (double)(j - i);
+		ties += t * t * t - t;
+		for (size_t k=i; k < j; k++) {
+			if ( 0 == tmp[k].group ) {
+				ranksum += rank;
+			}
+		}
+		i = j;
+	}
+
+	double nn = (double)n;
+	double u = ranksum - nn * (nn + 1.0) / 2.0;
+	double var = nn * nn / 12.0 * ((double)N + 1.0 - ties / ((double)N * ((double)N - 1.0)));
+	if ( !(var > 0.0) ) {
+		return 1.0;		// all values equal
+	}
+	double z = fabs( u - nn * nn / 2.0 ) / sqrt( var );
+	return erfc( z / sqrt(2.0) );
+}
+
+// ----------------------------------------
+// bool msutimer_bench_compare( MSUTimer *timer, size_t nrounds, size_t nrepeats, bool (*callback_a)(void *), void *userdata_a, bool (*callback_b)(void *), void *userdata_b, MSUTimerCompare *result );
+/**
+ * Compares the execution times of 2 callback-functions (A and B), e.g. before
+ * and after a code change, telling whether the difference is significant.
+ *
+ * Each of `nrounds` rounds measures the median time of `nrepeats` calls of each
+ * callback-function (as msutimer_bench_median() does), in a random order (A
+ * first, or B first). Interleaving the 2 in short rounds makes slow drifts of
+ * the machine (CPU frequency, temperature, background load) affect both alike,
+ * and randomizing the order removes the bias of always running first or
+ * second.
+ *
+ * The speedup of B over A is the ratio of the medians of their per-round
+ * medians. Its 95% confidence interval is estimated by resampling the rounds
+ * (`MSUT_BOOTSTRAP_RESAMPLES` times, 2000 by default), and the Mann-Whitney U
+ * test tells how likely the 2 sets of per-round medians are to come from the
+ * same distribution.
+ *
+ * @param timer
+ *		An already created timer.
+ * @param nrounds
+ *		The number of rounds (at least 2; 20 or more give useful intervals).
+ * @param nrepeats
+ *		The number of calls of each callback-function per round.
+ * @param callback_a
+ *		The first callback-function (the baseline), see msutimer_bench().
+ * @param userdata_a
+ *		Caller-defined data for callback_a.
+ * @param callback_b
+ *		The second callback-function (the candidate), see msutimer_bench().
+ * @param userdata_b
+ *		Caller-defined data for callback_b.
+ * @param result
+ *		It passes back to the caller the results of the comparison (see
+ *		::MSUTimerCompare).
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		B is significantly faster when `ci_low` is above 1.0 (and significantly
+ *		slower when `ci_high` is below 1.0), or when `p_value` is small (e.g.
+ *		below 0.05) with a speedup above 1.0.
+ *
+ *		The warm-up configured with msutimer_set_warmup() is applied to both
+ *		callback-functions before the first round.
+ * @par Failures:
+ * 		- timer, callback_a, callback_b or result is `NULL` (`errno` is set to `EDOM`)
+ * 		- nrounds is less than 2, or nrepeats is 0 (`errno` is set to `EDOM`)
+ * 		- memory allocation failure (`errno` is set by the C runtime)
+ * 		- a callback returns `false` (its `failed` and `failed_which` members
+ * 		  are set, and the rest are computed from the completed rounds, if 2 or
+ * 		  more)
+ * @sa
+ *		msutimer_bench_median(), [Benchmarking](@ref msut_bench)
+ */
+bool msutimer_bench_compare( MSUTimer *timer, size_t nrounds, size_t nrepeats, bool (*callback_a)(void *), void *userdata_a, bool (*callback_b)(void *), void *userdata_b, MSUTimerCompare *result )
+{
+	errno = 0;
+
+	if ( !timer || !callback_a || !callback_b || !result ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer, callback_a, callback_b or result is NULL). Return: false" );
+		return false;
+	}
+	if ( nrounds < 2 || 0 == nrepeats ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (nrounds < 2 or nrepeats=0). Return: false" );
+		return false;
+	}
+	memset( result, 0, sizeof(*result) );
+
+	// per-round medians of A & B, their bootstrap copies, and the bootstrap ratios
+	double *meds = malloc( (4 * nrounds + MSUT_BOOTSTRAP_RESAMPLES) * sizeof(double) );
+	MSUTimerRanked_ *ranked = malloc( 2 * nrounds * sizeof(MSUTimerRanked_) );
+	double *rectimes = acquire_samples_( timer, nrepeats );
+	if ( !meds || !ranked || !rectimes ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "allocation failed! Return: false" );
+		free( meds );
+		free( ranked );
+		if ( rectimes ) {
+			release_samples_( timer, rectimes );
+		}
+		return false;
+	}
+	double *meds_a = meds, *meds_b = meds + nrounds;
+	double *boot_a = meds + 2 * nrounds, *boot_b = meds + 3 * nrounds;
+	double *ratios = meds + 4 * nrounds;
+
+	MSUTimerTime seed = 0;
+	get_msuttime_( timer->source, &seed );
+	uint64_t rng = (uint64_t)seed ^ UINT64_C(0x9E3779B97F4A7C15);
+	if ( 0 == rng ) {
+		rng = 1;
+	}
+
+	if ( !warmup_(timer, callback_a, userdata_a) ) {
+		result->failed = true;
+		result->failed_which = 1;
+		goto done;
+	}
+	if ( !warmup_(timer, callback_b, userdata_b) ) {
+		result->failed = true;
+		result->failed_which = 2;
+		goto done;
+	}
+
+	// the rounds
+	size_t n = 0;
+	for (; n < nrounds; n++) {
+		bool b_first = xorshift64s_( &rng ) >> 63;
+		for (int k=0; k < 2; k++) {
+			bool is_b = (0 == k) == b_first;
+			double m = record_median_(
+				timer,
+				nrepeats,
+				is_b ? callback_b : callback_a,
+				is_b ? userdata_b : userdata_a,
+				NULL,
+				rectimes
+				);
+			if ( m < 0.0 || (0.0 == m && signbit(m)) ) {
+				result->failed = true;
+				result->failed_which = is_b ? 2 : 1;
+				break;
+			}
+			(is_b ? meds_b : meds_a)[n] = m;
+		}
+		if ( result->failed ) {
+			MSUT_DBGMSG( "WARNING", "Callback %c FAILED at round %zu.\n", 2 == result->failed_which ? 'B' : 'A', n+1 );
+			break;
+		}
+	}
+	result->nrounds = n;
+	if ( n < 2 ) {
+		goto done;
+	}
+
+	// the speedup (medians are selected in-place, so select from copies)
+	memcpy( boot_a, meds_a, n * sizeof(double) );
+	memcpy( boot_b, meds_b, n * sizeof(double) );
+	result->median_a = median_of_doubles_( boot_a, n );
+	result->median_b = median_of_doubles_( boot_b, n );
+	result->speedup = result->median_b > 0.0 ? result->median_a / result->median_b : 0.0;
+	result->p_value = mann_whitney_p_( meds_a, meds_b, n, ranked );
+
+	// its bootstrap confidence interval: resample the rounds (as pairs)
+	for (size_t r=0; r < MSUT_BOOTSTRAP_RESAMPLES; r++) {
+		for (size_t i=0; i < n; i++) {
+			size_t j = (size_t)(xorshift64s_( &rng ) % n);
+			boot_a[i] = meds_a[j];
+			boot_b[i] = meds_b[j];
+		}
+		double mb = median_of_doubles_( boot_b, n );
+		ratios[r] = mb > 0.0 ? median_of_doubles_( boot_a, n ) / mb : 0.0;
+	}
+	size_t lo = 0;
+	result->ci_low = select_from_( ratios, MSUT_BOOTSTRAP_RESAMPLES, &lo, percentile_rank_(MSUT_BOOTSTRAP_RESAMPLES, 2.5) );
+	result->ci_high = select_from_( ratios, MSUT_BOOTSTRAP_RESAMPLES, &lo, percentile_rank_(MSUT_BOOTSTRAP_RESAMPLES, 97.5) );
+
+done:
+	release_samples_( timer, rectimes );
+	free( ranked );
+	free( meds );
+	return !result->failed;
+}
+
+/* ----------------------------------
+ * Bench Environment
+ * ----------------------------------
+ */
+
+// ----------------------------------------
+// Read the first line of a (sysfs) text file into buf, without its newline.
+// Return false if it cannot be read.
+//
+static bool read_line_( const char *fname, char *buf, size_t bufsize )
+{
+	FILE *fp = fopen( fname, "r" );
+	if ( !fp ) {
+		return false;
+	}
+	bool ret = NULL != fgets( buf, (int)bufsize, fp );
+	fclose( fp );
+	if ( ret ) {
+		buf[ strcspn(buf, "\r\n") ] = '\0';
+	}
+	return ret;
+}
+
+// ----------------------------------------
+// Detect the frequency governor of a CPU, and whether turbo boost is on (Linux)
+//
+static void check_cpufreq_( int cpu, MSUTimerEnv *env )
+{
+	env->governor[0] = '\0';
+	env->turbo = -1;
+#if defined(__linux__)
+	char fname[128], buf[32];
+	snprintf( fname, sizeof(fname), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", cpu < 0 ? 0 : cpu );
+	read_line_( fname, env->governor, sizeof(env->governor) );
+
+	if ( read_line_("/sys/devices/system/cpu/intel_pstate/no_turbo", buf, sizeof(buf)) ) {
+		env->turbo = ('0' == buf[0]);
+	}
+	else if ( read_line_("/sys/devices/system/cpu/cpufreq/boost", buf, sizeof(buf)) ) {
+		env->turbo = ('1' == buf[0]);
+	}
+#else
+	(void)cpu;
+#endif
+}
+
+// ----------------------------------------
+// bool msutimer_env_setup( MSUTimer *timer, int cpu, unsigned flags );
+/**
+ * Sets up the calling thread for quieter benchmarks, and records the
+ * conditions of the benchmark environment into its timer argument.
+ *
+ * Depending on `flags`, it pins the thread to a CPU (so that the scheduler
+ * does not migrate it between cores with cold caches, or with different
+ * frequencies) and raises its priority (so that it is preempted less).
+ * Then it checks the CPU frequency governor and turbo boost: a governor other
+ * than "performance" and turbo boost both make the CPU frequency, and so the
+ * measured times, depend on the load and the temperature.
+ *
+ * The recorded conditions are reported by msutimer_env(), and in the `env`
+ * member of ::MSUTimerStats, so that the results of different runs can be
+ * told apart.
+ *
+ * @param timer
+ *		The timer to be modified (it should then be used by the calling thread).
+ * @param cpu
+ *		The CPU to pin the thread to (with `MSUT_ENV_PIN`).
+ * @param flags
+ *		A combination of `MSUT_ENV_PIN` (pin the thread to `cpu`),
+ *		`MSUT_ENV_PRIORITY` (raise the thread priority) and `MSUT_ENV_WARN`
+ *		(print a warning to `stderr` for each noisy condition), or 0 to only
+ *		record the conditions.
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		Raising the priority needs privileges on most systems (e.g. root or
+ *		`CAP_SYS_NICE` on Linux, to a nice value of `MSUT_ENV_NICE`, -10 by
+ *		default). When it fails, it is not an error: the `priority` member of
+ *		the recorded conditions tells. Pinning is supported on Linux and
+ *		Windows; the frequency checks on Linux only (elsewhere they are reported
+ *		as unknown).
+ *
+ *		Calling it again keeps the changes of the earlier calls: with
+ *		`MSUT_ENV_PIN`, it only re-pins the thread. msutimer_env_restore() undoes
+ *		all of them, back to the thread as it was before the first call.
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- `MSUT_ENV_PIN` is specified, and the thread cannot be pinned to `cpu`
+ * 		  (`errno` is set to `EINVAL`, or by the OS). Nothing is changed then.
+ * @sa
+ *		msutimer_env_restore(), msutimer_env()
+ */
+bool msutimer_env_setup( MSUTimer *timer, int cpu, unsigned flags )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: false" );
+		return false;
+	}
+
+	// what is left of an earlier call (until msutimer_env_restore())
+	MSUTimerEnvSaved_ *saved = &timer->envsaved;
+	MSUTimerEnv env;
+	memset( &env, 0, sizeof(env) );
+	env.active = true;
+	env.cpu = saved->affinity ? timer->env.cpu : -1;
+	env.priority = saved->priority;
+
+	if ( flags & MSUT_ENV_PIN ) {
+		// save the affinity only when first pinning (when re-pinning, the one to
+		// restore is still the saved one, not our own pinning), and only once
+		// pinned: the thread and the timer are left untouched on failure
+#if MSUT_OS_WINDOWS
+		bool pinned = false;
+		if ( cpu >= 0 && (size_t)cpu < 8 * sizeof(DWORD_PTR) ) {
+			DWORD_PTR old = SetThreadAffinityMask( GetCurrentThread(), (DWORD_PTR)1 << cpu );
+			pinned = 0 != old;
+			if ( pinned && !saved->affinity ) {
+				saved->mask = old;
+			}
+		}
+#elif MSUT_OS_POSIX && defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO( &set );
+		bool pinned = cpu >= 0 && cpu < CPU_SETSIZE
+			&& (saved->affinity || 0 == sched_getaffinity( 0, sizeof(set), &set ))
+			&& pin_thread_( (size_t)cpu );
+		if ( pinned && !saved->affinity ) {
+			saved->set = set;
+		}
+#else
+		bool pinned = false;
+#endif
+		if ( !pinned ) {
+			if ( 0 == errno ) {
+				errno = EINVAL;
+			}
+			MSUT_DBGMSG( "ERROR", "cannot pin the thread to CPU %d. Return: false\n", cpu );
+			return false;
+		}
+		saved->affinity = true;
+		env.cpu = cpu;
+	}
+
+	if ( flags & MSUT_ENV_PRIORITY ) {
+		int err = errno;
+#if MSUT_OS_WINDOWS
+		int prio = GetThreadPriority( GetCurrentThread() );
+		if ( SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST) ) {
+			if ( !saved->priority ) {
+				saved->winprio = prio;
+				saved->priority = true;
+			}
+			env.priority = true;
+		}
+#elif MSUT_OS_POSIX
+		errno = 0;
+		int nice = getpriority( PRIO_PROCESS, 0 );	// the calling thread, on Linux
+		if ( 0 == errno && (nice <= MSUT_ENV_NICE || 0 == setpriority(PRIO_PROCESS, 0, MSUT_ENV_NICE)) ) {
+			if ( !saved->priority ) {
+				saved->nice = nice;
+				saved->priority = true;
+			}
+			env.priority = true;
+		}
+#endif
+		if ( !env.priority ) {
+			MSUT_DBGMSG( "WARNING", "%s\n", "cannot raise the thread priority." );
+			if ( flags & MSUT_ENV_WARN ) {
+				fprintf( stderr, "*** MSUTimer: cannot raise the thread priority (insufficient privileges?).\n" );
+			}
+		}
+		errno = err;
+	}
+
+	int curcpu = env.cpu;
+#if defined(__linux__)
+	if ( curcpu < 0 ) {
+		curcpu = sched_getcpu();
+	}
+#endif
+	check_cpufreq_( curcpu, &env );
+
+	env.noisy = env.cpu < 0
+		|| 1 == env.turbo
+		|| ('\0' != env.governor[0] && 0 != strcmp(env.governor, "performance"));
+
+	if ( flags & MSUT_ENV_WARN ) {
+		if ( env.cpu < 0 ) {
+			fprintf( stderr, "*** MSUTimer: the thread is not pinned to a CPU.\n" );
+		}
+		if ( '\0' != env.governor[0] && 0 != strcmp(env.governor, "performance") ) {
+			fprintf( stderr, "*** MSUTimer: the CPU frequency governor is \"%s\", not \"performance\".\n", env.governor );
+		}
+		if ( 1 == env.turbo ) {
+			fprintf( stderr, "*** MSUTimer: turbo boost is enabled.\n" );
+		}
+	}
+
+	timer->env = env;
+	return true;
+}
+
+// ----------------------------------------
+// bool msutimer_env_restore( MSUTimer *timer );
+/**
+ * Restores the CPU affinity and the priority of the calling thread, as they
+ * were before msutimer_env_setup() changed them, and clears the conditions
+ * recorded into its timer argument.
+ *
+ * @param timer
+ *		The timer to be modified.
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		It must be called from the thread that called msutimer_env_setup().
+ * @par Failures:
+ * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- the affinity or the priority cannot be restored (`errno` is set by the OS)
+ * @sa
+ *		msutimer_env_setup()
+ */
+bool msutimer_env_restore( MSUTimer *timer )
+{
+	errno = 0;
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: false" );
+		return false;
+	}
+
+	bool ret = true;
+	MSUTimerEnvSaved_ *saved = &timer->envsaved;
+	if ( saved->affinity ) {
+#if MSUT_OS_WINDOWS
+		ret = 0 != SetThreadAffinityMask( GetCurrentThread(), saved->mask ) && ret;
+#elif MSUT_OS_POSIX && defined(__linux__)
+		ret = 0 == sched_setaffinity( 0, sizeof(saved->set), &saved->set ) && ret;
+#endif
+		saved->affinity = false;
+	}
+	if ( saved->priority ) {
+#if MSUT_OS_WINDOWS
+		ret = SetThreadPriority( GetCurrentThread(), saved->winprio ) && ret;
+#elif MSUT_OS_POSIX
+		ret = 0 == setpriority( PRIO_PROCESS, 0, saved->nice ) && ret;
+#endif
+		saved->priority = false;
+	}
+	if ( !ret ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "cannot restore the thread's affinity or priority. Return: false" );
+	}
+
+	memset( &timer->env, 0, sizeof(timer->env) );
+	return ret;
+}
+
+// ----------------------------------------
+// bool msutimer_env( const MSUTimer *timer, MSUTimerEnv *env );
+/**
+ * Queries its timer argument for the conditions of the benchmark environment,
+ * as recorded by msutimer_env_setup().
+ *
+ * @param timer
+ *		The timer to be queried.
+ * @param env
+ *		It passes back to the caller the conditions. Its `active` member is
+ *		`false` if msutimer_env_setup() was not called.
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- timer or env is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_env_setup()
+ */
+bool msutimer_env( const MSUTimer *timer, MSUTimerEnv *env )
+{
+	errno = 0;
+	if ( !timer || !env ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL or env=NULL). Return: false" );
+		return false;
+	}
+	*env = timer->env;
+	return true;
+}
+
+/* ----------------------------------
+ * Result Serialization
+ * ----------------------------------
+ */
+
+#define MSUT_STATS_SCHEMA_	"msutimer-stats/3"
+
+// ----------------------------------------
+// Output of the serializers: either a caller-supplied buffer (snprintf-like,
+// counting the characters that would be written), or a stream
+//
+typedef struct MSUTimerOut_ {
+	char *buf;
+	size_t size;
+	FILE *fp;
+	size_t len;		// characters written (or that would be written)
+	bool failed;
+} MSUTimerOut_;
+
+static void out_printf_( MSUTimerOut_ *out, const char *fmt, ... )
+{
+	va_list ap;
+	int n;
+
+	va_start( ap, fmt );
+	if ( out->fp ) {
+		n = vfprintf( out->fp, fmt, ap );
+	}
+	else {
+		size_t off = out->len < out->size ? out->len : out->size;
+		n = vsnprintf( out->buf ? out->buf + off : NULL, out->size - off, fmt, ap );
+	}
+	va_end( ap );
+
+	if ( n < 0 ) {
+		out->failed = true;
+	}
+	else {
+		out->len += (size_t)n;
+	}
+}
+
+// a number, or null if it is not finite (JSON has no NaN nor infinity)
+static void out_json_double_( MSUTimerOut_ *out, const char *key, double v, bool last )
+{
+	if ( isfinite(v) ) {
+		out_printf_( out, "\"%s\":%.9g%s", key, v, last ? "" : "," );
+	}
+	else {
+		out_printf_( out, "\"%s\":null%s", key, last ? "" : "," );
+	}
+}
+
+static void out_json_string_( MSUTimerOut_ *out, const char *str )
+{
+	out_printf_( out, "\"" );
+	for (const unsigned char *c = (const unsigned char *)str; *c; c++) {
+		if ( '"' == *c || '\\' == *c ) {
+			out_printf_( out, "\\%c", *c );
+		}
+		else if ( *c < 0x20 ) {
+			out_printf_( out, "\\u%04x", *c );
+		}
+		else {
+			out_printf_( out, "%c", *c );
+		}
+	}
+	out_printf_( out, "\"" );
+}
+
+// a CSV field, quoted (and with its quotes doubled) if needed
+static void out_csv_string_( MSUTimerOut_ *out, const char *str )
+{
+	if ( '\0' == str[ strcspn(str, ",\"\r\n") ] ) {
+		out_printf_( out, "%s", str );
+		return;
+	}
+	out_printf_( out, "\"" );
+	for (const char *c = str; *c; c++) {
+		out_printf_( out, '"' == *c ? "\"\"" : "%c", *c );
+	}
+	out_printf_( out, "\"" );
+}
+
+static void write_json_( MSUTimerOut_ *out, const char *name, const MSUTimer *timer, const MSUTimerStats *stats )
+{
+	out_printf_( out, "{\"schema\":\"%s\",\"name\":", MSUT_STATS_SCHEMA_ );
+	out_json_string_( out, name );
+	out_printf_( out, ",\"clock\":\"%s\",", msutimer_clock_name(timer->source) );
+	out_json_double_( out, "resolution_usecs", timer->resolution_usecs, false );
+	out_printf_( out, "\"iterations\":%zu,\"failed\":%s,\"erepeat\":%zu,\"warmup\":%zu,\"steady\":%s,",
+		stats->nsamples, stats->failed ? "true" : "false", stats->erepeat,
+		stats->nwarmup, stats->steady ? "true" : "false" );
+
+	out_printf_( out, "\"usecs\":{" );
+	out_json_double_( out, "total", stats->total, false );
+	out_json_double_( out, "min", stats->min, false );
+	out_json_double_( out, "max", stats->max, false );
+	out_json_double_( out, "mean", stats->mean, false );
+	out_json_double_( out, "stddev", stats->stddev, false );
+	out_json_double_( out, "median", stats->median, false );
+	out_json_double_( out, "p90", stats->p90, false );
+	out_json_double_( out, "p99", stats->p99, false );
+	out_json_double_( out, "p999", stats->p999, false );
+	out_json_double_( out, "mad", stats->mad, true );
+	out_printf_( out, "}," );
+	if ( stats->cpu_valid ) {
+		out_json_double_( out, "wall_usecs", stats->wall_usecs, false );
+		out_json_double_( out, "cpu_usecs", stats->cpu_usecs, false );
+		out_json_double_( out, "cpu_ratio", stats->cpu_ratio, false );
+	}
+	else {
+		out_printf_( out, "\"wall_usecs\":null,\"cpu_usecs\":null,\"cpu_ratio\":null," );
+	}
+
+	const MSUTimerCounters *c = &stats->counters;
+	if ( c->valid ) {
+		out_printf_( out, "\"counters\":{" );
+		out_json_double_( out, "cycles", c->cycles, false );
+		out_json_double_( out, "instructions", c->instructions, false );
+		out_json_double_( out, "ipc", c->ipc, false );
+		out_json_double_( out, "cache_misses", c->cache_misses, false );
+		out_json_double_( out, "branch_misses", c->branch_misses, true );
+		out_printf_( out, "}," );
+	}
+	else {
+		out_printf_( out, "\"counters\":null," );
+	}
+
+	const MSUTimerAllocs *a = &stats->allocs;
+	if ( a->valid ) {
+		out_printf_( out, "\"allocs\":{" );
+		out_json_double_( out, "allocs", a->allocs, false );
+		out_json_double_( out, "frees", a->frees, false );
+		out_json_double_( out, "bytes", a->bytes, false );
+		out_json_double_( out, "peak_rss_delta", a->peak_rss_delta, true );
+		out_printf_( out, "}," );
+	}
+	else {
+		out_printf_( out, "\"allocs\":null," );
+	}
+
+	const MSUTimerEnv *e = &stats->env;
+	if ( e->active ) {
+		out_printf_( out, "\"env\":{\"cpu\":%d,\"priority\":%s,\"governor\":",
+			e->cpu, e->priority ? "true" : "false" );
+		if ( '\0' != e->governor[0] ) {
+			out_json_string_( out, e->governor );
+		}
+		else {
+			out_printf_( out, "null" );
+		}
+		out_printf_( out, ",\"turbo\":%s,\"noisy\":%s}}",
+			e->turbo < 0 ? "null" : (e->turbo ? "true" : "false"),
+			e->noisy ? "true" : "false" );
+	}
+	else {
+		out_printf_( out, "\"env\":null}" );
+	}
+}
+
+static void write_csv_( MSUTimerOut_ *out, const char *name, const MSUTimer *timer, const MSUTimerStats *stats, bool header )
+{
+	const MSUTimerCounters *c = &stats->counters;
+	const MSUTimerEnv *e = &stats->env;
+
+	if ( header ) {
+		out_printf_( out, "%s",
+			"schema,name,clock,resolution_usecs,iterations,failed,erepeat,warmup,steady,"
+			"total,min,max,mean,stddev,median,p90,p99,p999,mad,"
+			"cycles,instructions,ipc,cache_misses,branch_misses,"
+			"cpu,priority,governor,turbo,noisy,"
+			"wall_usecs,cpu_usecs,cpu_ratio,"
+			"allocs,frees,bytes,peak_rss_delta\n" );
+	}
+
+	out_printf_( out, "%s,", MSUT_STATS_SCHEMA_ );
+	out_csv_string_( out, name );
+	out_printf_( out, ",%s,%.9g,%zu,%d,%zu,%zu,%d,",
+		msutimer_clock_name(timer->source), timer->resolution_usecs,
+		stats->nsamples, stats->failed, stats->erepeat, stats->nwarmup, stats->steady );
+	out_printf_( out, "%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,",
+		stats->total, stats->min, stats->max, stats->mean, stats->stddev,
+		stats->median, stats->p90, stats->p99, stats->p999, stats->mad );
+	if ( c->valid ) {
+		out_printf_( out, "%.9g,%.9g,%.9g,%.9g,%.9g,",
+			c->cycles, c->instructions, c->ipc, c->cache_misses, c->branch_misses );
+	}
+	else {
+		out_printf_( out, ",,,,," );
+	}
+	if ( e->active ) {
+		out_printf_( out, "%d,%d,", e->cpu, e->priority );
+		out_csv_string_( out, e->governor );
+		if ( e->turbo < 0 ) {
+			out_printf_( out, ",,%d,", e->noisy );
+		}
+		else {
+			out_printf_( out, ",%d,%d,", e->turbo, e->noisy );
+		}
+	}
+	else {
+		out_printf_( out, ",,,,," );
+	}
+	if ( stats->cpu_valid ) {
+		out_printf_( out, "%.9g,%.9g,%.9g,", stats->wall_usecs, stats->cpu_usecs, stats->cpu_ratio );
+	}
+	else {
+		out_printf_( out, ",,," );
+	}
+	const MSUTimerAllocs *a = &stats->allocs;
+	if ( a->valid ) {
+		out_printf_( out, "%.9g,%.9g,%.9g,%.9g\n", a->allocs, a->frees, a->bytes, a->peak_rss_delta );
+	}
+	else {
+		out_printf_( out, ",,,\n" );
+	}
+}
+
+// ----------------------------------------
+// int msutimer_stats_to_json( char *buf, size_t bufsize, const char *name, const MSUTimer *timer, const MSUTimerStats *stats );
+/**
+ * Serializes the statistics of a benchmark run as a JSON object, into a
+ * caller-supplied buffer (like `snprintf()` does).
+ *
+ * The object follows the stable schema "msutimer-stats/3" (its `schema`
+ * member), e.g.:
+ * @code
+	{"schema":"msutimer-stats/3","name":"parse","clock":"monotonic","resolution_usecs":0.029,
+	 "iterations":1000,"failed":false,"erepeat":0,"warmup":0,"steady":false,
+	 "usecs":{"total":...,"min":...,"max":...,"mean":...,"stddev":...,
+	          "median":...,"p90":...,"p99":...,"p999":...,"mad":...},
+	 "wall_usecs":...,"cpu_usecs":...,"cpu_ratio":...,
+	 "counters":null,"allocs":null,
+	 "env":{"cpu":2,"priority":true,"governor":"performance","turbo":false,"noisy":false}}
+ * @endcode
+ * (on a single line, with no newline at the end). `counters` are those of
+ * msutimer_perf_enable(), `allocs` those of msutimer_alloc_enable(), and `env`
+ * those of msutimer_env_setup(); each one is `null` if it was not enabled.
+ * `wall_usecs`, `cpu_usecs` and `cpu_ratio` are `null` if they were not
+ * measured (e.g. for stats of a histogram, see `cpu_valid` of MSUTimerStats).
+ * Unknown `governor` and `turbo` are `null`, as are non-finite numbers. Later
+ * versions of the schema may add members, but never rename or remove them.
+ *
+ * @param buf
+ *		The buffer to be written. It may be `NULL` if bufsize is 0, to get the
+ *		required size.
+ * @param bufsize
+ *		The size of the buffer, in bytes.
+ * @param name
+ *		The name of the benchmark.
+ * @param timer
+ *		The timer of the run: its clock source and resolution (see
+ *		msutimer_accuracy_usecs()) are included.
+ * @param stats
+ *		The statistics to be serialized (e.g. from msutimer_bench_stats(), or
+ *		from MSUT_BENCH_LOOP()).
+ * @return
+ *		The number of characters of the object (not counting the terminating
+ *		`'\0'`), or -1 on error. If it is not less than bufsize, the output was
+ *		truncated (but it is always `'\0'` terminated, if bufsize is not 0).
+ * @remarks
+ *		It allocates no memory, and it does not read the clock: the resolution
+ *		is measured once per clock source, by the first timer created on it.
+ * @par Failures:
+ * 		- name, timer or stats is `NULL`, or buf is `NULL` with a non-zero
+ * 		  bufsize (`errno` is set to `EDOM`)
+ * 		- a formatting error (`errno` is set by the C runtime)
+ * @sa
+ *		msutimer_stats_write_json(), msutimer_stats_to_csv()
+ */
+int msutimer_stats_to_json( char *buf, size_t bufsize, const char *name, const MSUTimer *timer, const MSUTimerStats *stats )
+{
+	errno = 0;
+	if ( !name || !timer || !stats || (!buf && bufsize) ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (name, timer, stats or buf is NULL). Return: -1" );
+		return -1;
+	}
+
+	MSUTimerOut_ out = { buf, bufsize, NULL, 0, false };
+	if ( bufsize ) {
+		buf[0] = '\0';
+	}
+	write_json_( &out, name, timer, stats );
+	if ( out.failed || out.len > INT_MAX ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "formatting failed. Return: -1" );
+		return -1;
+	}
+	errno = 0;
+	return (int)out.len;
+}
+
+// ----------------------------------------
+// bool msutimer_stats_write_json( FILE *fp, const char *name, const MSUTimer *timer, const MSUTimerStats *stats );
+/**
+ * Writes the statistics of a benchmark run to a stream, as a single line of
+ * JSON (see msutimer_stats_to_json()), followed by a newline.
+ *
+ * A file of such lines (JSON Lines) is easy to append to and to parse.
+ *
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- fp, name, timer or stats is `NULL` (`errno` is set to `EDOM`)
+ * 		- a write error (`errno` is set by the C runtime)
+ * @sa
+ *		msutimer_stats_to_json(), msutimer_stats_write_csv()
+ */
+bool msutimer_stats_write_json( FILE *fp, const char *name, const MSUTimer *timer, const MSUTimerStats *stats )
+{
+	errno = 0;
+	if ( !fp || !name || !timer || !stats ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (fp, name, timer or stats is NULL). Return: false" );
+		return false;
+	}
+
+	MSUTimerOut_ out = { NULL, 0, fp, 0, false };
+	write_json_( &out, name, timer, stats );
+	out_printf_( &out, "\n" );
+	if ( out.failed ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "write failed. Return: false" );
+		return false;
+	}
+	errno = 0;
+	return true;
+}
+
+// ----------------------------------------
+// int msutimer_stats_to_csv( char *buf, size_t bufsize, const char *name, const MSUTimer *timer, const MSUTimerStats *stats, bool header );
+/**
+ * Serializes the statistics of a benchmark run as a CSV record, into a
+ * caller-supplied buffer (like `snprintf()` does).
+ *
+ * The record is a single line (ending in a newline), with the columns of the
+ * schema "msutimer-stats/3" (see msutimer_stats_to_json()), in this order:
+ * @code
+	schema,name,clock,resolution_usecs,iterations,failed,erepeat,warmup,steady,
+	total,min,max,mean,stddev,median,p90,p99,p999,mad,
+	cycles,instructions,ipc,cache_misses,branch_misses,
+	cpu,priority,governor,turbo,noisy,
+	wall_usecs,cpu_usecs,cpu_ratio,
+	allocs,frees,bytes,peak_rss_delta
+ * @endcode
+ * Booleans are 0 or 1, and the fields of disabled, unmeasured or unknown data
+ * are empty.
+ * Later versions of the schema may append columns, but never reorder or
+ * remove them.
+ *
+ * @param header
+ *		If `true`, the record is preceded by a line with the column names.
+ * @return
+ *		The number of characters written (not counting the terminating `'\0'`),
+ *		or -1 on error. If it is not less than bufsize, the output was truncated.
+ * @remarks
+ *		For the rest of the parameters, and the failures, see
+ *		msutimer_stats_to_json().
+ * @sa
+ *		msutimer_stats_write_csv(), msutimer_stats_to_json()
+ */
+int msutimer_stats_to_csv( char *buf, size_t bufsize, const char *name, const MSUTimer *timer, const MSUTimerStats *stats, bool header )
+{
+	errno = 0;
+	if ( !name || !timer || !stats || (!buf && bufsize) ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (name, timer, stats or buf is NULL). Return: -1" );
+		return -1;
+	}
+
+	MSUTimerOut_ out = { buf, bufsize, NULL, 0, false };
+	if ( bufsize ) {
+		buf[0] = '\0';
+	}
+	write_csv_( &out, name, timer, stats, header );
+	if ( out.failed || out.len > INT_MAX ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "formatting failed. Return: -1" );
+		return -1;
+	}
+	errno = 0;
+	return (int)out.len;
+}
+
+// ----------------------------------------
+// bool msutimer_stats_write_csv( FILE *fp, const char *name, const MSUTimer *timer, const MSUTimerStats *stats, bool header );
+/**
+ * Writes the statistics of a benchmark run to a stream, as a CSV record (see
+ * msutimer_stats_to_csv()), preceded by the column names if `header` is `true`.
+ *
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- fp, name, timer or stats is `NULL` (`errno` is set to `EDOM`)
+ * 		- a write error (`errno` is set by the C runtime)
+ * @sa
+ *		msutimer_stats_to_csv(), msutimer_stats_write_json()
+ */
+bool msutimer_stats_write_csv( FILE *fp, const char *name, const MSUTimer *timer, const MSUTimerStats *stats, bool header )
+{
+	errno = 0;
+	if ( !fp || !name || !timer || !stats ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (fp, name, timer or stats is NULL). Return: false" );
+		return false;
+	}
+
+	MSUTimerOut_ out = { NULL, 0, fp, 0, false };
+	write_csv_( &out, name, timer, stats, header );
+	if ( out.failed ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "write failed. Return: false" );
+		return false;
+	}
+	errno = 0;
+	return true;
+}
+
+/* ----------------------------------
+ * Input-Size Ranges & Complexity Fitting
+ * ----------------------------------
+ */
+
+// ----------------------------------------
+// The value of a complexity model at n (logarithms are base 2)
+//
+static double complexity_f_( MSUTimerComplexity c, double n )
+{
+	switch ( c ) {
+		case MSUT_O_LOGN:	return log2( n );
+		case MSUT_O_N:		return n;
+		case MSUT_O_NLOGN:	return n * log2( n );
+		case MSUT_O_N2:		return n * n;
+		default:			return 1.0;
+	}
+}
+
+// ----------------------------------------
+// Fit the n times (times[i], or stats[i].median if times is NULL) measured at
+// the non-zero sizes[i] to all the complexity models, keeping the best one
+//
+static void fit_models_( const size_t *sizes, const double *times, const MSUTimerStats *stats, size_t n, MSUTimerFit *fit )
+{
+	#define MSUT_TIME_AT_( i )	(times ? times[i] : stats[i].median)
+
+	memset( fit, 0, sizeof(*fit) );
+	fit->complexity = MSUT_NCOMPLEXITIES;
+
+	double mean = 0.0;
+	for (size_t i=0; i < n; i++) {
+		mean += MSUT_TIME_AT_( i );
+	}
+	mean /= (double)n;
+
+	double best = DBL_MAX;
+	for (int c = MSUT_O_1; c < MSUT_NCOMPLEXITIES; c++) {
+		double sumtf = 0.0, sumff = 0.0;
+		for (size_t i=0; i < n; i++) {
+			double f = complexity_f_( (MSUTimerComplexity)c, (double)sizes[i] );
+			sumtf += MSUT_TIME_AT_( i ) * f;
+			sumff += f * f;
+		}
+		double coef = sumff > 0.0 ? sumtf / sumff : 0.0;
+
+		double sse = 0.0;
+		for (size_t i=0; i < n; i++) {
+			double e = MSUT_TIME_AT_( i ) - coef * complexity_f_( (MSUTimerComplexity)c, (double)sizes[i] );
+			sse += e * e;
+		}
+		double rms = sqrt( sse / (double)n );
+		if ( mean > 0.0 ) {
+			rms /= mean;
+		}
+		fit->rms_all[c] = rms;
+		if ( rms < best ) {
+			best = rms;
+			fit->complexity = (MSUTimerComplexity)c;
+			fit->coef = coef;
+			fit->rms = rms;
+		}
+	}
+
+	#undef MSUT_TIME_AT_
+}
+
+// ----------------------------------------
+// const char *msutimer_complexity_name( MSUTimerComplexity complexity );
+/**
+ * Gets the name of a complexity model (e.g. "O(n log n)").
+ *
+ * @param complexity
+ *		The complexity model.
+ * @return
+ *		A pointer to a constant string (it is "none" for MSUT_NCOMPLEXITIES, and
+ *		"unknown" for invalid values).
+ */
+const char *msutimer_complexity_name( MSUTimerComplexity complexity )
+{
+	static const char *names[MSUT_NCOMPLEXITIES + 1] = {
+		[MSUT_O_1]				= "O(1)",
+		[MSUT_O_LOGN]			= "O(log n)",
+		[MSUT_O_N]				= "O(n)",
+		[MSUT_O_NLOGN]			= "O(n log n)",
+		[MSUT_O_N2]				= "O(n^2)",
+		[MSUT_NCOMPLEXITIES]	= "none"
+	};
+	if ( (unsigned)complexity > MSUT_NCOMPLEXITIES ) {
+		return "unknown";
+	}
+	return names[complexity];
+}
+
+// ----------------------------------------
+// bool msutimer_fit_complexity( const size_t *sizes, const double *times, size_t n, MSUTimerFit *fit );
+/**
+ * Fits times measured at several input sizes to the complexity models O(1),
+ * O(log n), O(n), O(n log n) and O(n^2), and reports the best-matching one.
+ *
+ * Each model `f` is fitted by least squares to `times[i] = coef * f(sizes[i])`,
+ * and the model with the smallest root-mean-square error (relative to the mean
+ * time) is the best match.
+ *
+ * @param sizes
+ *		The input sizes (all of them non-zero).
+ * @param times
+ *		The times measured at each size (e.g. their medians), in *microseconds*.
+ * @param n
+ *		The number of sizes (at least 2).
+ * @param fit
+ *		It passes back to the caller the best-matching model, its coefficient,
+ *		and the error of each model.
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		The fit is only as good as the range of sizes: a range spanning a few
+ *		orders of magnitude tells the models apart much better than a narrow
+ *		one. Constant costs (e.g. a fixed setup) are not modelled, so they bias
+ *		small sizes towards O(1) or O(log n).
+ * @par Failures:
+ * 		- sizes, times or fit is `NULL`, n is less than 2, or a size is 0
+ * 		  (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_bench_range(), msutimer_complexity_name()
+ */
+bool msutimer_fit_complexity( const size_t *sizes, const double *times, size_t n, MSUTimerFit *fit )
+{
+	errno = 0;
+	if ( !sizes || !times || !fit || n < 2 ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (sizes, times or fit is NULL, or n < 2). Return: false" );
+		return false;
+	}
+	for (size_t i=0; i < n; i++) {
+		if ( 0 == sizes[i] ) {
+			errno = EDOM;
+			MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (a size is 0). Return: false" );
+			return false;
+		}
+	}
+	fit_models_( sizes, times, NULL, n, fit );
+	return true;
+}
+
+// ----------------------------------------
+// Adapt a size-parameterized callback to the bench functions
+//
+typedef struct MSUTimerRangeArg_ {
+	bool (*callback)(void *, size_t);
+	void *userdata;
+	size_t size;
+} MSUTimerRangeArg_;
+
+static bool range_callback_( void *p )
+{
+	MSUTimerRangeArg_ *a = p;
+	return a->callback( a->userdata, a->size );
+}
+
+// ----------------------------------------
+// bool msutimer_bench_range( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *, size_t), void *userdata, size_t lo, size_t hi, double mult, size_t maxsizes, size_t *sizes, MSUTimerStats *stats, size_t *nsizes, MSUTimerFit *fit );
+/**
+ * Benchmarks a callback-function over a geometric range of input sizes, and
+ * fits the results to complexity models.
+ *
+ * The sizes are `lo`, `lo*mult`, `lo*mult^2`, ... up to `hi` (and `hi` itself
+ * is always the last one). For each size, the callback-function is called with
+ * it as its 2nd argument, and its statistics are recorded as
+ * msutimer_bench_stats() does. Then the medians are fitted to O(1), O(log n),
+ * O(n), O(n log n) and O(n^2) (see msutimer_fit_complexity()).
+ *
+ * @param timer
+ *		An already created timer.
+ * @param nrepeats
+ *		The number of iterations per size.
+ * @param callback
+ *		The callback-function to be measured. Its 1st argument is `userdata`,
+ *		and its 2nd one the input size of the call. It must return `false` on
+ *		error (see msutimer_bench()).
+ * @param userdata
+ *		A `void` pointer to caller-defined data, passed to the callback-function.
+ * @param lo
+ *		The first (smallest) size (at least 1).
+ * @param hi
+ *		The last (largest) size (at least lo).
+ * @param mult
+ *		The ratio of consecutive sizes (above 1.0, e.g. 2.0, or 10.0).
+ * @param maxsizes
+ *		The capacity of the sizes and stats arrays.
+ * @param sizes
+ *		An array of at least maxsizes elements, passing back the sizes of the
+ *		range.
+ * @param stats
+ *		An array of at least maxsizes elements, passing back the statistics of
+ *		each size.
+ * @param nsizes
+ *		If non-`NULL`, it passes back to the caller the number of sizes that
+ *		were benchmarked. The range is cut short if it has more than maxsizes
+ *		sizes.
+ * @param fit
+ *		If non-`NULL`, it passes back to the caller the best-matching
+ *		complexity (fitted if at least 2 sizes were benchmarked; otherwise its
+ *		`complexity` is MSUT_NCOMPLEXITIES).
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		It allocates only what msutimer_bench_stats() does, i.e. nothing if a
+ *		large enough sample buffer is reserved (see msutimer_reserve_samples()).
+ *		Preparing the input of each size (e.g. filling a container) must be
+ *		done outside of it: the callback-function can keep it in `userdata`,
+ *		rebuilding it whenever the size changes.
+ * @par Failures:
+ * 		- timer, callback, sizes or stats is `NULL` (`errno` is set to `EDOM`)
+ * 		- nrepeats or maxsizes is 0, lo is 0 or above hi, or mult is not above
+ * 		  1.0 (`errno` is set to `EDOM`)
+ * 		- memory allocation failure (`errno` is set by the C runtime)
+ * 		- the callback-function returns `false` (the range stops at that size;
+ * 		  its stats have their `failed` member set, and they are counted in
+ * 		  nsizes but not fitted)
+ * @sa
+ *		msutimer_bench_stats(), msutimer_fit_complexity(), [Benchmarking](@ref msut_bench)
+ */
+bool msutimer_bench_range( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *, size_t), void *userdata, size_t lo, size_t hi, double mult, size_t maxsizes, size_t *sizes, MSUTimerStats *stats, size_t *nsizes, MSUTimerFit *fit )
+{
+	errno = 0;
+	if ( nsizes ) {
+		*nsizes = 0;
+	}
+	if ( fit ) {
+		memset( fit, 0, sizeof(*fit) );
+		fit->complexity = MSUT_NCOMPLEXITIES;
+	}
+
+	if ( !timer || !callback || !sizes || !stats ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer, callback, sizes or stats is NULL). Return: false" );
+		return false;
+	}
+	if ( 0 == nrepeats || 0 == maxsizes || 0 == lo || lo > hi || !(mult > 1.0) ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (nrepeats, maxsizes, lo, hi or mult). Return: false" );
+		return false;
+	}
+
+	// the sizes of the range
+	size_t n = 0;
+	for (size_t sz = lo; n < maxsizes; ) {
+		sizes[n++] = sz;
+		if ( sz >= hi ) {
+			break;
+		}
+		double next = (double)sz * mult;
+		sz = (next >= (double)hi) ? hi : ((size_t)next > sz ? (size_t)next : sz + 1);
+	}
+	if ( n == maxsizes && sizes[n-1] < hi ) {
+		MSUT_DBGMSG( "WARNING", "the range is cut short at %zu sizes (hi=%zu not reached).\n", maxsizes, hi );
+	}
+
+	// benchmark them
+	MSUTimerRangeArg_ arg = { callback, userdata, 0 };
+	bool ret = true;
+	size_t done = 0;
+	for (; done < n; done++) {
+		arg.size = sizes[done];
+		if ( !msutimer_bench_stats(timer, nrepeats, range_callback_, &arg, &stats[done]) ) {
+			ret = false;
+			if ( stats[done].failed ) {
+				MSUT_DBGMSG( "WARNING", "Callback FAILED at size %zu.\n", sizes[done] );
+				done++;		// its stats are valid until the failure
+			}
+			break;
+		}
+	}
+	if ( nsizes ) {
+		*nsizes = done;
+	}
+
+	// fit the medians of the completed sizes
+	size_t nfit = ret ? done : (done > 0 && stats[done-1].failed ? done - 1 : done);
+	if ( fit && nfit >= 2 ) {
+		fit_models_( sizes, NULL, stats, nfit, fit );
+	}
+	return ret;
+}
+
+/* ----------------------------------
+ * Setup / Teardown & Pausing
+ * ----------------------------------
+ */
+
+// ----------------------------------------
+// void msutimer_pause( MSUTimer *timer );
+/**
+ * Pauses the timing of the current sample of a benchmark function, from
+ * inside its callback-function, until msutimer_resume() is called.
+ *
+ * The time between the 2 calls is excluded from the sample. Use them to leave
+ * out work that must be done on every call, but is not to be measured (e.g.
+ * checking, or logging the results).
+ *
+ * @param timer
+ *		The timer of the running benchmark function.
+ * @remarks
+ *		It works with all the benchmark functions that time each call (or batch
+ *		of calls) of their callback-function, i.e. all but msutimer_bench() and
+ *		msutimer_bench_parallel(). A pause that is not resumed lasts until the
+ *		end of the sample. Pausing twice, or resuming an unpaused timer, does
+ *		nothing. Each pause and resume reads the clock, so for tiny callbacks
+ *		prefer msutimer_bench_median_fixture().
+ *
+ *		Hardware performance counters (see msutimer_perf_enable()) are not
+ *		paused. Like the other raw tick functions, it does not touch `errno`,
+ *		and it does nothing if `timer` is `NULL`.
+ * @sa
+ *		msutimer_resume(), msutimer_bench_median_fixture()
+ */
+void msutimer_pause( MSUTimer *timer )
+{
+	if ( timer && !timer->paused ) {
+		timer->paused = true;
+		get_msuttime_( timer->source, &timer->pause_t1 );
+	}
+}
+
+// ----------------------------------------
+// void msutimer_resume( MSUTimer *timer );
+/**
+ * Resumes the timing of the current sample of a benchmark function, paused by
+ * msutimer_pause().
+ *
+ * @param timer
+ *		The timer of the running benchmark function.
+ * @sa
+ *		msutimer_pause()
+ */
+void msutimer_resume( MSUTimer *timer )
+{
+	if ( timer && timer->paused ) {
+		MSUTimerTime now = 0;
+		get_msuttime_( timer->source, &now );
+		timer->paused_ticks += now - timer->pause_t1;
+		timer->paused = false;
+	}
+}
+
+// ----------------------------------------
+// A setup / callback / teardown call for the warm-up, with the setup and the
+// teardown paused (for steady-state detection)
+//
+typedef struct MSUTimerFixture_ {
+	MSUTimer *timer;
+	bool (*setup)(void *);
+	bool (*callback)(void *);
+	bool (*teardown)(void *);
+	void *userdata;
+} MSUTimerFixture_;
+
+static bool fixture_callback_( void *p )
+{
+	MSUTimerFixture_ *f = p;
+	bool ret = true;
+
+	msutimer_pause( f->timer );
+	if ( f->setup ) {
+		ret = f->setup( f->userdata );
+	}
+	msutimer_resume( f->timer );
+	ret = ret && f->callback( f->userdata );
+	msutimer_pause( f->timer );
+	if ( f->teardown ) {
+		ret = f->teardown( f->userdata ) && ret;
+	}
+	msutimer_resume( f->timer );
+	return ret;
+}
+
+// ----------------------------------------
+// double msutimer_bench_median_fixture( MSUTimer *timer, size_t nrepeats, bool (*setup)(void *), bool (*callback)(void *), bool (*teardown)(void *), void *userdata, size_t *erepeat );
+/**
+ * Measures the median execution time of its callback-function argument, as
+ * msutimer_bench_median() does, calling a setup and a teardown function before
+ * and after each call, outside of the timed window.
+ *
+ * Use it for callback-functions that consume or modify their input (e.g.
+ * sorting, or in-place parsing), so that each call needs fresh data: the setup
+ * function prepares it, and the teardown function checks or releases it,
+ * without their cost being counted.
+ *
+ * @param timer
+ *		An already created timer.
+ * @param nrepeats
+ *		The number of iterations.
+ * @param setup
+ *		If non-`NULL`, it is called with `userdata` before each call of the
+ *		callback-function (untimed). It must return `false` on error.
+ * @param callback
+ *		The callback-function to be measured (see msutimer_bench()).
+ * @param teardown
+ *		If non-`NULL`, it is called with `userdata` after each call of the
+ *		callback-function (untimed). It must return `false` on error.
+ * @param userdata
+ *		A `void` pointer to caller-defined data, passed to all 3 functions.
+ * @param erepeat
+ *		If non-`NULL`, then in case of error (any of the 3 functions returns
+ *		`false`) it passes back to the caller the number of successful
+ *		iterations.
+ * @return
+ *		A `double` representing the median time (in *microseconds*) of a single
+ *		call of the callback-function.
+ *
+ *		If any of the 3 functions errors, then the returned value is **negative**,
+ *		reflecting the median of the completed iterations (-0.0 with `errno`
+ *		set to `ECANCELED` if none was completed, e.g. on a failure during the
+ *		warm-up). On all other errors, `errno` is set to `EDOM` and the function
+ *		returns 0.0
+ * @remarks
+ *		The warm-up (see msutimer_set_warmup()) also calls the setup and the
+ *		teardown functions. Inside the callback-function, msutimer_pause() and
+ *		msutimer_resume() can also be used.
+ * @par Failures:
+ * 		- timer is `NULL` (returns 0.0, `errno` is set to `EDOM`)
+ * 		- nrepeats is 0 (returns 0.0, `errno` is set to `EDOM`)
+ * 		- callback is `NULL` (returns 0.0, `errno` is set to `EDOM`)
+ * 		- memory allocation failure (returns 0.0, `errno` is set by the C runtime)
+ * 		- setup, callback or teardown returns `false` (see above)
+ * @sa
+ *		msutimer_bench_median(), msutimer_pause(), [Benchmarking](@ref msut_bench)
+ */
+double msutimer_bench_median_fixture( MSUTimer *timer, size_t nrepeats, bool (*setup)(void *), bool (*callback)(void *), bool (*teardown)(void *), void *userdata, size_t *erepeat )
+{
+	errno = 0;
+
+	if ( !timer ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( !callback ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: 0 secs." );
+		return 0.0;
+	}
+	if ( nrepeats == 0 ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nrepeats=0. Returned 0 secs." );
+		return 0.0;
+	}
+	if ( erepeat ) {
+		*erepeat = 0;
+	}
+
+	MSUTimerFixture_ fixture = { timer, setup, callback, teardown, userdata };
+	if ( !warmup_( timer, fixture_callback_, &fixture ) ) {
+		return failed_zero_();
+	}
+
+	double *rectimes = acquire_samples_( timer, nrepeats );
+	if ( !rectimes ) {
+		MSUT_DBGMSG( "ERROR", "%s\n", "Sample buffer allocation failed! Return: 0 secs." );
+		return 0.0;
+	}
+
+	double bias = 1.0;
+	size_t i;
+	MSUTimerTime t;
+	for (i=0; i < nrepeats; i++) {
+		bool ok = !setup || setup( userdata );
+		ok = ok && sample_ticks_( timer, callback, userdata, &t );
+		ok = ok && (!teardown || teardown( userdata ));
+		if ( !ok ) {
+			if ( erepeat ) {
+				*erepeat = i;
+			}
+			bias = -1.0;
+			MSUT_DBGMSG(
+				"WARNING",
+				"Requested iterations: %zu, but FAILED at %zu (erepeat).\n"
+				"==> Returned: median secs until then (with negative sign).\n",
+				nrepeats,
+				i+1
+				);
+			break;
+		}
+		rectimes[i] = sample_to_usecs_( timer, t );
+	}
+
+	double ret = bias * median_of_doubles_( rectimes, i );
+	release_samples_( timer, rectimes );
+	return ( 0.0 == ret && signbit(ret) ) ? failed_zero_() : ret;
+}
+
+/* ----------------------------------
+ * Timer Storage & Pools
+ * ----------------------------------
+ */
+
+// ----------------------------------------
+// MSUTimer *msutimer_init( void *storage, size_t size, MSUTimerClock source );
+/**
+ * Initializes and starts a timer in caller-provided storage, reading the
+ * specified clock source, without allocating any memory.
+ *
+ * The storage may be of static or automatic duration (e.g. a local variable
+ * of type ::MSUTimerStorage), and it must outlive the timer. Its resources
+ * should be released by the caller, with msutimer_fini() (or msutimer_free(),
+ * which then does the same, without de-allocating the storage).
  *
- * @param timer
- *		The timer to be updated.
+ * @param storage
+ *		The storage of the timer, aligned at least as a `uint64_t` and a pointer
+ *		(as ::MSUTimerStorage is).
+ * @param size
+ *		The size of the storage, in bytes; at least `MSUT_TIMER_SIZE`.
+ * @param source
+ *		The clock source to be used by the timer (see ::MSUTimerClock).
  * @return
- *		A `double`, representing the current time in *microseconds*. Useful for
- *		calculating manually the time-difference between 2 calls of the function.
+ *		The timer, placed in the storage, or `NULL` on error.
  * @remarks
- *		Typically, the piece of code to be timed is placed between 2 calls of
- *		this function. The very first time, the code may also be placed between
- *		msutimer_new() and this function, but then the manual calculation method
- *		cannot be used (moreover, the construction validation overhead is added
- *		to the result).
+ *		Initializing a timer costs a single clock read, since the frequency and
+ *		the overhead of each clock source are cached process-wide by the first
+ *		timer reading it (see msutimer_new_ex()).
  * @par Failures:
- * 		- timer is `NULL` (`errno` is set to `EDOM`)
- * @sa
- *		msutimer_bench(), msutimer_bench_average(), msutimer_bench_median()
+ * 		- storage is `NULL` or misaligned (`errno` is set to `EDOM`)
+ * 		- size is less than `MSUT_TIMER_SIZE` (`errno` is set to `EDOM`)
+ * 		- source is not a valid ::MSUTimerClock (`errno` is set to `EDOM`)
+ * 		- no OS/hardware support for the requested clock source (`errno` is set to `ERANGE`)
  *
  * @par Sample Usage
- *		See [Usage Quick Guide](@ref msut_use) for detailed examples.
+ * @code
+		MSUTimerStorage storage;
+		MSUTimer *timer = msutimer_init( &storage, sizeof(storage), MSUT_CLOCK_DEFAULT );
+		if ( !timer ) { handle error here }
+		...
+		msutimer_fini( timer );
+ * @endcode
  */
-double msutimer_gettime( MSUTimer *timer )
+MSUTimer *msutimer_init( void *storage, size_t size, MSUTimerClock source )
 {
 	errno = 0;
-	if ( !timer ) {
+
+	if ( !storage || 0 != (uintptr_t)storage % sizeof(uint64_t) || 0 != (uintptr_t)storage % sizeof(void *) ) {
 		errno = EDOM;
-		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
-		return -DBL_MAX;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (storage=NULL or misaligned). Return: NULL" );
+		return NULL;
+	}
+	if ( size < MSUT_TIMER_SIZE ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "(EDOM) function parameter (size=%zu, less than %d). Return: NULL\n", size, MSUT_TIMER_SIZE );
+		return NULL;
+	}
+	if ( (unsigned)source >= MSUT_NCLOCKS ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "(EDOM) function parameter (source=%d). Return: NULL\n", (int)source );
+		return NULL;
 	}
 
-	MSUTimerTime t2;
-	get_msuttime_( &t2 );
-	update_diffusecs_( timer, &t2 );
-
-	timer->t1 = t2;
-	return msuttime_to_usecs_( &timer->t1, &timer->freq );
-;
+	MSUTimer *timer = storage;
+	memset( timer, 0, sizeof(*timer) );
+	if ( !timer_setup_( timer, source, MSUT_ORIGIN_USER_ ) ) {
+		return NULL;
+	}
+	return timer;
 }
 
 // ----------------------------------------
-// double msutimer_diff_usecs( MSUTimer *timer );
+// void msutimer_fini( MSUTimer *timer );
 /**
- * Queries its timer argument for the updated time-difference, after a call to
- * msutimer_gettime(). Calling this function before calling msutimer_gettime()
- * first, results to a random value (bogus time-difference).
+ * Releases the resources of a timer created by msutimer_init() (e.g. the
+ * buffer of msutimer_reserve_samples(), or the counters of
+ * msutimer_perf_enable()), without de-allocating its storage.
+ *
+ * The timer may then be initialized again. It does nothing if `timer` is
+ * `NULL`, and for any other timer it is the same as msutimer_free().
  *
  * @param timer
- *		The timer to be queried.
+ *		The timer to be finalized.
+ * @sa
+ *		msutimer_init(), msutimer_free()
+ */
+void msutimer_fini( MSUTimer *timer )
+{
+	msutimer_free( timer );
+}
+
+// ----------------------------------------
+// MSUTimerPool *msutimer_pool_new( MSUTimerClock source, size_t ntimers );
+/**
+ * Constructs a pool of preallocated timers, all reading the specified clock
+ * source. De-allocation should be done by the caller, with msutimer_pool_free().
+ *
+ * Timers are taken from the pool with msutimer_pool_acquire(), and given back
+ * with msutimer_free(), both in constant time and without touching the heap.
+ * It is meant for programs creating many short-lived timers (e.g. one per
+ * traced request), where a `calloc()` and a `free()` per timer would show up
+ * in the profiles, and would scatter the timers across the heap.
+ *
+ * @param source
+ *		The clock source of the timers (see ::MSUTimerClock).
+ * @param ntimers
+ *		The number of timers in the pool.
  * @return
- *		A `double` reflecting the updated time-difference in *microseconds*
- *		after a call to msutimer_gettime(),	or `-DBL_MAX` on error.
+ *		The newly allocated pool, or `NULL` on error.
+ * @remarks
+ *		All the timers are allocated in a single block, each one aligned to and
+ *		padded to whole cache-lines (`MSUT_CACHELINE` bytes), so that timers
+ *		used by different threads never share one. Acquiring and releasing
+ *		them is thread-safe (under a spin lock of the pool), but each timer
+ *		should be used by a single thread at a time.
  * @par Failures:
- * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- ntimers is 0 (`errno` is set to `EDOM`)
+ * 		- source is not a valid ::MSUTimerClock (`errno` is set to `EDOM`)
+ * 		- no OS/hardware support for the requested clock source (`errno` is set to `ERANGE`)
+ * 		- memory allocation failure (`errno` is set by the C runtime)
  * @sa
- *		msutimer_diff_msecs(), msutimer_diff_secs(), [Usage Quick Guide](@ref msut_use)
+ *		msutimer_pool_acquire(), msutimer_pool_available(), msutimer_free()
  *
  * @par Sample Usage
  * @code
- 		MSUTimer *timer = msutimer_new();	// if ( !timer1 ) { handle error here }
- 		...
-		msutimer_gettime( timer );
-		printf( "Elapsed: %.9lf usecs\n", msutimer_diff_usecs(timer) );
+		MSUTimerPool *pool = msutimer_pool_new( MSUT_CLOCK_DEFAULT, 4096 );
+		if ( !pool ) { handle error here }
 		...
-		msutimer_gettime( timer );
-		printf( "Elapsed: %.9lf usecs\n", msutimer_diff_usecs(timer) );
- 		msutimer_free( timer );
+		MSUTimer *timer = msutimer_pool_acquire( pool );	// started
+		if ( timer ) {
+			handle_request( req );
+			trace_request( req, msutimer_gettime(timer) );
+			msutimer_free( timer );		// back to the pool
+		}
+		...
+		pool = msutimer_pool_free( pool );
  * @endcode
  */
-double msutimer_diff_usecs( MSUTimer *timer )
+MSUTimerPool *msutimer_pool_new( MSUTimerClock source, size_t ntimers )
 {
 	errno = 0;
-	if ( !timer ) {
+
+	if ( 0 == ntimers ) {
 		errno = EDOM;
-		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
-		return -DBL_MAX;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (ntimers=0). Return: NULL" );
+		return NULL;
 	}
-	return timer->diffusecs;
+	if ( (unsigned)source >= MSUT_NCLOCKS ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "(EDOM) function parameter (source=%d). Return: NULL\n", (int)source );
+		return NULL;
+	}
+	MSUTimerClockInfo_ info;
+	MSUTimerClock resolved = resolve_clock_( source );
+	if ( MSUT_NCLOCKS == resolved || !get_clock_info_(resolved, &info) ) {
+		errno = ERANGE;
+		MSUT_DBGMSG( "ERROR", "(ERANGE) clock source %s is not supported. Return: NULL\n", msutimer_clock_name(source) );
+		return NULL;
+	}
+	if ( ntimers > (SIZE_MAX - MSUT_CACHELINE) / MSUT_POOL_STRIDE_ ) {
+		errno = ENOMEM;
+		MSUT_DBGMSG( "ERROR", "(ENOMEM) too many timers (ntimers=%zu). Return: NULL\n", ntimers );
+		return NULL;
+	}
+
+	MSUTimerPool *pool = calloc( 1, sizeof(*pool) );
+	if ( !pool ) {
+		MSUT_DBGMSG( "ERROR", "calloc(%zu) failed. Return: NULL\n", sizeof(*pool) );
+		return NULL;
+	}
+	pool->mem = malloc( ntimers * MSUT_POOL_STRIDE_ + MSUT_CACHELINE );
+	if ( !pool->mem ) {
+		MSUT_DBGMSG( "ERROR", "malloc(%zu) failed. Return: NULL\n", ntimers * MSUT_POOL_STRIDE_ + MSUT_CACHELINE );
+		free( pool );
+		return NULL;
+	}
+	pool->timers = (unsigned char *) (((uintptr_t)pool->mem + MSUT_CACHELINE - 1) & ~(uintptr_t)(MSUT_CACHELINE - 1));
+	pool->source = source;
+	pool->ntimers = ntimers;
+
+	// link the free-list in address order, so the first timers acquired are adjacent
+	pool->free = NULL;
+	for (size_t i = ntimers; i-- > 0; ) {
+		MSUTimer *timer = (MSUTimer *) (pool->timers + i * MSUT_POOL_STRIDE_);
+		timer->next_free = pool->free;
+		pool->free = timer;
+	}
+	pool->nfree = ntimers;
+	return pool;
 }
 
 // ----------------------------------------
-// double msutimer_diff_msecs(MSUTimer *timer);
+// MSUTimerPool *msutimer_pool_free( MSUTimerPool *pool );
 /**
- * Queries its timer argument for the updated time-difference, after a call to
- * msutimer_gettime(). Calling this function before calling msutimer_gettime()
- * first, results to a random value (bogus time-difference).
+ * De-allocates the memory reserved for its pool argument, including all of
+ * its timers. All of them should have been given back to the pool (timers
+ * still acquired are left dangling, and their resources leak).
  *
- * @param timer
- *		The timer to be queried.
+ * @param pool
+ *		The pool to be freed.
  * @return
- *		A `double` reflecting the updated time-difference in *milliseconds*
- *		after a call to msutimer_gettime(), or `-DBL_MAX` on error.
- * @par Failures:
- * 		- timer is `NULL` (`errno` is set to `EDOM`)
- * @sa
- *		msutimer_diff_usecs(), msutimer_diff_secs(), [Usage Quick Guide](@ref msut_use)
+ *		Always`NULL`, so the caller can opt to assign it back to the freed pointer,
+ *		to avoid leaving it in a dangling state.
  */
-double msutimer_diff_msecs( MSUTimer *timer )
+MSUTimerPool *msutimer_pool_free( MSUTimerPool *pool )
 {
-	errno = 0;
-	if ( !timer ) {
-		errno = EDOM;
-		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
-		return -DBL_MAX;
+	if ( pool ) {
+		if ( pool->nfree != pool->ntimers ) {
+			MSUT_DBGMSG( "WARNING", "%zu timers are still acquired.\n", pool->ntimers - pool->nfree );
+		}
+		free( pool->mem );
+		free( pool );
 	}
-	return 0.001 * timer->diffusecs;
+	return NULL;
 }
 
 // ----------------------------------------
-// double msutimer_diff_secs( MSUTimer *timer );
+// MSUTimer *msutimer_pool_acquire( MSUTimerPool *pool );
 /**
- * Queries its timer argument for the updated time-difference, after a call to
- * msutimer_gettime(). Calling this function before calling msutimer_gettime()
- * first, results to a random value (bogus time-difference).
+ * Takes a timer from its pool argument, initialized and started as
+ * msutimer_new_ex() does. It should be given back to the pool with
+ * msutimer_free().
  *
- * @param timer
- *		The timer to be queried.
+ * @param pool
+ *		The pool to take the timer from.
  * @return
- *		A `double` reflecting the updated time-difference in *seconds* after
- *		a call to msutimer_gettime(), or `-DBL_MAX` on error.
+ *		The timer, or `NULL` on error.
+ * @remarks
+ *		Each acquired timer starts afresh (e.g. with no reserved samples, no
+ *		warm-up and no counters), as if it had just been created.
  * @par Failures:
- * 		- timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- pool is `NULL` (`errno` is set to `EDOM`)
+ * 		- all the timers of the pool are acquired (`errno` is set to `ENOMEM`)
+ * 		- the clock source cannot be read (`errno` is set to `ERANGE`)
  * @sa
- *		msutimer_diff_usecs(), msutimer_diff_msecs(), [Usage Quick Guide](@ref msut_use)
+ *		msutimer_pool_new(), msutimer_free()
  */
-double msutimer_diff_secs( MSUTimer *timer )
+MSUTimer *msutimer_pool_acquire( MSUTimerPool *pool )
 {
 	errno = 0;
-	if ( !timer ) {
+
+	if ( !pool ) {
 		errno = EDOM;
-		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
-		return -DBL_MAX;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (pool=NULL). Return: NULL" );
+		return NULL;
 	}
-	return 0.000001 * timer->diffusecs;
+
+	zone_lock_( &pool->lock );
+	MSUTimer *timer = pool->free;
+	if ( timer ) {
+		pool->free = timer->next_free;
+		pool->nfree--;
+	}
+	zone_unlock_( &pool->lock );
+
+	if ( !timer ) {
+		errno = ENOMEM;
+		MSUT_DBGMSG( "ERROR", "(ENOMEM) all %zu timers of the pool are acquired. Return: NULL\n", pool->ntimers );
+		return NULL;
+	}
+
+	memset( timer, 0, sizeof(*timer) );
+	timer->pool = pool;
+	if ( !timer_setup_( timer, pool->source, MSUT_ORIGIN_POOL_ ) ) {
+		int err = errno;
+		pool_release_( pool, timer );
+		errno = err;
+		return NULL;
+	}
+	return timer;
 }
 
 // ----------------------------------------
-// double msutimer_accuracy_usecs( MSUTimer *timer )
+// Give a timer (with its resources already released) back to its pool
+//
+static void pool_release_( MSUTimerPool *pool, MSUTimer *timer )
+{
+	zone_lock_( &pool->lock );
+	timer->next_free = pool->free;
+	pool->free = timer;
+	pool->nfree++;
+	zone_unlock_( &pool->lock );
+}
+
+// ----------------------------------------
+// size_t msutimer_pool_available( MSUTimerPool *pool );
 /**
- * Obtains the minimum time-interval that can be measured by *MSUTimer*, on
- * the running platform. The returned *microseconds* can be converted to
- * *milliseconds* or *seconds*, with the convenience macros MSUT_US2MS() or
- * MSUT_US2S(), respectively.
+ * Queries its pool argument for the number of its timers that are not
+ * acquired.
  *
- * @param timer
- *		Any already created timer.
+ * @param pool
+ *		The pool to be queried.
  * @return
- *		A `double` representing the *MSUTimer* accuracy on the current platform
- *		in *microseconds*, or `-DBL_MAX` on error.
- * @remarks
- *		On Windows, a typical accuracy is around 0.320 *microseconds*.
- *		Occasionally the function may return a bogus value, but it is pretty
- *		rare (and I really don't know why it's doing that).
- *
+ *		The number of free timers (it may already be stale when other threads
+ *		use the pool), or 0 on error.
  * @par Failures:
- * 		- timer is `NULL` (`errno` is set to `EDOM`)
- * @sa
- *		[Platform Dependent Measurements](@ref msut_pdm)
- *
- * @par Sample Usage
- * @code
-		#include "msutimer.h"
-		...
-		int main( void ) {
-			MSUTimer *timer = msutimer_new();
-			if (!timer) { fputs("msutimer_new()failed!\n", stderr); exit(1); }
-
-			double usecs = msutimer_accuracy_usecs(timer);
-			printf( "MSUTimer accuracy: %.9.lf secs\n", MSUT_US2S(usecs) );
-			printf( "MSUTimer accuracy: %.9.lf msecs\n", MSUT_US2MS(usecs) );
-			printf( "MSUTimer accuracy: %.9.lf usecs\n", usecs );
-
-			msutimer_free( timer );
-			exit(0);
-		}
-		// Output -------------
-		// MSUTimer accuracy: 0.000000320 secs
-		// MSUTimer accuracy: 0.000320801 msecs
-		// MSUTimer accuracy: 0.320312500 usecs
- * @endcode
+ * 		- pool is `NULL` (`errno` is set to `EDOM`)
  */
-// ----------------------------------------
-// DUNNO WHY, but with MingW32 it sometimes gives bogus result, especially
-// with gettimeofday() and clock(). IS NOT tested with other compilers.
-//
-double msutimer_accuracy_usecs( MSUTimer *timer )
+size_t msutimer_pool_available( MSUTimerPool *pool )
 {
 	errno = 0;
-	if ( !timer ) {
-		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (timer=NULL). Return: -DBL_MAX" );
-		return -DBL_MAX;
+	if ( !pool ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (pool=NULL). Return: 0" );
+		return 0;
 	}
 
-	double t1 = msutimer_gettime( timer );
-	double t2 = t1;
-	for ( ;; ) {
-		if ( (t2 = msutimer_gettime(timer)) > t1 ) {
-			break;
-		}
-	}
-	return t2 - t1;
+	zone_lock_( &pool->lock );
+	size_t nfree = pool->nfree;
+	zone_unlock_( &pool->lock );
+	return nfree;
 }
 
+/* ----------------------------------
+ * Spans
+ * ----------------------------------
+ */
+
 // ----------------------------------------
-// double msutimer_bench( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat );
-/**
- * Measures the execution time of its callback-function argument, after a
- * specified number of iterations. 
- *
- * @param timer
- *		An already created timer.
- * @param nrepeats
- *		The number of times to execute the callback-function (iterations).
- * @param callback
- *		The callback-function to be measured. It should be of type `bool` (C99)
- *		returning `false` on error, `true` otherwise. Its prototype should be
- *		the following:
- * @code
-		bool (*callback)(void *userdata);
- * @endcode
- * @param userdata
- *		A `void` pointer to caller-defined data, used by the callback-function.
- *		This pointer gets directly passed to the callback-function without any
- *		processing. It may be `NULL` if the callback-functions doesn't use any
- *		extra data.
- * @param erepeat
- *		If non-`NULL`, then in case of callback error (`false`) `erepeat` passes
- *		back to the caller the last successful iteration.
- * @return
- *		A `double` representing the time spent (in *microseconds*) to execute
- *		the callback-function `nrepeats` times.
- *
- *		If the callback-function errors before completing `nrepeats` iterations,
- *		then the returned value is	**negative** and `erepeat` (if non-`NULL`)
- *		passes back to the caller the last successful iteration. Hence a negative
- *		return value reflects the number of *microseconds* elpased until the
- *		`erepeat`'th iteration.
+// Active-time ticks of a span: of the thread CPU clock, or (without one) of
+// its elapsed-time clock, already read as `now`
+//
+static inline MSUTimerTime span_active_now_( const MSUTimerSpan *span, MSUTimerTime now )
+{
+	if ( span->cpu_usecs_per_tick > 0.0 ) {
+		get_msuttime_( MSUT_CLOCK_THREAD_CPU, &now );
+	}
+	else if ( 0 == now ) {
+		get_msuttime_( span->timer->source, &now );
+	}
+	return now;
+}
+
+// ----------------------------------------
+// Convert active-time ticks of a span to microseconds
+//
+static inline double span_active_usecs_( const MSUTimerSpan *span, MSUTimerTime ticks )
+{
+	double upt = span->cpu_usecs_per_tick > 0.0 ? span->cpu_usecs_per_tick : span->timer->usecs_per_tick;
+	return (double)ticks * upt;
+}
+
+// ----------------------------------------
+// bool msutimer_span_begin( MSUTimerSpan *span, const MSUTimer *timer );
+/**
+ * Starts timing a logical operation (e.g. a request served by an event loop,
+ * or a coroutine) that may be suspended and resumed any number of times,
+ * possibly on different threads.
  *
- *		On all other errors, `errno` is set to `EDOM` and the function returns 0.0
+ * A span measures both its total elapsed time, from msutimer_span_begin() to
+ * msutimer_span_end(), and its active time, i.e. the on-CPU time of the thread
+ * running each segment between a (re)start and the following suspension.
+ * The rest of the elapsed time was spent suspended (e.g. queued, or waiting on
+ * I/O) or descheduled, so the latency of an operation can be split into
+ * waiting and service time.
  *
+ * @param span
+ *		The span to be started (any previous contents are discarded).
+ * @param timer
+ *		The timer providing the clock source (it is not modified). It must
+ *		outlive the span.
+ * @return
+ *		`true` on success, `false` on error.
  * @remarks
- * 		- When the function returns 0.0, the caller can tell if there was an error
- * 		  by checking `errno` against `EDOM` (or not being 0). In *MSUTimer* debug
- * 		  mode (e.g. compiled with `-DMSUTDEBUG` or `-DMSUTDEBUG=2`) errors are
- * 		  auto reported to `stderr`.
- * 		- The return value can be converted to *milliseconds* or *seconds* with
- * 		  the convenience macros MSUT_US2MS() or MSUT_US2S(), respectively.
- * 		- For an example (without error-handling) see the section
- * 		  [Benchmarking](@ref msut_bench).
- *
+ *		A span needs no memory besides its own, and suspending or resuming it
+ *		costs a single read of the thread CPU clock (MSUT_CLOCK_THREAD_CPU).
+ *		Each segment must be suspended (or ended) on the thread that resumed
+ *		it, since the CPU times of different threads are unrelated; where the
+ *		platform has no thread CPU clock, the active time falls back to the
+ *		elapsed time of the segments. A span is not synchronized: only one
+ *		thread at a time may use it, and handing it over to another thread
+ *		(e.g. through the queue of a thread pool) must be synchronized by the
+ *		caller. The clock source of the timer must read the same time on all
+ *		threads, so the CPU-time sources are not accepted (MSUT_CLOCK_TSC is
+ *		fine on CPUs with an invariant TSC, which is kept in sync across cores).
  * @par Failures:
- * 		- timer is `NULL` (returns 0.0, `errno` is set to `EDOM`)
- * 		- nrepeats is 0 (returns 0.0, `errno` is set to `EDOM`)
- * 		- callback is `NULL` (returns 0.0, `errno` is set to `EDOM`)
- * 		- callback returns `false` (`erepeat` is set to the last successful
- * 	      iteration and the function returns the elapsed *microseconds* until
- *		  then, as a negative `double`).
+ * 		- span or timer is `NULL` (`errno` is set to `EDOM`)
+ * 		- timer uses MSUT_CLOCK_PROCESS_CPU or MSUT_CLOCK_THREAD_CPU (`errno` is set to `EDOM`)
+ * 		- the clock source cannot be read (`errno` is set to `ERANGE`)
  * @sa
- *		msutimer_bench_average(), msutimer_bench_median(), [Benchmarking](@ref msut_bench)
+ *		msutimer_span_suspend(), msutimer_span_resume(), msutimer_span_end()
+ *
+ * @par Sample Usage
+ * @code
+		// on accepting the request
+		msutimer_span_begin( &req->span, timer );
+		...
+		// before every suspension point, and after it (maybe on another thread)
+		msutimer_span_suspend( &req->span );
+		co_await read_async( req );
+		msutimer_span_resume( &req->span );
+		...
+		// on completion (hist_total and hist_active owned by the calling thread)
+		msutimer_span_end( &req->span, hist_total, hist_active );
+ * @endcode
  */
-double msutimer_bench( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat )
+bool msutimer_span_begin( MSUTimerSpan *span, const MSUTimer *timer )
 {
 	errno = 0;
 
-	if ( !timer ) {
-		errno = EDOM;
-		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: 0 secs." );
-		return 0.0;
-	}
-	if ( !callback ) {
+	if ( !span || !timer ) {
 		errno = EDOM;
-		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: 0 secs." );
-		return 0.0;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (span=NULL or timer=NULL). Return: false" );
+		return false;
 	}
-	if ( nrepeats == 0 ) {
+	if ( MSUT_CLOCK_PROCESS_CPU == timer->source || MSUT_CLOCK_THREAD_CPU == timer->source ) {
 		errno = EDOM;
-		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nrepeats=0. Returned 0 secs." );
-		return 0.0;
+		MSUT_DBGMSG( "ERROR", "(EDOM) the timer uses %s, not an elapsed-time clock source. Return: false\n", msutimer_clock_name(timer->source) );
+		return false;
 	}
 
-	if ( erepeat ) {
-		*erepeat = 0;	// reset
+	memset( span, 0, sizeof(*span) );
+	MSUTimerTime now = 0;
+	if ( !get_msuttime_( timer->source, &now ) ) {
+		errno = ERANGE;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(ERANGE) get_msuttime() failed. Return: false" );
+		return false;
 	}
+	span->timer = timer;
+	span->start = now;
 
-	double bias = 1.0;
-	double t = msutimer_gettime( timer );
-	for (size_t i=0; i < nrepeats; i++) {
-		if ( !callback( userdata ) ) {
-			if ( erepeat ) {
-				*erepeat = i;
-			}
-			bias = -1.0;
-			MSUT_DBGMSG(
-				"WARNING",
-				"Requested iterations: %zu, but FAILED at %zu (erepeat).\n"
-				"==> Returned: elapsed secs until then (with negative sign).\n",
-				nrepeats,
-				i);
-			break;
-		}
+	MSUTimerClockInfo_ info;
+	if ( MSUT_NCLOCKS != resolve_clock_( MSUT_CLOCK_THREAD_CPU ) && get_clock_info_( MSUT_CLOCK_THREAD_CPU, &info ) ) {
+		span->cpu_usecs_per_tick = info.usecs_per_tick;
 	}
-
-	return bias * (msutimer_gettime(timer) - t);
+	span->t1 = span_active_now_( span, now );
+	return true;
 }
 
 // ----------------------------------------
-// double msutimer_bench_average( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat );
+// void msutimer_span_suspend( MSUTimerSpan *span );
 /**
- * Measures the average execution time of its callback-function argument, after
- * a specified number of iterations. 
+ * Suspends a span started with msutimer_span_begin(): the time until it is
+ * resumed counts as elapsed, but not as active time.
  *
+ * @param span
+ *		The span to be suspended.
  * @remarks
- *		For details see the function msutimer_bench(). The only difference
- *		is that msutimer_bench_average() returns the average time after `nrepeats`
- *		iterations, instead of summing up all iterations.
+ *		Like the other raw tick functions, it does not touch `errno`. It does
+ *		nothing if `span` is `NULL`, not started, ended, or already suspended.
+ * @sa
+ *		msutimer_span_resume()
+ */
+void msutimer_span_suspend( MSUTimerSpan *span )
+{
+	if ( span && span->timer && 0 == span->end && !span->suspended ) {
+		MSUTimerTime now = span_active_now_( span, 0 );
+		span->active += (now > span->t1) ? now - span->t1 : 0;
+		span->suspended = true;
+		span->nsuspends++;
+	}
+}
+
+// ----------------------------------------
+// void msutimer_span_resume( MSUTimerSpan *span );
+/**
+ * Resumes a span suspended with msutimer_span_suspend(), on any thread.
  *
- *		Put otherwise, msutimer_bench() returns the total time after `nrepeats`
- *		iterations, while msutimer_bench_average() returns the average time of
- *		a single call after `nrepeats` iterations.
+ * @param span
+ *		The span to be resumed.
+ * @remarks
+ *		Like the other raw tick functions, it does not touch `errno`. It does
+ *		nothing if `span` is `NULL`, not started, ended, or not suspended.
+ * @sa
+ *		msutimer_span_suspend()
+ */
+void msutimer_span_resume( MSUTimerSpan *span )
+{
+	if ( span && span->timer && 0 == span->end && span->suspended ) {
+		span->t1 = span_active_now_( span, 0 );
+		span->suspended = false;
+	}
+}
+
+// ----------------------------------------
+// Elapsed & active-time ticks of a span until its end (or until now, while
+// it is open)
+//
+static void span_ticks_( const MSUTimerSpan *span, MSUTimerTime *total, MSUTimerTime *active )
+{
+	MSUTimerTime now = span->end;
+	if ( 0 == now ) {
+		now = span->start;
+		get_msuttime_( span->timer->source, &now );
+	}
+	*total = now - span->start;
+	*active = span->active;
+	if ( 0 == span->end && !span->suspended ) {
+		MSUTimerTime t = span_active_now_( span, now );
+		*active += (t > span->t1) ? t - span->t1 : 0;		// the running segment
+	}
+}
+
+// ----------------------------------------
+// bool msutimer_span_end( MSUTimerSpan *span, MSUTimerHist *total, MSUTimerHist *active );
+/**
+ * Ends a span started with msutimer_span_begin(), and records its elapsed
+ * and active times into a histogram each.
  *
- *		Compared to msutimer_bench_median(), this function accounts excessive
- *		spikes in the computation ([average vs. median](https://www.diffen.com/difference/Mean_vs_Median)).
+ * A span that is suspended when it ends stays suspended until the end. Once
+ * ended, msutimer_span_total_usecs() and msutimer_span_active_usecs() keep
+ * reporting its final times, until it is started again.
  *
+ * @param span
+ *		The span to be ended.
+ * @param total
+ *		If non-`NULL`, the histogram to record the elapsed time into.
+ * @param active
+ *		If non-`NULL`, the histogram to record the active time into.
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		Histograms are not synchronized, so spans ending on several threads
+ *		should record into histograms owned by each thread (e.g. created with
+ *		msutimer_group_hist_new()), merged on demand with msutimer_hist_merge().
+ * @par Failures:
+ * 		- span is `NULL`, not started, or already ended (`errno` is set to `EDOM`)
  * @sa
- *		msutimer_bench(), msutimer_bench_median(), [Benchmarking](@ref msut_bench)
+ *		msutimer_span_begin(), msutimer_hist_percentile()
  */
-double msutimer_bench_average( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat )
+bool msutimer_span_end( MSUTimerSpan *span, MSUTimerHist *total, MSUTimerHist *active )
 {
 	errno = 0;
 
-	if ( !timer ) {
+	if ( !span || !span->timer || 0 != span->end ) {
 		errno = EDOM;
-		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: 0 secs." );
-		return 0.0;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (span=NULL, not started or already ended). Return: false" );
+		return false;
 	}
-	if ( !callback ) {
+
+	MSUTimerTime now = span->start;
+	get_msuttime_( span->timer->source, &now );
+	if ( !span->suspended ) {
+		MSUTimerTime t = span_active_now_( span, now );
+		span->active += (t > span->t1) ? t - span->t1 : 0;
+	}
+	span->end = (0 == now) ? 1 : now;	// 0 means open
+
+	if ( total ) {
+		msutimer_hist_record_ns( total, (uint64_t)((double)(now - span->start) * span->timer->nsecs_per_tick + 0.5) );
+	}
+	if ( active ) {
+		msutimer_hist_record_ns( active, (uint64_t)(1000.0 * span_active_usecs_( span, span->active ) + 0.5) );
+	}
+	return true;
+}
+
+// ----------------------------------------
+// double msutimer_span_total_usecs( const MSUTimerSpan *span );
+/**
+ * Queries its span argument for its elapsed time: until it was ended, or
+ * until now if it is still open.
+ *
+ * @param span
+ *		The span to be queried.
+ * @return
+ *		A `double` representing the elapsed time in *microseconds*, or
+ *		`-DBL_MAX` on error.
+ * @par Failures:
+ * 		- span is `NULL` or not started (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_span_active_usecs()
+ */
+double msutimer_span_total_usecs( const MSUTimerSpan *span )
+{
+	errno = 0;
+	if ( !span || !span->timer ) {
 		errno = EDOM;
-		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: 0 secs." );
-		return 0.0;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (span=NULL or not started). Return: -DBL_MAX" );
+		return -DBL_MAX;
 	}
-	if ( nrepeats == 0 ) {
+
+	MSUTimerTime total, active;
+	span_ticks_( span, &total, &active );
+	return (double)total * span->timer->usecs_per_tick;
+}
+
+// ----------------------------------------
+// double msutimer_span_active_usecs( const MSUTimerSpan *span );
+/**
+ * Queries its span argument for its active time, i.e. the on-CPU time of its
+ * segments (see msutimer_span_begin()): until it was ended, or until now if it
+ * is still open, in which case it must be queried on the thread running it.
+ *
+ * @param span
+ *		The span to be queried.
+ * @return
+ *		A `double` representing the active time in *microseconds*, or
+ *		`-DBL_MAX` on error.
+ * @par Failures:
+ * 		- span is `NULL` or not started (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_span_total_usecs()
+ */
+double msutimer_span_active_usecs( const MSUTimerSpan *span )
+{
+	errno = 0;
+	if ( !span || !span->timer ) {
 		errno = EDOM;
-		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nrepeats=0. Returned 0 secs." );
-		return 0.0;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (span=NULL or not started). Return: -DBL_MAX" );
+		return -DBL_MAX;
 	}
 
-	// run callback nrepeats times and time the average
-	double bias = 1.0;
-	double sum = 0;
-	double t;
-	for (size_t i=0; i < nrepeats; i++) {
-		t = msutimer_gettime( timer );
+	MSUTimerTime total, active;
+	span_ticks_( span, &total, &active );
+	return span_active_usecs_( span, active );
+}
 
-		if ( !callback( userdata ) ) {
-			if ( erepeat ) {
-				*erepeat = i;
-			}
-			bias = -1.0;
-			MSUT_DBGMSG(
-				"WARNING",
-				"Requested iterations: %zu, but FAILED at %zu (erepeat).\n"
-				"==> Returned: average secs until then (with negative sign).\n",
-				nrepeats,
-				i+1
-				);
-			nrepeats = i;	// # of successful iterations before failure
-			break;
-		}
+/* ----------------------------------
+ * Sampled Timing
+ * ----------------------------------
+ */
 
-		t = msutimer_gettime( timer ) - t;
-		sum += t;
+// ----------------------------------------
+// Calls until the next timed one: the period, or a uniformly random gap in
+// [1, 2*period - 1] (of the same mean), so that the timed calls do not lock
+// onto a periodic pattern of the workload.
+//
+static uint64_t sampler_gap_( MSUTimerSampler *sampler )
+{
+	if ( 0 == sampler->rng || sampler->period < 2 ) {
+		return sampler->period;
 	}
-
-	return bias * sum / nrepeats;
+	return 1 + xorshift64s_( &sampler->rng ) % (2 * sampler->period - 1);
 }
 
 // ----------------------------------------
-// double msutimer_bench_median( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat );
+// bool msutimer_sampler_init( MSUTimerSampler *sampler, uint64_t period, double max_overhead_pct, unsigned flags, MSUTimerHist *hist );
 /**
- * Measures the median execution time of its callback-function argument, after
- * a specified number of iterations. 
- *
- * @remarks
- *		For details see the function msutimer_bench(). The only difference
- *		is that msutimer_bench_median() returns the median time after `nrepeats`
- *		iterations, instead of summing up all iterations.
- *
- *		Put otherwise, msutimer_bench() returns the total time after `nrepeats`
- *		iterations, while msutimer_bench_median() returns the median time of
- *		a single call after `nrepeats` iterations.
+ * Initializes a sampler, for timing only 1 call in `period` of an instrumented
+ * code path, with msutimer_sample_begin() and msutimer_sample_end() (see
+ * msutimer_inline.h).
  *
- *		Compared to msutimer_bench_average(), this function ignores excessive
- *		spikes in the computation ([average vs. median](https://www.diffen.com/difference/Mean_vs_Median)).
+ * Each timed call stands for `period` calls: the estimated number of calls,
+ * their total time and the histogram (if any) are scaled up accordingly, so
+ * they estimate those of timing every call, at a fraction of the cost.
  *
+ * @param sampler
+ *		The sampler to be initialized (any previous contents are discarded).
+ * @param period
+ *		The initial period (1 times every call).
+ * @param max_overhead_pct
+ *		If positive, the period is re-estimated after every `MSUT_SAMPLE_ADAPT_WINDOW`
+ *		timed calls (64 by default), to keep the cost of timing under that
+ *		percentage of the time of the calls (e.g. 1.0 for 1%), up to a period of
+ *		`MSUT_SAMPLE_MAX_PERIOD` (1048576 by default). If 0.0, the period is
+ *		constant.
+ * @param flags
+ *		0 for a fixed period (every `period`-th call is timed), or MSUT_SAMPLE_RANDOM
+ *		for random gaps of the same mean, which do not alias with periodic
+ *		workloads.
+ * @param hist
+ *		If non-`NULL`, a histogram to record the timed calls into (each one
+ *		counted `period` times). It is not synchronized, so it should not be
+ *		shared by the samplers of different threads (see msutimer_hist_merge()).
+ * @return
+ *		`true` on success, `false` on error.
+ * @remarks
+ *		The samplers read the default clock source inline, so the library must
+ *		be compiled with the same `MSUT_DEFAULT_CLOCK` as the instrumented code.
+ *		The cost of timing a call is taken as that of an empty timed region of
+ *		the default clock source (see msutimer_overhead_usecs()), and it is
+ *		subtracted from every timed call, since it would be scaled up along
+ *		with it; the untimed calls cost a decrement and a branch.
+ * @par Failures:
+ * 		- sampler is `NULL` (`errno` is set to `EDOM`)
+ * 		- period is 0 or above `MSUT_SAMPLE_MAX_PERIOD` (`errno` is set to `EDOM`)
+ * 		- max_overhead_pct is negative (`errno` is set to `EDOM`)
+ * 		- the default clock source is not supported (`errno` is set to `ERANGE`)
  * @sa
- *		msutimer_bench(), msutimer_bench_median(), [Benchmarking](@ref msut_bench)
+ *		msutimer_sampler_stats(), msutimer_sampler_reset()
  */
-double msutimer_bench_median( MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat )
+bool msutimer_sampler_init( MSUTimerSampler *sampler, uint64_t period, double max_overhead_pct, unsigned flags, MSUTimerHist *hist )
 {
 	errno = 0;
 
-	if ( !timer ) {
+	if ( !sampler ) {
 		errno = EDOM;
-		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to timer=NULL. Return: 0 secs." );
-		return 0.0;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (sampler=NULL). Return: false" );
+		return false;
 	}
-	if ( !callback ) {
+	if ( 0 == period || period > MSUT_SAMPLE_MAX_PERIOD || !(max_overhead_pct >= 0.0) ) {
 		errno = EDOM;
-		MSUT_DBGMSG( "ERROR", "%s\n", "Immediate return due to callback=NULL. Return: 0 secs." );
-		return 0.0;
+		MSUT_DBGMSG( "ERROR", "(EDOM) function parameter (period=%llu, max_overhead_pct=%g). Return: false\n", (unsigned long long)period, max_overhead_pct );
+		return false;
 	}
-	if ( nrepeats == 0 ) {
-		errno = EDOM;
-		MSUT_DBGMSG( "WARNING", "%s\n", "Immediate return due to nrepeats=0. Returned 0 secs." );
-		return 0.0;
+
+	MSUTimerClockInfo_ info;
+	MSUTimerClock source = resolve_clock_( MSUT_CLOCK_DEFAULT );
+	if ( MSUT_NCLOCKS == source || !get_clock_info_(source, &info) ) {
+		errno = ERANGE;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(ERANGE) the default clock source is not supported. Return: false" );
+		return false;
 	}
 
-	// array of recorded times
-	double *rectimes = malloc( nrepeats * sizeof(double) );
-	if ( !rectimes ) {
-		MSUT_DBGMSG( "ERROR", "malloc(%zu) failed! Returned: 0 secs.\n", nrepeats * sizeof(double) );
-		return 0.0;
+	memset( sampler, 0, sizeof(*sampler) );
+	sampler->period = period;
+	sampler->hist = hist;
+	sampler->nsecs_per_tick = 1000.0 * info.usecs_per_tick;
+	sampler->overhead_ticks = (info.overhead_ticks > 1.0) ? info.overhead_ticks : 1.0;
+	sampler->max_overhead = 0.01 * max_overhead_pct;
+	if ( flags & MSUT_SAMPLE_RANDOM ) {
+		MSUTimerTime seed = 0;
+		get_msuttime_( source, &seed );
+		sampler->rng = (seed ^ (uint64_t)(uintptr_t)sampler) | 1;	// never 0
 	}
+	sampler->countdown = sampler_gap_( sampler );
+	return true;
+}
 
-	// record nrepeats timings
-	double bias = 1.0;
-	double t;
-	for (size_t i=0; i < nrepeats; i++) {
-		t = msutimer_gettime( timer );
+// ----------------------------------------
+// void msutimer_sampler_record_( MSUTimerSampler *sampler, uint64_t ticks );
+/**
+ * Records a timed call of a sampler (internal, called by msutimer_sample_end()),
+ * adapts its period, and draws the gap to the next timed call.
+ */
+void msutimer_sampler_record_( MSUTimerSampler *sampler, uint64_t ticks )
+{
+	// without the cost of the clock reads, which would be scaled up as well
+	double t = (double)ticks - sampler->overhead_ticks;
+	t = (t > 0.0) ? t : 0.0;
+	double nsecs = t * sampler->nsecs_per_tick;
 
-		if ( !callback( userdata ) ) {
-			if ( erepeat ) {
-				*erepeat = i;
-			}
-			bias = -1.0;
-			MSUT_DBGMSG(
-				"WARNING",
-				"Requested iterations: %zu, but FAILED at %zu (erepeat).\n"
-				"==> Returned: median secs until then (with negative sign).\n",
-				nrepeats,
-				i+1
-				);
-			nrepeats = i;	// # of successful iterations before failure
-			break;
+	sampler->nsampled++;
+	sampler->calls += sampler->period;
+	sampler->usecs += 0.001 * nsecs * (double)sampler->period;
+	if ( sampler->hist ) {
+		msutimer_hist_record_ns_n( sampler->hist, (uint64_t)(nsecs + 0.5), sampler->period );
+	}
+
+	// the overhead fraction is about overhead / (period * mean call time)
+	if ( sampler->max_overhead > 0.0 ) {
+		sampler->win_ticks += t;
+		if ( ++sampler->win_n == MSUT_SAMPLE_ADAPT_WINDOW ) {
+			double mean = sampler->win_ticks / (double)sampler->win_n;
+			double period = (mean > 0.0)
+				? ceil( sampler->overhead_ticks / (sampler->max_overhead * mean) )
+				: (double)MSUT_SAMPLE_MAX_PERIOD;
+			period = (period < 1.0) ? 1.0 : period;
+			period = (period > (double)MSUT_SAMPLE_MAX_PERIOD) ? (double)MSUT_SAMPLE_MAX_PERIOD : period;
+			sampler->period = (uint64_t)period;
+			sampler->win_n = 0;
+			sampler->win_ticks = 0.0;
 		}
-		rectimes[i] = msutimer_gettime(timer) - t;
 	}
 
-	// get median time (middle elem in sorted array)
-	qsort( rectimes, nrepeats, sizeof(double), compare_doubles_for_qsort_ );
-	double ret = rectimes[ nrepeats/2 ];	// if even # of elems, get average of the middle two
-	if ( nrepeats % 2 == 0 ) {
-		ret = (ret + rectimes[1 + nrepeats/2]) / 2;
+	sampler->countdown = sampler_gap_( sampler );
+}
+
+// ----------------------------------------
+// bool msutimer_sampler_stats( const MSUTimerSampler *sampler, MSUTimerStats *stats );
+/**
+ * Queries its sampler argument for the estimated statistics of all the
+ * instrumented calls, scaled up from the timed ones.
+ *
+ * @param sampler
+ *		The sampler to be queried (see msutimer_sampler_init()).
+ * @param stats
+ *		It passes back to the caller the statistics, in *microseconds*, with
+ *		the estimated number of calls in `nsamples`. With a histogram, they are
+ *		those of msutimer_hist_stats() on it; without one, only `nsamples`,
+ *		`total` and `mean` are filled.
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- sampler or stats is `NULL` (`errno` is set to `EDOM`)
+ * @sa
+ *		msutimer_sampler_init(), msutimer_hist_stats()
+ */
+bool msutimer_sampler_stats( const MSUTimerSampler *sampler, MSUTimerStats *stats )
+{
+	errno = 0;
+	if ( !sampler || !stats ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (sampler or stats=NULL). Return: false" );
+		return false;
+	}
+
+	if ( sampler->hist ) {
+		return msutimer_hist_stats( sampler->hist, stats );
 	}
+	memset( stats, 0, sizeof(*stats) );
+	stats->nsamples = (size_t) sampler->calls;
+	stats->total = sampler->usecs;
+	stats->mean = (sampler->calls > 0) ? sampler->usecs / (double)sampler->calls : 0.0;
+	return true;
+}
 
-	free( rectimes );
-	return bias * ret;
+// ----------------------------------------
+// bool msutimer_sampler_reset( MSUTimerSampler *sampler );
+/**
+ * Zeroes the counts of its sampler argument (and its histogram, if any),
+ * keeping its current period, e.g. at the start of a reporting interval.
+ *
+ * @param sampler
+ *		The sampler to be reset.
+ * @return
+ *		`true` on success, `false` on error.
+ * @par Failures:
+ * 		- sampler is `NULL` (`errno` is set to `EDOM`)
+ */
+bool msutimer_sampler_reset( MSUTimerSampler *sampler )
+{
+	errno = 0;
+	if ( !sampler ) {
+		errno = EDOM;
+		MSUT_DBGMSG( "ERROR", "%s\n", "(EDOM) function parameter (sampler=NULL). Return: false" );
+		return false;
+	}
+
+	sampler->calls = sampler->nsampled = 0;
+	sampler->usecs = 0.0;
+	if ( sampler->hist ) {
+		msutimer_hist_reset( sampler->hist );
+	}
+	return true;
 }
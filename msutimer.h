@@ -40,10 +40,172 @@ freely, subject to the following restrictions:
 
 #include <stddef.h>		// size_t, etc
 #include <stdbool.h>	// C99: bool, true, false
+#include <stdint.h>		// C99: uint64_t, etc
+#include <stdio.h>		// FILE
 
 /// Opaque type (forward-declaration)
 typedef struct MSUTimer_ MSUTimer;
 
+/// Opaque type (forward-declaration) of a constant-memory latency histogram.
+typedef struct MSUTimerHist_ MSUTimerHist;
+
+/// Opaque type (forward-declaration) of a group of per-thread timing slots.
+typedef struct MSUTimerGroup_ MSUTimerGroup;
+
+/// Opaque type (forward-declaration) of a per-thread timing slot.
+typedef union MSUTimerSlot_ MSUTimerSlot;
+
+/// Opaque type (forward-declaration) of a binary sample log.
+typedef struct MSUTimerLog_ MSUTimerLog;
+
+/// Opaque type (forward-declaration) of a pool of preallocated timers.
+typedef struct MSUTimerPool_ MSUTimerPool;
+
+/// Size in bytes of the storage of a timer, for timers not allocated by msutimer_new() (see msutimer_init()).
+#define MSUT_TIMER_SIZE		1024
+
+/// Suitably aligned storage for a timer of static or automatic duration (see msutimer_init()).
+typedef union MSUTimerStorage {
+	unsigned char bytes[ MSUT_TIMER_SIZE ];	///< The raw storage.
+	uint64_t align_u64_;					///< (internal) for the alignment.
+	double align_dbl_;						///< (internal) for the alignment.
+	void *align_ptr_;						///< (internal) for the alignment.
+} MSUTimerStorage;
+
+/// Clock sources, selectable per timer with msutimer_new_ex().
+/// Sources that are not available on the running platform make msutimer_new_ex()
+/// fail with `errno` set to `ERANGE`.
+typedef enum MSUTimerClock {
+	MSUT_CLOCK_DEFAULT = 0,		///< The compile-time default (see MSUT_DEFAULT_CLOCK), used by msutimer_new(). Always MSUT_CLOCK_PORTABLE on unknown platforms.
+	MSUT_CLOCK_MONOTONIC,		///< `clock_gettime(CLOCK_MONOTONIC)`, `mach_absolute_time()` on Apple, `QueryPerformanceCounter()` on Windows.
+	MSUT_CLOCK_MONOTONIC_RAW,	///< `clock_gettime(CLOCK_MONOTONIC_RAW)`, never slewed by NTP (falls back to MSUT_CLOCK_MONOTONIC off Linux).
+	MSUT_CLOCK_REALTIME,		///< Wall clock: `gettimeofday()` (1 *microsecond* resolution), `GetSystemTimeAsFileTime()` on Windows.
+	MSUT_CLOCK_PORTABLE,		///< Standard C `clock()`; the only source available on unknown platforms.
+	MSUT_CLOCK_TSC,				///< CPU cycle-counter: `rdtscp` on x86 (invariant TSC only, calibrated), `cntvct_el0` on ARM64.
+	MSUT_CLOCK_PROCESS_CPU,		///< CPU time of the process: `clock_gettime(CLOCK_PROCESS_CPUTIME_ID)`, `GetProcessTimes()` on Windows.
+	MSUT_CLOCK_THREAD_CPU,		///< CPU time of the calling thread: `clock_gettime(CLOCK_THREAD_CPUTIME_ID)`, `GetThreadTimes()` on Windows.
+	MSUT_NCLOCKS				///< Number of clock sources (not a valid source).
+} MSUTimerClock;
+
+/// Hardware performance counters of a benchmark run, per call of the callback (see msutimer_perf_enable()).
+typedef struct MSUTimerCounters {
+	bool valid;				///< `false` if the counters were not enabled (all the rest are then 0).
+	double cycles;			///< CPU cycles.
+	double instructions;	///< Retired instructions.
+	double ipc;				///< Instructions per cycle.
+	double cache_misses;	///< Last-level cache misses.
+	double branch_misses;	///< Mispredicted branches.
+} MSUTimerCounters;
+
+/// Memory allocations of a benchmark run, per call of the callback (see msutimer_alloc_enable()).
+typedef struct MSUTimerAllocs {
+	bool valid;				///< `false` if the tracking was not enabled (all the rest are then 0).
+	double allocs;			///< Allocations (`malloc()`, `calloc()`, `realloc()`).
+	double frees;			///< De-allocations (`free()`, `realloc()`).
+	double bytes;			///< Allocated bytes.
+	double peak_rss_delta;	///< Growth of the peak resident set size of the process over the run, in bytes (not per call; 0.0 if unknown).
+} MSUTimerAllocs;
+
+/// Conditions of the benchmark environment, recorded by msutimer_env_setup().
+typedef struct MSUTimerEnv {
+	bool active;		///< `false` if msutimer_env_setup() was not called (all the rest are then 0).
+	int cpu;			///< The CPU the thread is pinned to, or -1 if it is not pinned.
+	bool priority;		///< `true` if the thread priority was raised.
+	char governor[32];	///< The CPU frequency governor ("" if unknown).
+	int turbo;			///< 1 if turbo boost is enabled, 0 if it is disabled, -1 if unknown.
+	bool noisy;			///< `true` if a condition is known to add noise (no pinning, a governor other than "performance", or turbo boost).
+} MSUTimerEnv;
+
+/// @name Flags for msutimer_env_setup()
+/// @{
+#define MSUT_ENV_PIN		0x01u	///< Pin the calling thread to the specified CPU.
+#define MSUT_ENV_PRIORITY	0x02u	///< Raise the priority of the calling thread.
+#define MSUT_ENV_WARN		0x04u	///< Print warnings about noisy conditions to `stderr`.
+/// @}
+
+/// Statistics of a benchmark run, filled by msutimer_bench_stats().
+/// All times are per iteration, in *microseconds*.
+typedef struct MSUTimerStats {
+	size_t nsamples;	///< Number of recorded samples (successful iterations).
+	bool failed;		///< `true` if the callback failed before completing all iterations.
+	size_t erepeat;		///< The iteration the callback failed at (valid only if `failed`).
+	double total;		///< Sum of all samples.
+	double min;			///< Fastest sample.
+	double max;			///< Slowest sample.
+	double mean;		///< Average of the samples.
+	double stddev;		///< Sample standard deviation.
+	double median;		///< Median sample (average of the middle two, for an even count).
+	double p90;			///< 90th percentile (nearest rank).
+	double p99;			///< 99th percentile (nearest rank).
+	double p999;		///< 99.9th percentile (nearest rank).
+	double mad;			///< Median absolute deviation from the median.
+	size_t nwarmup;		///< Number of warm-up iterations (see msutimer_set_warmup()).
+	bool steady;		///< `true` if steady-state was reached (see msutimer_set_steady_state()).
+	MSUTimerCounters counters;	///< Hardware performance counters (see msutimer_perf_enable()).
+	MSUTimerAllocs allocs;	///< Memory allocations (see msutimer_alloc_enable()).
+	MSUTimerEnv env;	///< Conditions of the benchmark environment (see msutimer_env_setup()).
+	double wall_usecs;	///< Wall-clock time of the sampling pass (MSUT_CLOCK_MONOTONIC), 0.0 if not measured.
+	double cpu_usecs;	///< CPU time of the calling thread during the sampling pass (MSUT_CLOCK_THREAD_CPU), 0.0 if not measured.
+	double cpu_ratio;	///< `cpu_usecs / wall_usecs`: clearly below 1.0 when the thread was descheduled (0.0 if not measured).
+	bool cpu_valid;		///< `true` if the 3 above were measured (by msutimer_bench_stats() and MSUT_BENCH_LOOP()).
+} MSUTimerStats;
+
+/// Results of a multi-threaded benchmark run, filled by msutimer_bench_parallel().
+typedef struct MSUTimerParallel {
+	size_t nthreads;				///< Number of threads of the run.
+	bool failed;					///< `true` if a callback failed in any thread.
+	double elapsed_usecs;			///< Time from the first thread's start to the last one's finish, in *microseconds*.
+	double ops_per_sec;				///< Aggregate throughput, in iterations per second.
+	double min_thread_ops_per_sec;	///< Throughput of the slowest thread.
+	double max_thread_ops_per_sec;	///< Throughput of the fastest thread.
+	double speedup;					///< Aggregate throughput over the single-thread one (with MSUT_PARALLEL_SCALING).
+	double efficiency;				///< Speedup per thread (1.0 is perfect scaling; with MSUT_PARALLEL_SCALING).
+} MSUTimerParallel;
+
+/// Results of an A/B comparison, filled by msutimer_bench_compare().
+/// Times are per call, in *microseconds*.
+typedef struct MSUTimerCompare {
+	size_t nrounds;		///< Number of completed rounds.
+	bool failed;		///< `true` if a callback failed before completing all rounds.
+	int failed_which;	///< The callback that failed: 1 (A) or 2 (B) (valid only if `failed`).
+	double median_a;	///< Median over the rounds of the per-round medians of A.
+	double median_b;	///< Median over the rounds of the per-round medians of B.
+	double speedup;		///< `median_a / median_b`: above 1.0 when B is faster (0.0 if `median_b` is 0).
+	double ci_low;		///< Lower bound of the 95% bootstrap confidence interval of `speedup`.
+	double ci_high;		///< Upper bound of the 95% bootstrap confidence interval of `speedup`.
+	double p_value;		///< Two-sided Mann-Whitney U test p-value, of A and B having the same distribution.
+} MSUTimerCompare;
+
+/// Complexity models fitted by msutimer_fit_complexity().
+typedef enum MSUTimerComplexity {
+	MSUT_O_1 = 0,				///< Constant: O(1).
+	MSUT_O_LOGN,				///< Logarithmic: O(log n).
+	MSUT_O_N,					///< Linear: O(n).
+	MSUT_O_NLOGN,				///< Linearithmic: O(n log n).
+	MSUT_O_N2,					///< Quadratic: O(n^2).
+	MSUT_NCOMPLEXITIES			///< Number of models (also: no fit).
+} MSUTimerComplexity;
+
+/// The best-matching complexity of a set of timings, filled by msutimer_fit_complexity().
+typedef struct MSUTimerFit {
+	MSUTimerComplexity complexity;	///< The best-matching model (MSUT_NCOMPLEXITIES if there was no fit).
+	double coef;		///< Its coefficient: the time is about `coef * f(n)` *microseconds* (log base 2).
+	double rms;			///< Its root-mean-square error, relative to the mean time (0.0 is a perfect fit).
+	double rms_all[MSUT_NCOMPLEXITIES];	///< The relative rms error of every model.
+} MSUTimerFit;
+
+/// @name Flags for msutimer_bench_parallel()
+/// @{
+#define MSUT_PARALLEL_PIN		0x01u	///< Pin thread `i` to CPU `i`.
+#define MSUT_PARALLEL_SCALING	0x02u	///< Run with 1, 2, ..., `nthreads` threads (scaling curve).
+/// @}
+
+/// Clock source used by msutimer_new() and MSUT_CLOCK_DEFAULT.
+/// Define it on the compiler command-line to change it, e.g. `-DMSUT_DEFAULT_CLOCK=MSUT_CLOCK_REALTIME`.
+#ifndef MSUT_DEFAULT_CLOCK
+	#define MSUT_DEFAULT_CLOCK	MSUT_CLOCK_MONOTONIC
+#endif
+
 /// @name Convenience Macros
 /// Benchmark functions (and others) return *microseconds*, so the following macros
 /// may prove handy to the caller.
@@ -53,18 +215,252 @@ typedef struct MSUTimer_ MSUTimer;
 /// @}
 
 MSUTimer *msutimer_new(void);					///< Create a new timer.
+MSUTimer *msutimer_new_ex(MSUTimerClock source);	///< Create a new timer, using the specified clock source.
+MSUTimer *msutimer_init(void *storage, size_t size, MSUTimerClock source);	///< Initialize a timer in caller-provided storage.
+void msutimer_fini(MSUTimer *timer);					///< Release the resources of a timer created by msutimer_init().
+MSUTimerPool *msutimer_pool_new(MSUTimerClock source, size_t ntimers);	///< Create a pool of preallocated timers.
+MSUTimerPool *msutimer_pool_free(MSUTimerPool *pool);	///< Destroy a pool of timers.
+MSUTimer *msutimer_pool_acquire(MSUTimerPool *pool);	///< Get a started timer from a pool (give it back with msutimer_free()).
+size_t msutimer_pool_available(MSUTimerPool *pool);	///< Get the number of free timers of a pool.
 MSUTimer *msutimer_free(MSUTimer *timer);		///< Free an existing timer.
 double msutimer_accuracy_usecs(MSUTimer *timer);///< Get *MSUTimer* accuracy.
+MSUTimerClock msutimer_clock(const MSUTimer *timer);	///< Get the clock source of a timer.
+const char *msutimer_clock_name(MSUTimerClock source);	///< Get the name of a clock source.
 double msutimer_gettime( MSUTimer *timer );		///< Get current time & update time-difference.
+uint64_t msutimer_now_ticks(const MSUTimer *timer);		///< Get current time as raw clock ticks (no conversion).
+uint64_t msutimer_default_ticks(void);					///< Get current time as raw ticks of the default clock source.
+double msutimer_ticks_to_ns(const MSUTimer *timer, uint64_t ticks);	///< Convert raw clock ticks to *nanoseconds*.
+uint64_t msutimer_ticks_per_sec(const MSUTimer *timer);	///< Get the frequency of a timer's clock source.
 double msutimer_diff_usecs(MSUTimer *timer);	///< Get updated time-difference in *microseconds*.
 double msutimer_diff_msecs(MSUTimer *timer);	///< Get updated time-difference in *milliseconds*.
 double msutimer_diff_secs(MSUTimer *timer);		///< Get updated time-difference in *seconds*.
 
+double msutimer_overhead_usecs(const MSUTimer *timer);	///< Get the cost of an empty timed region.
+bool msutimer_subtract_overhead(MSUTimer *timer, bool enable);	///< Subtract the timer overhead from bench samples.
+bool msutimer_set_warmup(MSUTimer *timer, size_t niters, double usecs);	///< Configure the warm-up of bench runs.
+												/// Configure steady-state detection at the end of warm-up.
+bool msutimer_set_steady_state(MSUTimer *timer, size_t window, double max_cv, double budget_usecs);
+size_t msutimer_warmup_iters(const MSUTimer *timer);	///< Get the warm-up iterations of the latest bench run.
+bool msutimer_perf_enable(MSUTimer *timer, bool enable);	///< Count cycles, instructions & misses in bench runs.
+bool msutimer_alloc_enable(MSUTimer *timer, bool enable);	///< Count memory allocations in bench runs.
+bool msutimer_alloc_counts(const MSUTimer *timer, MSUTimerAllocs *allocs);	///< Get the allocations of the latest bench run.
+void msutimer_alloc_note(size_t bytes);					///< Count an allocation (for custom allocators).
+void msutimer_free_note(void);							///< Count a de-allocation (for custom allocators).
+bool msutimer_env_setup(MSUTimer *timer, int cpu, unsigned flags);	///< Pin & prioritize the thread, and check the CPU frequency.
+bool msutimer_env_restore(MSUTimer *timer);				///< Undo the thread changes of msutimer_env_setup().
+bool msutimer_env(const MSUTimer *timer, MSUTimerEnv *env);	///< Get the recorded benchmark environment.
+												/// Get the hardware performance counters of the latest bench run.
+bool msutimer_perf_counters(const MSUTimer *timer, MSUTimerCounters *counters);
+
 												/// Get callback's execution time.
 double msutimer_bench(MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat);
 												/// Get callback's average execution time.
 double msutimer_bench_average(MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat);
 												/// Get callback's median execution time.
 double msutimer_bench_median(MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat);
+												/// Get callback's median execution time, recording into a caller-supplied buffer.
+double msutimer_bench_median_buf(MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat, double *samples);
+												/// Get callback's median execution time, with untimed setup & teardown calls.
+double msutimer_bench_median_fixture(MSUTimer *timer, size_t nrepeats, bool (*setup)(void *), bool (*callback)(void *), bool (*teardown)(void *), void *userdata, size_t *erepeat);
+void msutimer_pause(MSUTimer *timer);					///< Pause the timing of the current bench sample (inside callbacks).
+void msutimer_resume(MSUTimer *timer);					///< Resume the timing of the current bench sample.
+bool msutimer_reserve_samples(MSUTimer *timer, size_t nsamples);	///< Reserve a pre-faulted sample buffer in a timer.
+												/// Get callback's execution time statistics from a single run.
+bool msutimer_bench_stats(MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, MSUTimerStats *stats);
+												/// Get callback's median execution time, timing it in auto-sized batches.
+double msutimer_bench_auto(MSUTimer *timer, size_t nbatches, bool (*callback)(void *), void *userdata, size_t *erepeat, size_t *batchsize);
+												/// Get callback's average execution time, running it for a time budget.
+double msutimer_bench_for(MSUTimer *timer, double budget_usecs, bool (*callback)(void *), void *userdata, size_t *niters);
+												/// Get callback's stats over a geometric range of input sizes, and their complexity.
+bool msutimer_bench_range(MSUTimer *timer, size_t nrepeats, bool (*callback)(void *, size_t), void *userdata, size_t lo, size_t hi, double mult, size_t maxsizes, size_t *sizes, MSUTimerStats *stats, size_t *nsizes, MSUTimerFit *fit);
+												/// Fit times measured at several input sizes to complexity models.
+bool msutimer_fit_complexity(const size_t *sizes, const double *times, size_t n, MSUTimerFit *fit);
+const char *msutimer_complexity_name(MSUTimerComplexity complexity);	///< Get the name of a complexity model (e.g. "O(n log n)").
+												/// Compare 2 callbacks in interleaved, randomized rounds.
+bool msutimer_bench_compare(MSUTimer *timer, size_t nrounds, size_t nrepeats, bool (*callback_a)(void *), void *userdata_a, bool (*callback_b)(void *), void *userdata_b, MSUTimerCompare *result);
+
+/// @name Result Serialization
+/// Statistics as JSON or CSV, in the stable schema "msutimer-stats/3".
+/// @{
+												/// Serialize stats as JSON into a buffer (snprintf-like).
+int msutimer_stats_to_json(char *buf, size_t bufsize, const char *name, const MSUTimer *timer, const MSUTimerStats *stats);
+												/// Write stats as a line of JSON to a stream.
+bool msutimer_stats_write_json(FILE *fp, const char *name, const MSUTimer *timer, const MSUTimerStats *stats);
+												/// Serialize stats as a CSV record into a buffer (snprintf-like).
+int msutimer_stats_to_csv(char *buf, size_t bufsize, const char *name, const MSUTimer *timer, const MSUTimerStats *stats, bool header);
+												/// Write stats as a CSV record to a stream.
+bool msutimer_stats_write_csv(FILE *fp, const char *name, const MSUTimer *timer, const MSUTimerStats *stats, bool header);
+/// @}
+
+/// @name Inline Benchmark Loops
+/// Benchmarks without a callback-function (see MSUT_BENCH_LOOP() in msutimer_inline.h).
+/// @{
+/// The state of a MSUT_BENCH_LOOP() (internal).
+typedef struct MSUTimerLoop {
+	MSUTimer *timer;
+	MSUTimerStats *stats;
+	double *samples;	///< The samples, in ticks until the loop ends.
+	size_t nwarmup;		///< Untimed iterations before the first timed one.
+	size_t n;			///< Timed iterations.
+	size_t i;			///< Iterations started so far.
+	uint64_t t1;		///< Start of the current iteration.
+	uint64_t cpuwall[2];	///< Wall-clock & thread CPU ticks at the start of the loop.
+} MSUTimerLoop;
+
+MSUTimerLoop msutimer_loop_begin_(MSUTimer *timer, size_t nrepeats, MSUTimerStats *stats);	///< (internal) used by MSUT_BENCH_LOOP().
+void msutimer_loop_end_(MSUTimerLoop *loop);			///< (internal) used by MSUT_BENCH_LOOP().
+extern const volatile void *volatile msutimer_sink_;	///< (internal) used by msutimer_do_not_optimize().
+void msutimer_clobber_memory_(void);					///< (internal) used by msutimer_clobber_memory().
+/// @}
+
+/// @name Histograms
+/// Constant-memory, log-linear (HDR-style) histograms of *nanosecond* values.
+/// @{
+MSUTimerHist *msutimer_hist_new(double max_usecs, int sigdigits);	///< Create a new histogram.
+MSUTimerHist *msutimer_hist_free(MSUTimerHist *hist);	///< Free an existing histogram.
+bool msutimer_hist_reset(MSUTimerHist *hist);			///< Remove all recorded values from a histogram.
+bool msutimer_hist_record(MSUTimerHist *hist, double usecs);	///< Record a value in *microseconds*.
+bool msutimer_hist_record_ns(MSUTimerHist *hist, uint64_t nsecs);	///< Record a value in *nanoseconds*.
+bool msutimer_hist_record_ns_n(MSUTimerHist *hist, uint64_t nsecs, uint64_t count);	///< Record a value in *nanoseconds*, count times.
+bool msutimer_hist_merge(MSUTimerHist *dst, const MSUTimerHist *src);	///< Add all values of a histogram to another one.
+uint64_t msutimer_hist_count(const MSUTimerHist *hist);	///< Get the number of recorded values.
+double msutimer_hist_percentile(const MSUTimerHist *hist, double percentile);	///< Get a percentile in *microseconds*.
+bool msutimer_hist_stats(const MSUTimerHist *hist, MSUTimerStats *stats);	///< Get the statistics of the recorded values.
+size_t msutimer_hist_footprint(const MSUTimerHist *hist);	///< Get the memory used by a histogram, in bytes.
+												/// Record callback's execution times into a histogram.
+bool msutimer_bench_hist(MSUTimer *timer, size_t nrepeats, bool (*callback)(void *), void *userdata, size_t *erepeat, MSUTimerHist *hist);
+/// @}
+
+/// @name Per-thread Timers
+/// Lock-free per-thread recording, merged on demand.
+/// @{
+												/// Create a group of per-thread timing slots.
+MSUTimerGroup *msutimer_group_new(MSUTimerClock source, size_t nslots, double max_usecs, int sigdigits);
+MSUTimerGroup *msutimer_group_free(MSUTimerGroup *group);	///< Free an existing group.
+MSUTimerSlot *msutimer_group_join(MSUTimerGroup *group);	///< Claim a slot for the calling thread.
+void msutimer_slot_begin(MSUTimerSlot *slot);			///< Start a measurement on a slot.
+void msutimer_slot_end(MSUTimerSlot *slot);				///< End a measurement & record it on a slot.
+bool msutimer_slot_record_ns(MSUTimerSlot *slot, uint64_t nsecs);	///< Record a value in *nanoseconds* on a slot.
+MSUTimerHist *msutimer_group_hist_new(const MSUTimerGroup *group);	///< Create a histogram with a group's layout.
+bool msutimer_collect(const MSUTimerGroup *group, MSUTimerHist *hist, MSUTimerStats *stats);	///< Merge all slots of a group.
+												/// Get callback's throughput on several threads (and its scaling curve).
+bool msutimer_bench_parallel(MSUTimer *timer, size_t nthreads, size_t nrepeats, bool (*callback)(void *), void **userdata, unsigned flags, MSUTimerParallel *results, double *thread_ops_per_sec);
+/// @}
+
+/// @name Named Zones
+/// Per-call-site profiling of production code (see MSUT_ZONE_BEGIN() in msutimer_inline.h).
+/// @{
+/// (internal) The record of a named zone on a single thread, written by that thread only.
+typedef struct MSUTimerZoneSlot_ {
+	int64_t count;		///< The number of completed passes.
+	int64_t ticks;		///< The total time, in ticks of the default clock source.
+	MSUTimerHist *hist;	///< The histogram of pass times (`MSUT_ZONES` 2), or `NULL`.
+	double nsecs_per_tick;	///< Of the default clock source.
+	struct MSUTimerZoneSlot_ *next;	///< The slot of the next thread.
+	void *mem;			///< The allocated block, of which the slot is the cache-line aligned part.
+} MSUTimerZoneSlot;
+
+/// The record of a named zone: a single static one per call site.
+typedef struct MSUTimerZone_ {
+	const char *name;	///< The name of the zone.
+	const char *file;	///< The source file of the call site.
+	int line;			///< The source line of the call site.
+	int64_t count;		///< (internal) passes of threads without a slot (see msutimer_zones_dump()).
+	int64_t ticks;		///< (internal) their total time, in ticks of the default clock source.
+	int64_t state;		///< (internal) 1 once registered.
+	int64_t lock;		///< (internal) guards `slots`, and `hist`.
+	MSUTimerHist *hist;	///< (internal) the histogram of passes of threads without a slot (`MSUT_ZONES` 2).
+	MSUTimerZoneSlot *slots;	///< (internal) the slots of the threads passed through the zone.
+	struct MSUTimerZone_ *next;	///< (internal) next registered zone.
+} MSUTimerZone;
+
+void msutimer_zone_register_(MSUTimerZone *zone, int level);	///< (internal) used by MSUT_ZONE_END().
+void msutimer_zone_record_(MSUTimerZone *zone, uint64_t ticks);	///< (internal) used by MSUT_ZONE_END().
+MSUTimerZoneSlot *msutimer_zone_slot_(MSUTimerZone *zone, int level);	///< (internal) used by MSUT_ZONE_END().
+bool msutimer_zones_dump(FILE *fp);						///< Print the counts, totals & histograms of all zones.
+void msutimer_zones_reset(void);						///< Zero the counts, totals & histograms of all zones.
+/// @}
+
+/// @name Binary Sample Logs
+/// Raw samples streamed into compact, memory-mapped files.
+/// @{
+/// The header of a binary sample log (see msutimer_log_read()).
+typedef struct MSUTimerLogInfo {
+	MSUTimerClock source;	///< The clock source of the samples.
+	uint64_t freq;			///< Its frequency (ticks per second).
+	uint64_t start_ticks;	///< Its ticks when the log was created.
+	int64_t start_time;		///< The calendar time when the log was created (seconds since the Epoch).
+	uint64_t nsamples;		///< The number of samples.
+} MSUTimerLogInfo;
+
+MSUTimerLog *msutimer_log_new(const char *fname, const MSUTimer *timer);	///< Create a new binary sample log file.
+MSUTimerLog *msutimer_log_free(MSUTimerLog *log);		///< Write out, close & destroy a sample log.
+bool msutimer_attach_log(MSUTimer *timer, MSUTimerLog *log);	///< Stream a timer's bench samples into a log.
+												/// Read a sample log, one sample at a time.
+bool msutimer_log_read(const char *fname, MSUTimerLogInfo *info, bool (*callback)(void *, uint64_t), void *userdata);
+/// @}
+
+/// @name Event Trace
+/// A timeline of zone passes, in per-thread ring buffers, exported as Chrome Trace Event JSON.
+/// @{
+extern int64_t msutimer_tracing_;						///< (internal) non-zero while tracing.
+bool msutimer_trace_start(const char *fname, size_t nthreads, size_t capacity);	///< Start recording a trace file.
+bool msutimer_trace_event(const char *name, uint64_t start, uint64_t ticks);	///< Record an event (wait-free).
+bool msutimer_trace_stop(uint64_t *dropped);			///< Stop recording & close the trace file.
+/// @}
+
+/// @name Spans
+/// Elapsed & active time of a logical operation, across suspension points and threads.
+/// @{
+/// A timed span (see msutimer_span_begin()). It may be placed anywhere, e.g. in
+/// the state of a request or of a coroutine.
+typedef struct MSUTimerSpan {
+	const MSUTimer *timer;	///< (internal) the clock source & its conversion factors.
+	uint64_t start;			///< (internal) ticks of msutimer_span_begin().
+	uint64_t t1;			///< (internal) active-time ticks of the latest resume.
+	uint64_t active;		///< (internal) active-time ticks of the completed segments.
+	uint64_t end;			///< (internal) ticks of msutimer_span_end(), 0 while open.
+	double cpu_usecs_per_tick;	///< (internal) of the thread CPU clock (0.0 if none, see msutimer_span_begin()).
+	size_t nsuspends;		///< The number of suspensions so far.
+	bool suspended;			///< `true` while suspended.
+} MSUTimerSpan;
+
+bool msutimer_span_begin(MSUTimerSpan *span, const MSUTimer *timer);	///< Start a span (active).
+void msutimer_span_suspend(MSUTimerSpan *span);			///< Suspend a span (e.g. before awaiting).
+void msutimer_span_resume(MSUTimerSpan *span);			///< Resume a span, on any thread.
+												/// End a span, recording its elapsed & active times into histograms.
+bool msutimer_span_end(MSUTimerSpan *span, MSUTimerHist *total, MSUTimerHist *active);
+double msutimer_span_total_usecs(const MSUTimerSpan *span);	///< Get the elapsed time of a span.
+double msutimer_span_active_usecs(const MSUTimerSpan *span);	///< Get the active time of a span.
+/// @}
+
+/// @name Sampled Timing
+/// Timing 1 call in N, for code paths too hot to time every call (see msutimer_sample_begin() in msutimer_inline.h).
+/// @{
+#define MSUT_SAMPLE_RANDOM		0x01u	///< Randomize the gaps between the timed calls (instead of a fixed period).
+
+/// The state of a sampler (see msutimer_sampler_init()). It is not synchronized: use one per thread.
+typedef struct MSUTimerSampler {
+	uint64_t countdown;		///< (internal) calls left until the next timed one (0: timing one).
+	uint64_t t1;			///< (internal) start ticks of the timed call.
+	uint64_t period;		///< The current period: on average, 1 call in `period` is timed.
+	uint64_t calls;			///< The estimated number of calls (each timed one counts as `period` calls).
+	uint64_t nsampled;		///< The number of timed calls.
+	double usecs;			///< The estimated total time of all calls, in *microseconds*.
+	MSUTimerHist *hist;		///< If non-`NULL`, the histogram of the timed calls (each one counted `period` times).
+	uint64_t rng;			///< (internal) xorshift state, 0 for a fixed period.
+	double nsecs_per_tick;	///< (internal) of the default clock source.
+	double overhead_ticks;	///< (internal) cost of timing a call.
+	double max_overhead;	///< (internal) target overhead fraction, 0.0 for a constant period.
+	uint64_t win_n;			///< (internal) timed calls in the adaptation window.
+	double win_ticks;		///< (internal) their total ticks.
+} MSUTimerSampler;
+
+												/// Initialize a sampler, timing 1 call in period (adapted to max_overhead_pct).
+bool msutimer_sampler_init(MSUTimerSampler *sampler, uint64_t period, double max_overhead_pct, unsigned flags, MSUTimerHist *hist);
+void msutimer_sampler_record_(MSUTimerSampler *sampler, uint64_t ticks);	///< (internal) used by msutimer_sample_end().
+bool msutimer_sampler_stats(const MSUTimerSampler *sampler, MSUTimerStats *stats);	///< Get the (scaled) statistics of a sampler.
+bool msutimer_sampler_reset(MSUTimerSampler *sampler);	///< Zero the counts of a sampler (keeping its period).
+/// @}
 
 #endif					/* end of inclusion guard */
@@ -0,0 +1,489 @@
+/*
+Zlib License
+--------------------------------------------------
+Copyright (c) 2021 migf1@hotmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+--------------------------------------------------
+*/
+/**
+ * @file	msutimer_inline.h
+ * @version	0.01 alpha
+ * @date	19 June, 2021
+ * @author 	migf1 <mig_f1@hotmail.com>
+ * @par Language:
+ *		ISO C99
+ * @par License
+ *		This project is released under the zlib license (see LICENSE.txt)
+ *
+ * @brief Simple High Resolution Timer for C (header-only fast path).
+ *
+ * Inline variants of the timestamp primitives, for instrumenting tight loops.
+ * They read the compile-time default clock source (MSUT_DEFAULT_CLOCK) directly,
+ * so with optimizations enabled each call compiles down to a single clock read:
+ * no out-of-line call, no timer argument to validate, and no `errno` traffic.
+ *
+ * The returned ticks are the same as those of msutimer_now_ticks() on a timer
+ * created with msutimer_new(), so they can be converted with msutimer_ticks_to_ns()
+ * (the library must be compiled with the same `MSUT_DEFAULT_CLOCK`).
+ *
+ * @remarks
+ *		On POSIX, `clock_gettime()` is declared only when `_POSIX_C_SOURCE` is
+ *		at least `199309L` (or in the compiler's default GNU mode), so with
+ *		`-std=c99` the including file must be compiled with
+ *		`-D_POSIX_C_SOURCE=199309L` (or define it before any include);
+ *		otherwise the header stops with an error.
+ *
+ * The file also provides a benchmark loop whose body is inlined, instead of
+ * being called through a function pointer (MSUT_BENCH_LOOP()), named zones
+ * (MSUT_ZONE_BEGIN() / MSUT_ZONE_END()), for leaving timing in production code
+ * paths permanently, and sampled timing (msutimer_sample_begin() /
+ * msutimer_sample_end()) for the hottest ones.
+ *
+ * @par Sample Usage
+ * @code
+		#include "msutimer_inline.h"
+		...
+		MSUTimer *timer = msutimer_new();	// if ( !timer ) { handle error here }
+		uint64_t ticks = 0;
+		for (size_t i=0; i < n; i++) {
+			uint64_t start = msutimer_inline_start();
+			parse( items[i] );
+			ticks += msutimer_inline_stop( start );
+		}
+		printf( "Parsing: %.3f nsecs\n", msutimer_ticks_to_ns(timer, ticks) );
+ * @endcode
+ */
+
+#ifndef MSUTIMER_INLINE_H	/* start of inclusion guard */
+#define MSUTIMER_INLINE_H
+
+#include "msutimer.h"
+
+#include <time.h>		// clock(), timespec, clock_gettime(), etc
+
+// platform clock APIs (same detection as in msutimer.c)
+#if defined(__WIN32) || defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>	// for QueryPerformanceCounter(), GetSystemTimeAsFileTime()
+	#define MSUT_INLINE_WINDOWS 1
+
+#elif defined(__APPLE__) && defined(__MACH__)
+	#include <sys/time.h>	// for gettimeofday()
+	#include <mach/mach_time.h>	// for mach_absolute_time()
+	#define MSUT_INLINE_APPLE 1
+
+#elif (defined(__unix__) || defined (__linux__)) && defined(CLOCK_MONOTONIC)
+	#include <sys/time.h>	// for gettimeofday()
+	#define MSUT_INLINE_POSIX 1
+
+#elif defined(__unix__) || defined (__linux__)
+	#error "msutimer_inline.h needs clock_gettime(): compile with -D_POSIX_C_SOURCE=199309L (or define it before any include)"
+
+#endif
+
+// CPU cycle-counter, when MSUT_DEFAULT_CLOCK is MSUT_CLOCK_TSC (same fences as in msutimer.c)
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+	#include <x86intrin.h>	// for __rdtscp(), _mm_lfence()
+	#define MSUT_INLINE_TSC_X86 1
+#elif (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER)
+	#include <intrin.h>		// for __rdtscp(), _mm_lfence()
+	#define MSUT_INLINE_TSC_X86 1
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+	#define MSUT_INLINE_TSC_ARM64 1
+#endif
+
+/// Get the current time as raw ticks of the default clock source (inline).
+/// @return The current tick count (0 if the clock cannot be read).
+static inline uint64_t msutimer_inline_now_ticks( void )
+{
+	// MSUT_DEFAULT_CLOCK is a constant, so all but one branch get compiled out
+	if ( MSUT_CLOCK_TSC == MSUT_DEFAULT_CLOCK ) {
+#if MSUT_INLINE_TSC_X86
+		unsigned int aux;
+		uint64_t t = __rdtscp( &aux );
+		_mm_lfence();
+		return t;
+#elif MSUT_INLINE_TSC_ARM64
+		uint64_t t;
+		__asm__ __volatile__( "isb\n\tmrs %0, cntvct_el0" : "=r"(t) :: "memory" );
+		return t;
+#else
+		return msutimer_default_ticks();
+#endif
+	}
+	// CPU time, in the same units as msutimer.c
+	if ( MSUT_CLOCK_PROCESS_CPU == MSUT_DEFAULT_CLOCK || MSUT_CLOCK_THREAD_CPU == MSUT_DEFAULT_CLOCK ) {
+#if MSUT_INLINE_WINDOWS
+		// kernel + user time, in 100-nanosecond intervals
+		FILETIME created, ended, kernel, user;
+		BOOL ok = (MSUT_CLOCK_PROCESS_CPU == MSUT_DEFAULT_CLOCK)
+			? GetProcessTimes( GetCurrentProcess(), &created, &ended, &kernel, &user )
+			: GetThreadTimes( GetCurrentThread(), &created, &ended, &kernel, &user );
+		if ( !ok ) {
+			return 0;
+		}
+		return (((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime)
+			+ (((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime);
+#elif defined(CLOCK_PROCESS_CPUTIME_ID) && defined(CLOCK_THREAD_CPUTIME_ID)
+		// nanoseconds
+		struct timespec ts;
+		if ( -1 == clock_gettime( MSUT_CLOCK_PROCESS_CPU == MSUT_DEFAULT_CLOCK ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID, &ts ) ) {
+			return 0;
+		}
+		return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#else
+		return msutimer_default_ticks();
+#endif
+	}
+#if MSUT_INLINE_WINDOWS
+	if ( MSUT_CLOCK_REALTIME == MSUT_DEFAULT_CLOCK ) {
+		FILETIME ft;
+		GetSystemTimeAsFileTime( &ft );
+		return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+	}
+	if ( MSUT_CLOCK_PORTABLE != MSUT_DEFAULT_CLOCK ) {
+		LARGE_INTEGER li;
+		QueryPerformanceCounter( &li );
+		return (uint64_t) li.QuadPart;
+	}
+
+#elif MSUT_INLINE_APPLE
+	if ( MSUT_CLOCK_REALTIME == MSUT_DEFAULT_CLOCK ) {
+		struct timeval tv;
+		gettimeofday( &tv, NULL );
+		return (uint64_t)tv.tv_sec * 1000000u + (uint64_t)tv.tv_usec;
+	}
+	if ( MSUT_CLOCK_PORTABLE != MSUT_DEFAULT_CLOCK ) {
+		return mach_absolute_time();
+	}
+
+#elif MSUT_INLINE_POSIX
+	if ( MSUT_CLOCK_REALTIME == MSUT_DEFAULT_CLOCK ) {
+		struct timeval tv;
+		gettimeofday( &tv, NULL );
+		return (uint64_t)tv.tv_sec * 1000000u + (uint64_t)tv.tv_usec;
+	}
+	if ( MSUT_CLOCK_PORTABLE != MSUT_DEFAULT_CLOCK ) {
+		struct timespec ts;
+	#ifdef CLOCK_MONOTONIC_RAW
+		clock_gettime( MSUT_CLOCK_MONOTONIC_RAW == MSUT_DEFAULT_CLOCK ? CLOCK_MONOTONIC_RAW : CLOCK_MONOTONIC, &ts );
+	#else
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+	#endif
+		return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+	}
+
+#endif
+	// MSUT_CLOCK_PORTABLE, or unknown platform
+	return (uint64_t) clock();
+}
+
+/// Start a measurement (inline).
+/// @return The starting tick count, to be passed to msutimer_inline_stop().
+static inline uint64_t msutimer_inline_start( void )
+{
+	return msutimer_inline_now_ticks();
+}
+
+/// Stop a measurement (inline).
+/// @param start The tick count returned by msutimer_inline_start().
+/// @return The elapsed ticks, convertible with msutimer_ticks_to_ns().
+static inline uint64_t msutimer_inline_stop( uint64_t start )
+{
+	return msutimer_inline_now_ticks() - start;
+}
+
+/* ----------------------------------
+ * Inline Benchmark Loops
+ * ----------------------------------
+ */
+
+/**
+ * @def msutimer_do_not_optimize(x)
+ * Keeps the compiler from optimizing away the computation of `x`, as if its
+ * value were read by code the compiler cannot see.
+ *
+ * Use it on the results of a MSUT_BENCH_LOOP() body, so the body is not
+ * eliminated as dead code. It costs no instruction itself, but `x` has to be
+ * materialized in a register or in memory.
+ *
+ * @param x
+ *		An expression (an lvalue, for portability to compilers without GNU
+ *		inline assembly, e.g. MSVC).
+ */
+/**
+ * @def msutimer_clobber_memory()
+ * Keeps the compiler from reordering or eliminating memory accesses across it,
+ * as if all memory were read and written at that point (e.g. so that stores of
+ * a MSUT_BENCH_LOOP() body are not optimized away). It costs no instruction.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+	#define msutimer_do_not_optimize( x )	__asm__ __volatile__( "" : : "g"(x) : "memory" )
+	#define msutimer_clobber_memory()		__asm__ __volatile__( "" : : : "memory" )
+#elif defined(_MSC_VER)
+	#define msutimer_do_not_optimize( x )	( msutimer_sink_ = (const volatile void *)&(x), _ReadWriteBarrier() )
+	#define msutimer_clobber_memory()		_ReadWriteBarrier()
+#else
+	// an opaque call, unless the whole program is optimized at link-time
+	#define msutimer_do_not_optimize( x )	( msutimer_sink_ = (const volatile void *)&(x), msutimer_clobber_memory_() )
+	#define msutimer_clobber_memory()		msutimer_clobber_memory_()
+#endif
+
+/// (internal) End the previous iteration of a MSUT_BENCH_LOOP(), and start a new one.
+static inline bool msutimer_loop_next_( MSUTimerLoop *loop )
+{
+	uint64_t now = msutimer_inline_now_ticks();
+	if ( loop->i > loop->nwarmup ) {
+		loop->samples[ loop->i - loop->nwarmup - 1 ] = (double)(now - loop->t1);
+	}
+	if ( loop->i == loop->nwarmup + loop->n ) {
+		msutimer_loop_end_( loop );
+		return false;
+	}
+	loop->i++;
+	loop->t1 = msutimer_inline_now_ticks();
+	return true;
+}
+
+/**
+ * @def MSUT_BENCH_LOOP(timer, n, stats)
+ * Benchmarks the statement (or block) that follows it, as msutimer_bench_stats()
+ * does with a callback-function, but without calling it through a function
+ * pointer.
+ *
+ * The body is timed separately on each of `n` iterations, and when the loop
+ * ends the statistics of the samples are stored into `*stats`. The body is
+ * compiled inline, so small kernels are measured without the cost of an
+ * indirect call, and they can be optimized in context: use
+ * msutimer_do_not_optimize() and msutimer_clobber_memory() to keep their work
+ * from being optimized away.
+ *
+ * @param timer
+ *		An already created timer, using the default clock source (e.g. created
+ *		with msutimer_new()).
+ * @param n
+ *		The number of timed iterations.
+ * @param stats
+ *		A pointer to a MSUTimerStats, filled in when the loop ends.
+ * @remarks
+ *		The clock is read inline (as msutimer_inline_now_ticks() does). The
+ *		samples are recorded like those of msutimer_bench_stats(): into the
+ *		timer's reserved buffer (see msutimer_reserve_samples()) if it is large
+ *		enough, with overhead subtraction if enabled, and into the attached
+ *		sample log if any. The iterations count of the warm-up is applied (see
+ *		msutimer_set_warmup()), but not its time, nor steady-state detection.
+ *		The whole loop (warm-up iterations included) is also timed on the
+ *		wall-clock and on the CPU time of the calling thread, as in
+ *		msutimer_bench_stats() (`stats->cpu_ratio`).
+ *
+ *		`continue` in the body moves to the next iteration, but the loop must
+ *		end normally: leaving it with `break`, `return` or `goto` skips the
+ *		statistics and may leak the sample buffer. On errors (e.g. `timer` or
+ *		`stats` is `NULL`, `n` is 0, or the buffer cannot be allocated) the body
+ *		is not executed, `errno` is set, and `stats` (if any) is zeroed.
+ *
+ * @par Sample Usage
+ * @code
+		MSUTimerStats stats;
+		MSUT_BENCH_LOOP( timer, 100000, &stats ) {
+			uint64_t h = hash( key, keylen );
+			msutimer_do_not_optimize( h );
+		}
+		printf( "median: %.3f usecs\n", stats.median );
+ * @endcode
+ */
+#define MSUT_BENCH_LOOP( timer, n, stats )										\
+	for ( MSUTimerLoop msut_loop_ = msutimer_loop_begin_( (timer), (n), (stats) );	\
+		msutimer_loop_next_( &msut_loop_ ); )
+
+/* ----------------------------------
+ * Named Zones
+ * ----------------------------------
+ */
+
+/**
+ * @def MSUT_ZONE_BEGIN(name)
+ * Opens a named zone, timed until the matching MSUT_ZONE_END().
+ *
+ * Zones are compiled in only when `MSUT_ZONES` is defined to a positive value
+ * (e.g. `-DMSUT_ZONES=1`); otherwise the macros expand to a plain block.
+ * - `MSUT_ZONES=1` records the number of passes and their total time, at the
+ *   cost of 2 raw clock reads and 2 plain additions per pass.
+ * - `MSUT_ZONES=2` also records each pass into a histogram, with a call to
+ *   msutimer_hist_record_ns().
+ *
+ * Each call site gets its own static MSUTimerZone, registered on its first
+ * completed pass, and each thread passing through it gets its own slot in it
+ * (found through a thread-local pointer of the call site), so threads never
+ * contend on a zone. msutimer_zones_dump() adds the slots up and prints all
+ * the zones. While a trace is running (see msutimer_trace_start()), each pass
+ * is also recorded as an event.
+ *
+ * @param name
+ *		The name of the zone (a string literal).
+ * @remarks
+ *		The 2 macros open and close a C block, so they must be paired in the
+ *		same scope, and leaving the block early (`return`, `break`, `goto`)
+ *		skips the recording. Zones may be nested (the inner zone shadows the
+ *		variables of the outer one, which some compilers warn about). With
+ *		compilers that lack thread-local storage, all the threads record into
+ *		the zone itself, with atomic additions (and the histogram under a
+ *		per-zone spin lock).
+ *
+ * @par Sample Usage
+ * @code
+		MSUT_ZONE_BEGIN( "parse" );
+		parse( input );
+		MSUT_ZONE_END();
+		...
+		msutimer_zones_dump( stdout );
+ * @endcode
+ */
+/**
+ * @def MSUT_ZONE_END()
+ * Closes the zone opened by the matching MSUT_ZONE_BEGIN(), and records it.
+ */
+#if defined(MSUT_ZONES) && MSUT_ZONES > 0
+
+	#if defined(__GNUC__) || defined(__clang__)
+		#define MSUT_INLINE_ATOMIC_ADD_( p, v )	((void)__atomic_fetch_add( (p), (v), __ATOMIC_RELAXED ))
+		#define MSUT_INLINE_ATOMIC_LOAD_( p )	__atomic_load_n( (p), __ATOMIC_ACQUIRE )
+		#define MSUT_INLINE_RELAXED_LOAD_( p )	__atomic_load_n( (p), __ATOMIC_RELAXED )
+		// not atomic: a single writer, whose stores must not be torn for the readers
+		#define MSUT_INLINE_LOCAL_ADD_( p, v )	__atomic_store_n( (p), __atomic_load_n( (p), __ATOMIC_RELAXED ) + (v), __ATOMIC_RELAXED )
+		#define MSUT_INLINE_THREAD_LOCAL_		__thread
+	#elif defined(_MSC_VER)
+		#define MSUT_INLINE_ATOMIC_ADD_( p, v )	((void)_InterlockedExchangeAdd64( (volatile __int64 *)(p), (v) ))
+		#define MSUT_INLINE_ATOMIC_LOAD_( p )	(*(volatile int64_t *)(p))
+		#define MSUT_INLINE_RELAXED_LOAD_( p )	(*(volatile int64_t *)(p))
+		#define MSUT_INLINE_LOCAL_ADD_( p, v )	(*(volatile int64_t *)(p) += (v))
+		#define MSUT_INLINE_THREAD_LOCAL_		__declspec(thread)
+	#else
+		#define MSUT_INLINE_ATOMIC_ADD_( p, v )	((void)(*(p) += (v)))
+		#define MSUT_INLINE_ATOMIC_LOAD_( p )	(*(volatile int64_t *)(p))
+		#define MSUT_INLINE_RELAXED_LOAD_( p )	(*(volatile int64_t *)(p))
+	#endif
+
+/// (internal) Record a pass through a zone, into the slot of the calling thread (if any).
+static inline void msutimer_zone_end_( MSUTimerZone *zone, MSUTimerZoneSlot **slotp, uint64_t start, int level )
+{
+	uint64_t ticks = msutimer_inline_now_ticks() - start;
+	MSUTimerZoneSlot *slot = slotp ? *slotp : NULL;
+	if ( slotp && !slot ) {
+		slot = *slotp = msutimer_zone_slot_( zone, level );	// first pass of the thread
+	}
+	if ( slot ) {
+	#ifdef MSUT_INLINE_LOCAL_ADD_
+		MSUT_INLINE_LOCAL_ADD_( &slot->count, 1 );
+		MSUT_INLINE_LOCAL_ADD_( &slot->ticks, (int64_t)ticks );
+	#endif
+		if ( level >= 2 && slot->hist ) {
+			msutimer_hist_record_ns( slot->hist, (uint64_t)((double)ticks * slot->nsecs_per_tick + 0.5) );
+		}
+	}
+	else {
+		if ( 0 == MSUT_INLINE_ATOMIC_LOAD_(&zone->state) ) {
+			msutimer_zone_register_( zone, level );
+		}
+		MSUT_INLINE_ATOMIC_ADD_( &zone->count, 1 );
+		MSUT_INLINE_ATOMIC_ADD_( &zone->ticks, (int64_t)ticks );
+		if ( level >= 2 ) {
+			msutimer_zone_record_( zone, ticks );
+		}
+	}
+	if ( MSUT_INLINE_RELAXED_LOAD_(&msutimer_tracing_) ) {
+		msutimer_trace_event( zone->name, start, ticks );
+	}
+}
+
+	#ifdef MSUT_INLINE_THREAD_LOCAL_
+		#define MSUT_ZONE_SLOT_DECL_()	static MSUT_INLINE_THREAD_LOCAL_ MSUTimerZoneSlot *msut_zone_slot_ = NULL;
+		#define MSUT_ZONE_SLOT_			&msut_zone_slot_
+	#else
+		#define MSUT_ZONE_SLOT_DECL_()
+		#define MSUT_ZONE_SLOT_			NULL
+	#endif
+
+	#define MSUT_ZONE_BEGIN( name )												\
+		{																		\
+			static MSUTimerZone msut_zone_ = { (name), __FILE__, __LINE__, 0, 0, 0, 0, NULL, NULL, NULL };	\
+			MSUT_ZONE_SLOT_DECL_()												\
+			const uint64_t msut_zone_start_ = msutimer_inline_now_ticks()
+
+	#define MSUT_ZONE_END()														\
+			msutimer_zone_end_( &msut_zone_, MSUT_ZONE_SLOT_, msut_zone_start_, MSUT_ZONES );	\
+		}
+
+#else
+	#define MSUT_ZONE_BEGIN( name )		{ (void)0
+	#define MSUT_ZONE_END()				}
+#endif
+
+/* ----------------------------------
+ * Sampled Timing
+ * ----------------------------------
+ */
+
+/**
+ * Starts a call instrumented with a sampler (see msutimer_sampler_init()):
+ * only 1 call in `sampler->period` (on average) reads the clock, all the others
+ * cost a decrement and a branch.
+ *
+ * @param sampler
+ *		The sampler of the calling thread.
+ * @remarks
+ *		Every call must be closed with msutimer_sample_end(). A call left open
+ *		(e.g. by an early return) only loses its sample.
+ *
+ * @par Sample Usage
+ * @code
+		MSUTimerSampler sampler;	// one per thread
+		msutimer_sampler_init( &sampler, 1000, 1.0, MSUT_SAMPLE_RANDOM, NULL );
+		...
+		msutimer_sample_begin( &sampler );
+		lookup( key );
+		msutimer_sample_end( &sampler );
+ * @endcode
+ */
+static inline void msutimer_sample_begin( MSUTimerSampler *sampler )
+{
+	if ( sampler->countdown > 1 ) {
+		sampler->countdown--;
+		return;
+	}
+	sampler->countdown = 0;
+	sampler->t1 = msutimer_inline_now_ticks();
+}
+
+/**
+ * Ends a call started with msutimer_sample_begin(), recording it if it was
+ * timed.
+ *
+ * @param sampler
+ *		The sampler of the calling thread.
+ */
+static inline void msutimer_sample_end( MSUTimerSampler *sampler )
+{
+	if ( 0 == sampler->countdown ) {
+		msutimer_sampler_record_( sampler, msutimer_inline_now_ticks() - sampler->t1 );
+	}
+}
+
+#endif					/* end of inclusion guard */
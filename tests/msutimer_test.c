@@ -0,0 +1,199 @@
+/*
+Zlib License
+--------------------------------------------------
+Copyright (c) 2021 migf1@hotmail.com
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+--------------------------------------------------
+*/
+
+/* ==================================
+ * Regression tests of MSUTimer
+ * ==================================
+ */
+// Checks behaviors that are easy to break and hard to notice in the numbers.
+// Prints a line per failed check, and exits with EXIT_FAILURE if any failed.
+//
+// The library is included rather than linked, so that its internal helpers
+// can be checked too.
+//
+// Build & run (from the root of the repository):
+// gcc -std=c99 -O2 -Wall -Wextra -I. tests/msutimer_test.c -o msutimer_test -pthread -lm
+// ./msutimer_test
+//
+// On Windows (MinGW): the same, without -pthread.
+
+#include "msutimer.c"
+
+static int nfailed_ = 0;
+
+#define CHECK_( cond )												\
+	do {															\
+		if ( !(cond) ) {											\
+			printf( "FAILED: %s:%d: %s\n", __FILE__, __LINE__, #cond );	\
+			nfailed_++;												\
+		}															\
+	} while (0)
+
+// ----------------------------------------
+// Busy-wait for usecs microseconds
+//
+static void spin_( double usecs )
+{
+	MSUTimer *t = msutimer_new();
+	double t1 = msutimer_gettime( t );
+	while ( msutimer_gettime(t) - t1 < usecs ) {
+		;
+	}
+	msutimer_free( t );
+}
+
+// ----------------------------------------
+static bool spin_long_( void *userdata )
+{
+	(void)userdata;
+	spin_( 2000.0 );
+	return true;
+}
+
+static bool spin_short_( void *userdata )
+{
+	(void)userdata;
+	spin_( 200.0 );
+	return true;
+}
+
+// ----------------------------------------
+// Pauses made during the warm-up (here by the setup & teardown of a fixture)
+// must not be subtracted from the first timed sample.
+//
+static void test_pause_warmup_( void )
+{
+	MSUTimer *timer = msutimer_new();
+	CHECK_( NULL != timer );
+	if ( !timer ) {
+		return;
+	}
+	msutimer_set_warmup( timer, 20, 0.0 );
+
+	double first = msutimer_bench_median_fixture( timer, 1, spin_long_, spin_short_, spin_long_, NULL, NULL );
+	CHECK_( first > 100.0 );
+
+	msutimer_free( timer );
+}
+
+// ----------------------------------------
+// Nearest-rank percentiles of the values 1..n are exact ranks, including when
+// p * n is an integer that doubles cannot represent exactly (e.g. 0.999 * 1000).
+//
+static void test_percentiles_( void )
+{
+	static const size_t sizes[] = { 1000, 2000 };
+
+	for (size_t s=0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		size_t n = sizes[s];
+		double *arr = malloc( n * sizeof(double) );
+		CHECK_( NULL != arr );
+		if ( !arr ) {
+			return;
+		}
+		Welford_ w;
+		welford_reset_( &w );
+		for (size_t i=0; i < n; i++) {
+			arr[i] = (double)(n - i);	// reversed, so that selection has work to do
+			welford_add_( &w, arr[i] );
+		}
+
+		MSUTimerStats stats;
+		memset( &stats, 0, sizeof(stats) );
+		finish_stats_( &stats, &w, arr );
+		CHECK_( stats.p90 == (double)(n * 900 / 1000) );
+		CHECK_( stats.p99 == (double)(n * 990 / 1000) );
+		CHECK_( stats.p999 == (double)(n * 999 / 1000) );
+
+		CHECK_( percentile_rank_(n, 99.9) == n * 999 / 1000 - 1 );
+		CHECK_( percentile_rank_(n, 100.0) == n - 1 );
+		CHECK_( percentile_rank_(n, 0.0) == 0 );
+		free( arr );
+	}
+}
+
+#if defined(__linux__)
+// ----------------------------------------
+// Re-pinning a set up thread keeps its raised priority, a failed re-pinning
+// changes nothing, and the restore returns to the affinity before the first
+// pinning.
+//
+static void test_env_repin_( void )
+{
+	cpu_set_t orig, cur;
+	if ( 0 != sched_getaffinity(0, sizeof(orig), &orig) ) {
+		return;
+	}
+	int cpu = 0;
+	while ( cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &orig) ) {
+		cpu++;
+	}
+	MSUTimer *timer = msutimer_new();
+	CHECK_( NULL != timer );
+	if ( !timer || CPU_SETSIZE == cpu ) {
+		msutimer_free( timer );
+		return;
+	}
+
+	MSUTimerEnv env;
+	CHECK_( msutimer_env_setup(timer, cpu, MSUT_ENV_PIN | MSUT_ENV_PRIORITY) );
+	msutimer_env( timer, &env );
+	bool raised = env.priority;
+
+	CHECK_( msutimer_env_setup(timer, cpu, MSUT_ENV_PIN) );
+	msutimer_env( timer, &env );
+	CHECK_( env.cpu == cpu && env.priority == raised );
+	if ( raised ) {
+		CHECK_( getpriority(PRIO_PROCESS, 0) <= MSUT_ENV_NICE );
+	}
+
+	CHECK_( !msutimer_env_setup(timer, CPU_SETSIZE, MSUT_ENV_PIN) );
+	msutimer_env( timer, &env );
+	CHECK_( env.active && env.cpu == cpu && env.priority == raised );
+	CHECK_( 0 == sched_getaffinity(0, sizeof(cur), &cur) );
+	CHECK_( 1 == CPU_COUNT(&cur) && CPU_ISSET(cpu, &cur) );
+
+	CHECK_( msutimer_env_restore(timer) );
+	CHECK_( 0 == sched_getaffinity(0, sizeof(cur), &cur) );
+	CHECK_( CPU_EQUAL(&cur, &orig) );
+
+	msutimer_free( timer );
+}
+#endif
+
+// ----------------------------------------
+int main( void )
+{
+	test_pause_warmup_();
+	test_percentiles_();
+#if defined(__linux__)
+	test_env_repin_();
+#endif
+
+	if ( nfailed_ ) {
+		printf( "%d check(s) FAILED\n", nfailed_ );
+		return EXIT_FAILURE;
+	}
+	puts( "All checks passed" );
+	return EXIT_SUCCESS;
+}